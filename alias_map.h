@@ -47,7 +47,7 @@ class alias_map
     typedef std::list<KeyType> aliases_container;
     typedef std::pair<ObjType, aliases_container> obj_wrapper;
     typedef std::list<obj_wrapper> obj_container;
-    typedef std::map<KeyType, obj_wrapper*> obj_mapping;
+    typedef std::map<KeyType, typename obj_container::iterator> obj_mapping;
 
 
 public:
@@ -104,7 +104,7 @@ public:
         w.second.push_back(key);
         typename obj_container::iterator o;
         o = objects.insert(objects.begin(), w); // copy object
-        mapping.insert(std::make_pair(key, &(*o)));
+        mapping.insert(std::make_pair(key, o));
     }
 
     /**
@@ -122,8 +122,8 @@ public:
     {
         throw_if_not_found(key, __FUNCTION__);
 
-        obj_wrapper* w = mapping[key];
-        aliases_container& aliases = w->second;
+        typename obj_container::iterator o = mapping[key];
+        aliases_container& aliases = o->second;
 
         // remove all aliases from mapping
         typename aliases_container::iterator i;
@@ -133,15 +133,7 @@ public:
         }
 
         // remove the wrapper object itself
-        typename obj_container::iterator o;
-        for(o = objects.begin(); o != objects.end(); i++)
-        {
-            if(&(*o) == w)
-            {
-                objects.erase(o);
-                break;
-            }
-        }
+        objects.erase(o);
     }
 
     /**
@@ -189,9 +181,9 @@ public:
         throw_if_not_found(existing_key, __FUNCTION__);
         throw_if_found(new_alias, __FUNCTION__);
 
-        obj_wrapper* w = mapping[existing_key];
-        w->second.push_back(new_alias);
-        mapping.insert(std::make_pair(new_alias, w));
+        typename obj_container::iterator o = mapping[existing_key];
+        o->second.push_back(new_alias);
+        mapping.insert(std::make_pair(new_alias, o));
     }
 
     /**
@@ -259,37 +251,17 @@ public:
         typename obj_mapping::iterator m = mapping.find(alias_or_key);
         if(m != mapping.end())
         {
-            typename obj_container::iterator o;
-            for (o = objects.begin(); o != objects.end(); o++)
-            {
-                obj_wrapper* obj_ptr = &(*o);
-                obj_wrapper* mapping_ptr = m->second;
-
-                if(obj_ptr == mapping_ptr)
-                {
-                    return iterator(o); // make conversion here..
-                }
-            }
+            return iterator(m->second); // make conversion here..
         }
         return end();
     }
 
     const_iterator find(const KeyType& alias_or_key) const
     {
-        typename obj_mapping::iterator m = mapping.find(alias_or_key);
+        typename obj_mapping::const_iterator m = mapping.find(alias_or_key);
         if(m != mapping.end())
         {
-            typename obj_container::iterator o;
-            for (o = objects.begin(); o != objects.end(); o++)
-            {
-                obj_wrapper* obj_ptr = &(*o);
-                obj_wrapper* mapping_ptr = m->second;
-
-                if(obj_ptr == mapping_ptr)
-                {
-                    return iterator(o); // make conversion here..
-                }
-            }
+            return iterator(m->second); // make conversion here..
         }
         return end();
     }
@@ -0,0 +1,283 @@
+/**
+ * @file   blob_decode.h
+ * @date   17 Oct 2026
+ * @brief  Decoding of binary data specified on the command line as hex or base64. Characters
+ *         are validated while they are decoded, 16 at a time if SSE2 is available.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BLOB_DECODE_H_
+#define BLOB_DECODE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOB_DECODE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Returned by decoding functions if all characters were valid.
+ */
+static const size_t blob_decode_ok = static_cast<size_t>(-1);
+
+/**
+ * @brief Hex encoding (two characters, either lower or upper case, per byte).
+ */
+struct hex_encoding
+{
+    static const char* usage()
+    {
+        return "<hex>";
+    }
+
+    /**
+     * @brief Returns number of bytes that the encoded data of the specified size decodes to
+     *        (at most).
+     */
+    static size_t max_decoded_size(size_t size)
+    {
+        return size / 2;
+    }
+
+    /**
+     * @brief Decodes (and validates) the data.
+     * @param in, size - encoded data.
+     * @param out - buffer for the result (of at least max_decoded_size(size) bytes).
+     * @param decoded - number of bytes decoded.
+     * @return blob_decode_ok, or offset of the first invalid character (size, if the data
+     *         is truncated, i.e. the number of characters is odd).
+     */
+    static size_t decode(const char* in, size_t size, uint8_t* out, size_t& decoded)
+    {
+        size_t at = 0;
+        decoded = 0;
+#ifdef BLOB_DECODE_USE_SSE2
+        for (; at + 16 <= size; at += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + at));
+            __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                          _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+            __m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20)); // to lower case
+            __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                                          _mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1)));
+            if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xffff)
+            {
+                break; // the scalar loop will find it
+            }
+            __m128i val = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+                                       _mm_and_si128(alpha, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))));
+
+            // each pair of characters (16-bit lane) into a byte
+            __m128i high = _mm_slli_epi16(_mm_and_si128(val, _mm_set1_epi16(0x00ff)), 4);
+            __m128i bytes = _mm_or_si128(high, _mm_srli_epi16(val, 8));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + decoded), _mm_packus_epi16(bytes, bytes));
+            decoded += 8;
+        }
+#endif
+        for (; at + 1 < size; at += 2)
+        {
+            int high = value_of(in[at]);
+            if (high < 0)
+            {
+                return at;
+            }
+            int low = value_of(in[at + 1]);
+            if (low < 0)
+            {
+                return at + 1;
+            }
+            out[decoded++] = static_cast<uint8_t>((high << 4) | low);
+        }
+        if (at < size)
+        {
+            return value_of(in[at]) < 0 ? at : size;
+        }
+        return blob_decode_ok;
+    }
+
+    static int value_of(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        c |= 0x20;
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+};
+
+/**
+ * @brief Base64 encoding (RFC 4648, standard alphabet). Padding ("=") is optional.
+ */
+struct base64_encoding
+{
+    static const char* usage()
+    {
+        return "<base64>";
+    }
+
+    /**
+     * @brief Returns number of bytes that the encoded data of the specified size decodes to
+     *        (at most).
+     */
+    static size_t max_decoded_size(size_t size)
+    {
+        return (size + 3) / 4 * 3;
+    }
+
+    /**
+     * @brief Decodes (and validates) the data.
+     * @param in, size - encoded data.
+     * @param out - buffer for the result (of at least max_decoded_size(size) bytes).
+     * @param decoded - number of bytes decoded.
+     * @return blob_decode_ok, or offset of the first invalid character (size, if the data
+     *         is truncated).
+     */
+    static size_t decode(const char* in, size_t size, uint8_t* out, size_t& decoded)
+    {
+        size_t at = 0;
+        size_t end = size;
+        decoded = 0;
+        if (size % 4 == 0)
+        {
+            for (int i = 0; i < 2 && end > 0 && in[end - 1] == '='; i++)
+            {
+                end--;
+            }
+        }
+#ifdef BLOB_DECODE_USE_SSE2
+        for (; at + 16 <= end; at += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + at));
+            __m128i upper = in_range(v, 'A', 'Z');
+            __m128i lower = in_range(v, 'a', 'z');
+            __m128i digit = in_range(v, '0', '9');
+            __m128i plus = _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+            __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+            __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+                                         _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+            if (_mm_movemask_epi8(valid) != 0xffff)
+            {
+                break; // the scalar loop will find it
+            }
+            __m128i val = _mm_and_si128(upper, _mm_sub_epi8(v, _mm_set1_epi8('A')));
+            val = _mm_or_si128(val, _mm_and_si128(lower, _mm_sub_epi8(v, _mm_set1_epi8('a' - 26))));
+            val = _mm_or_si128(val, _mm_and_si128(digit, _mm_add_epi8(v, _mm_set1_epi8(52 - '0'))));
+            val = _mm_or_si128(val, _mm_and_si128(plus, _mm_set1_epi8(62)));
+            val = _mm_or_si128(val, _mm_and_si128(slash, _mm_set1_epi8(63)));
+
+            // 2 x 6 bits into 12 (16-bit lanes), then 2 x 12 into 24 bits (32-bit lanes)
+            __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(val, _mm_set1_epi16(0x00ff)), 6),
+                                         _mm_srli_epi16(val, 8));
+            __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            uint32_t words[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(words), quads);
+            for (int i = 0; i < 4; i++)
+            {
+                out[decoded++] = static_cast<uint8_t>(words[i] >> 16);
+                out[decoded++] = static_cast<uint8_t>(words[i] >> 8);
+                out[decoded++] = static_cast<uint8_t>(words[i]);
+            }
+        }
+#endif
+        uint32_t bits = 0;
+        int count = 0;
+        for (; at < end; at++)
+        {
+            int value = value_of(in[at]);
+            if (value < 0)
+            {
+                return at;
+            }
+            bits = (bits << 6) | value;
+            if (++count == 4)
+            {
+                out[decoded++] = static_cast<uint8_t>(bits >> 16);
+                out[decoded++] = static_cast<uint8_t>(bits >> 8);
+                out[decoded++] = static_cast<uint8_t>(bits);
+                bits = 0;
+                count = 0;
+            }
+        }
+        switch (count)
+        {
+        case 1:
+            return size; // truncated
+        case 2:
+            out[decoded++] = static_cast<uint8_t>(bits >> 4);
+            break;
+        case 3:
+            out[decoded++] = static_cast<uint8_t>(bits >> 10);
+            out[decoded++] = static_cast<uint8_t>(bits >> 2);
+            break;
+        default:
+            break;
+        }
+        return blob_decode_ok;
+    }
+
+    static int value_of(char c)
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            return c - 'A';
+        }
+        if (c >= 'a' && c <= 'z')
+        {
+            return c - 'a' + 26;
+        }
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0' + 52;
+        }
+        if (c == '+')
+        {
+            return 62;
+        }
+        if (c == '/')
+        {
+            return 63;
+        }
+        return -1;
+    }
+
+private:
+#ifdef BLOB_DECODE_USE_SSE2
+    static __m128i in_range(__m128i v, char first, char last)
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(first - 1)),
+                             _mm_cmplt_epi8(v, _mm_set1_epi8(last + 1)));
+    }
+#endif
+};
+
+#endif /* BLOB_DECODE_H_ */
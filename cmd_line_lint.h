@@ -0,0 +1,422 @@
+/**
+ * @file   cmd_line_lint.h
+ * @date   17 Oct 2026
+ * @brief  Validation of many command lines (e.g. generated ones) against the schema of a tool,
+ *         in parallel, without executing any of handlers. Also a main() for a linter program.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMD_LINE_LINT_H_
+#define CMD_LINE_LINT_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include "cmd_line_options.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CMD_LINE_LINT_USE_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Function defining the schema, i.e. adding options (and dependencies between them)
+ *        to the parser.
+ */
+typedef void (*schema_definition)(cmd_line_parser& parser);
+
+/**
+ * @brief Command line that is not valid.
+ */
+struct validation_failure
+{
+    size_t index; // (of the command line)
+    std::string error;
+
+    bool operator<(const validation_failure& other) const
+    {
+        return index < other.index;
+    }
+};
+
+/**
+ * @brief Splits the command line into arguments, as the shell would (without expanding
+ *        anything): arguments are separated by white spaces, and can be quoted using
+ *        '' or "", or escaped with a backslash.
+ * @return false if the line is not valid (i.e. a quote is not closed).
+ */
+inline bool split_command_line(const std::string& line, std::vector<std::string>& args)
+{
+    args.clear();
+    std::string arg;
+    bool in_arg = false;
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); i++)
+    {
+        char c = line[i];
+        if (quote != 0)
+        {
+            if (c == quote)
+            {
+                quote = 0;
+            }
+            else if (c == '\\' && quote == '"' && i + 1 < line.size() &&
+                     (line[i + 1] == '"' || line[i + 1] == '\\'))
+            {
+                arg += line[++i];
+            }
+            else
+            {
+                arg += c;
+            }
+        }
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            if (in_arg)
+            {
+                args.push_back(arg);
+                arg.clear();
+                in_arg = false;
+            }
+        }
+        else
+        {
+            in_arg = true;
+            if (c == '"' || c == '\'')
+            {
+                quote = c;
+            }
+            else if (c == '\\' && i + 1 < line.size())
+            {
+                arg += line[++i];
+            }
+            else
+            {
+                arg += c;
+            }
+        }
+    }
+    if (in_arg)
+    {
+        args.push_back(arg);
+    }
+    return quote == 0;
+}
+
+/**
+ * @brief Validates command lines against the schema, using multiple threads. Each of threads
+ *        has its own parser (parsers are not thread-safe), all of them with the same schema.
+ */
+class command_line_validator
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param define - function defining the schema (it's called once for each of threads).
+     * @param num_threads - number of threads to use (0: one per CPU).
+     * @throws option_error if the schema is not valid.
+     */
+    command_line_validator(schema_definition define, size_t num_threads = 0)
+    {
+        if (num_threads == 0)
+        {
+#ifdef CMD_LINE_LINT_USE_PTHREADS
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            num_threads = cpus > 0 ? static_cast<size_t>(cpus) : 1;
+#else
+            num_threads = 1;
+#endif
+        }
+#ifndef CMD_LINE_LINT_USE_PTHREADS
+        num_threads = 1;
+#endif
+        try
+        {
+            for (size_t i = 0; i < num_threads; i++)
+            {
+                parsers.push_back(new cmd_line_parser);
+                define(*parsers.back());
+                parsers.back()->setup_check_dependencies();
+            }
+        }
+        catch (...)
+        {
+            release();
+            throw;
+        }
+    }
+
+    ~command_line_validator()
+    {
+        release();
+    }
+
+    /**
+     * @brief Validates command lines (each of them: argv, i.e. starting with the name of
+     *        the program).
+     * @param failures - command lines that are not valid will be added here (in order).
+     * @return number of command lines that are not valid.
+     */
+    size_t validate(const std::vector<std::vector<std::string> >& command_lines,
+                    std::vector<validation_failure>& failures)
+    {
+        batch b;
+        b.command_lines = &command_lines;
+        b.next = 0;
+        std::vector<worker_args> workers(parsers.size());
+        for (size_t i = 0; i < parsers.size(); i++)
+        {
+            workers[i].parser = parsers[i];
+            workers[i].work = &b;
+        }
+
+#ifdef CMD_LINE_LINT_USE_PTHREADS
+        pthread_mutex_init(&b.lock, NULL);
+        std::vector<pthread_t> threads;
+        for (size_t i = 1; i < workers.size(); i++)
+        {
+            pthread_t t;
+            if (pthread_create(&t, NULL, worker, &workers[i]) != 0)
+            {
+                break;
+            }
+            threads.push_back(t);
+        }
+        worker(&workers[0]);
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        pthread_mutex_destroy(&b.lock);
+#else
+        worker(&workers[0]);
+#endif
+
+        size_t first = failures.size();
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            failures.insert(failures.end(), workers[i].failures.begin(), workers[i].failures.end());
+        }
+        std::sort(failures.begin() + first, failures.end());
+        return failures.size() - first;
+    }
+
+private:
+    command_line_validator(const command_line_validator&);
+    command_line_validator& operator=(const command_line_validator&);
+
+    enum constants
+    {
+        lines_per_block = 256
+    };
+
+    struct batch
+    {
+        const std::vector<std::vector<std::string> >* command_lines;
+        size_t next;
+#ifdef CMD_LINE_LINT_USE_PTHREADS
+        pthread_mutex_t lock;
+#endif
+    };
+
+    struct worker_args
+    {
+        cmd_line_parser* parser;
+        batch* work;
+        std::vector<validation_failure> failures;
+    };
+
+    static void* worker(void* arg)
+    {
+        worker_args& w = *static_cast<worker_args*>(arg);
+        const std::vector<std::vector<std::string> >& lines = *w.work->command_lines;
+        std::vector<char*> argv;
+        validation_failure failure;
+        for (;;)
+        {
+#ifdef CMD_LINE_LINT_USE_PTHREADS
+            pthread_mutex_lock(&w.work->lock);
+#endif
+            size_t begin = w.work->next;
+            size_t end = std::min(begin + lines_per_block, lines.size());
+            w.work->next = end;
+#ifdef CMD_LINE_LINT_USE_PTHREADS
+            pthread_mutex_unlock(&w.work->lock);
+#endif
+            if (begin >= end)
+            {
+                break;
+            }
+
+            for (size_t i = begin; i < end; i++)
+            {
+                argv.clear();
+                for (size_t a = 0; a < lines[i].size(); a++)
+                {
+                    argv.push_back(const_cast<char*>(lines[i][a].c_str()));
+                }
+                argv.push_back(NULL);
+                bool valid = false;
+                try
+                {
+                    valid = w.parser->validate(static_cast<int>(lines[i].size()), &argv[0],
+                                               failure.error);
+                }
+                catch (const std::exception& e)
+                {
+                    // (this one has to be reported here: it can't leave the thread)
+                    failure.error = e.what();
+                }
+                catch (...)
+                {
+                    failure.error = "unknown error";
+                }
+                if (!valid)
+                {
+                    failure.index = i;
+                    w.failures.push_back(failure);
+                }
+            }
+        }
+        return NULL;
+    }
+
+    void release()
+    {
+        for (size_t i = 0; i < parsers.size(); i++)
+        {
+            delete parsers[i];
+        }
+        parsers.clear();
+    }
+
+    std::vector<cmd_line_parser*> parsers;
+};
+
+/**
+ * @brief main() of a linter: it reads command lines (one per line, see split_command_line())
+ *        from files specified in argv (or from stdin), validates them against the schema and
+ *        reports each of command lines that is not valid, with its line number. Empty lines
+ *        and lines starting with '#' are skipped. e.g.:
+ *
+ * @code
+ * int main(int argc, char** argv)
+ * {
+ *     return cmd_line_lint_main(argc, argv, define_my_tool_options);
+ * }
+ * @endcode
+ *
+ * @return 0 if all command lines are valid, 1 if any of them is not, 2 on other errors.
+ */
+inline int cmd_line_lint_main(int argc, char** argv, schema_definition define,
+                              std::ostream& out = std::cout)
+{
+    const size_t lines_per_batch = 64 * 1024;
+    int result = 0;
+    try
+    {
+        command_line_validator validator(define);
+        std::vector<std::string> inputs(argv + 1, argv + (argc > 1 ? argc : 1));
+        if (inputs.empty())
+        {
+            inputs.push_back("-");
+        }
+
+        std::vector<std::vector<std::string> > command_lines;
+        std::vector<size_t> line_numbers;
+        std::vector<validation_failure> failures;
+        size_t checked = 0;
+        for (size_t f = 0; f < inputs.size(); f++)
+        {
+            std::ifstream file;
+            if (inputs[f] != "-")
+            {
+                file.open(inputs[f].c_str());
+                if (!file)
+                {
+                    out << inputs[f] << ": can't open the file\n";
+                    result = 2;
+                    continue;
+                }
+            }
+            std::istream& in = (inputs[f] == "-") ? std::cin : file;
+
+            std::string line;
+            size_t line_number = 0;
+            bool more = true;
+            while (more)
+            {
+                more = static_cast<bool>(std::getline(in, line));
+                if (more)
+                {
+                    line_number++;
+                    size_t start = line.find_first_not_of(" \t\r");
+                    if (start == std::string::npos || line[start] == '#')
+                    {
+                        continue;
+                    }
+                    command_lines.push_back(std::vector<std::string>());
+                    if (!split_command_line(line, command_lines.back()))
+                    {
+                        command_lines.pop_back();
+                        out << inputs[f] << ":" << line_number << ": quote is not closed\n";
+                        result = std::max(result, 1);
+                        continue;
+                    }
+                    line_numbers.push_back(line_number);
+                }
+
+                if (command_lines.size() == lines_per_batch || (!more && command_lines.size()))
+                {
+                    failures.clear();
+                    validator.validate(command_lines, failures);
+                    for (size_t i = 0; i < failures.size(); i++)
+                    {
+                        std::string& error = failures[i].error;
+                        std::replace(error.begin(), error.end(), '\n', ' ');
+                        out << inputs[f] << ":" << line_numbers[failures[i].index] << ": "
+                            << error << "\n";
+                        result = std::max(result, 1);
+                    }
+                    checked += command_lines.size();
+                    command_lines.clear();
+                    line_numbers.clear();
+                }
+            }
+        }
+        out << checked << " command line(s) checked\n";
+    }
+    catch (const std::exception& e)
+    {
+        out << e.what() << "\n";
+        result = 2;
+    }
+    return result;
+}
+
+#endif /* CMD_LINE_LINT_H_ */
@@ -76,12 +76,18 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <iterator>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <exception>
 #include <stdexcept>
-#include "alias_map.h"
+#include <string.h>
+#include <time.h>
+#include "schema_image.h"
+#include "blob_decode.h"
+#include "latency_histogram.h"
 
 #define DEFAULT_MAX_LINE_SIZE   70
 #define DEFAULT_SUB_INDENT_SIZE 4
@@ -100,6 +106,20 @@ public:
     }
 };
 
+/**
+ * @brief Monotonic time in nanoseconds (used to measure how long parsing takes).
+ */
+inline uint64_t cmd_line_time_ns()
+{
+#ifdef CLOCK_MONOTONIC
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<uint64_t>(t.tv_sec) * 1000000000u + t.tv_nsec;
+#else
+    return static_cast<uint64_t>(clock()) * (1000000000u / CLOCKS_PER_SEC);
+#endif
+}
+
 /**
  * @brief Compile-time assert macro. Allows adding a message.
  * Note, - it was meant to be used within functions
@@ -160,43 +180,53 @@ std::string demangled_typeid()
 
 /**
  * @brief Helper function to extract the whole token from the stringstream,
- * based on a specified delimiter list.
+ * based on a specified delimiter list. The token is stored in next_token (which is
+ * assigned rather than created, so that a buffer reused for all tokens does not
+ * need to allocate memory for each of them).
  */
-inline std::string get_next_token(std::stringstream& from, std::string delimiter_list = "\"")
+inline void read_next_token(std::stringstream& from, std::string& next_token,
+                            const std::string& delimiter_list = "\"")
 {
-    std::string next_token;
-    long where = static_cast<long>(from.tellg());
-    if (where >= 0)
+    next_token.clear();
+    if (static_cast<long>(from.tellg()) >= 0)
     {
-        long max_token_size = from.str().size() - where;
-        std::string temp_token = from.str().substr(where, max_token_size);
-        long end = temp_token.find_first_of(delimiter_list);
+        // read directly from the buffer: (copying the whole string here would make
+        // parsing of the command line quadratic in its length)
+        std::streambuf* buf = from.rdbuf();
+        const int eof = std::char_traits<char>::eof();
+        int c = buf->sgetc();
 
         // skip all delimiters before next token
-        while (end == 0 && max_token_size > 0)
+        while (c != eof && delimiter_list.find(static_cast<char>(c)) != std::string::npos)
         {
-            from.get();
-            where = static_cast<long>(from.tellg());
-            max_token_size--;
-            if (max_token_size > 0)
-            {
-                temp_token = from.str().substr(where, max_token_size);
-                end = temp_token.find_first_of(delimiter_list);
-                if (end < 0)
-                {
-                    end = max_token_size;
-                    break;
-                }
-            }
+            c = buf->snextc();
+        }
+
+        while (c != eof && delimiter_list.find(static_cast<char>(c)) == std::string::npos)
+        {
+            next_token += static_cast<char>(c);
+            c = buf->snextc();
+        }
+
+        if (c != eof)
+        {
+            buf->sbumpc(); // skip the delimiter that ended the token
         }
-        if (max_token_size > 0)
+        else if (next_token.size())
         {
-            next_token = from.str().substr(where, end);
-            std::stringstream::pos_type seek_to = from.tellg();
-            seek_to += next_token.size()+1;
-            from.seekg(seek_to);
+            from.setstate(std::ios_base::failbit); // token ended with the stream
         }
     }
+}
+
+/**
+ * @brief Helper function to extract the whole token from the stringstream,
+ * based on a specified delimiter list.
+ */
+inline std::string get_next_token(std::stringstream& from, std::string delimiter_list = "\"")
+{
+    std::string next_token;
+    read_next_token(from, next_token, delimiter_list);
     return next_token;
 }
 
@@ -403,394 +433,550 @@ inline void indent_and_trim(std::string& text,
     }
 }
 
-class doxy_dictionary
+/**
+ * @brief Set of bits of a size known only at run-time (used for sets of options, where
+ *        n-th bit corresponds to the option with id == n).
+ */
+class dynamic_bitset
 {
 public:
-    typedef std::vector<std::pair <std::string, std::string> > vector_of_string_pairs;
-    typedef std::map <std::string, std::vector< std::pair <std::string, std::string> > > dict_doxynary;
+    typedef unsigned long word_type;
+    static const size_t npos = static_cast<size_t>(-1);
 
-    class doxy_exception: public std::runtime_error
+    dynamic_bitset() :
+                    num_bits(0)
     {
-    public:
-        doxy_exception(const std::string &what) :
-            std::runtime_error(what)
-        {
-        }
-    };
+    }
 
-    doxy_dictionary()
+    explicit dynamic_bitset(size_t size) :
+                    num_bits(0)
     {
+        resize(size);
     }
 
-    bool setup(std::string from_str)
+    /**
+     * @brief Changes the size of the set. New bits are cleared.
+     */
+    void resize(size_t size)
     {
-        bool extracted_something = false;
-        std::string token;
-        std::string name;
-        std::string value;
-        std::stringstream s(from_str);
-        unsigned long start = from_str.find("@");
-        if(start != std::string::npos)
+        num_bits = size;
+        words.resize((size + bits_per_word - 1) / bits_per_word, 0);
+        if (size % bits_per_word)
         {
-            do
-            {
-                token = get_next_token(s, "@ :\t.");
-                if(token.length() < 2)
-                    {
-                    break;
-                    }
-
-                if((size_t)s.tellg() == (size_t)token.length() + 1
-                   && token != "brief") // in case brief was not there..
-                {
-                    value = token + get_next_token(s, "@");
-                    token = "brief";
-                }
-                else
-                {
-                    if(token == "param")
-                    {
-                        name = get_next_token(s, " :\t-");
-                    }
-
-                    if(token == "author")
-                    {
-                        value = get_next_token(s, " :\t-\n\r");
-                        if(value.rfind(".") == value.length()-1)
-                        {
-                            value.erase(value.length()-1, value.length());
-                        }
-                    }
-                    else
-                    {
-                        value = get_next_token(s, "@\0");
-                        value.erase(0, value.find_first_not_of(" :\n\r."));
-                    }
-                }
-
-                std::pair<dict_doxynary::iterator, bool> res;
-                if(dict.find(token) == dict.end())
-                {
-                    dict.insert(std::make_pair(token, vector_of_string_pairs()));
-                    extracted_something = true;
-                }
-
-                vector_of_string_pairs& v = dict[token];
-                v.push_back(std::make_pair(name, value));
-            }
-            while(value.length()>0);
+            words.back() &= (static_cast<word_type>(1) << (size % bits_per_word)) - 1;
         }
-        return extracted_something;
     }
 
-    void dump()
+    /**
+     * @brief Clears all bits.
+     */
+    void reset()
     {
-        std::cout << "\n\nall: \n";
-        dict_doxynary::iterator ti;
-        vector_of_string_pairs::iterator vi;
+        std::fill(words.begin(), words.end(), 0);
+    }
 
-        for (ti = dict.begin(); ti != dict.end(); ti++)
-        {
-            std::string token = ti->first;
-            std::cout << "token: " << token << "\n";
+    void set(size_t bit)
+    {
+        words[bit / bits_per_word] |= static_cast<word_type>(1) << (bit % bits_per_word);
+    }
 
-            for(vi = ti->second.begin(); vi != ti->second.end(); vi++)
-            {
-                std::cout << "\tname : [" << vi->first << "]\n";
-                std::cout << "\tvalue: [" << vi->second << "]\n";
-            }
-        }
+    bool test(size_t bit) const
+    {
+        return (words[bit / bits_per_word] >> (bit % bits_per_word)) & 1;
     }
 
-    bool found_tokens(const std::string& token_name)
+    size_t size() const
     {
-        bool res = false;
-        if(dict.size() > 0 && dict.find(token_name) != dict.end())
-        {
-            res = true;
-        }
-        return res;
+        return num_bits;
     }
 
-    vector_of_string_pairs& get_occurences(const std::string& token_name)
+    /**
+     * @brief Returns true if any of the bits is set.
+     */
+    bool any() const
     {
-        dict_doxynary::iterator i = dict.find(token_name);
-        if(i == dict.end())
+        for (size_t i = 0; i < words.size(); i++)
         {
-            std::stringstream err;
-            err << "doxy_parser::" << __FUNCTION__ << "(): token ";
-            err << token_name << " doesn't exist.";
-            throw doxy_exception(err.str());
+            if (words[i])
+            {
+                return true;
+            }
         }
-        return i->second;
+        return false;
     }
 
-public:
-    dict_doxynary dict;
-};
-
-/**
- * @brief This is a default template for a helper class used to extract parameters.
- *        It must not be used directly (in fact it's purpose is to report compile-time
- *        errors if cmd_line_parser::add_option() is called with a function for which any
- *        of the parameters can not be extracted (see below and examples for more detail.
- */
-template<class ParamType, class Other = void>
-class param_extractor
-{
-public:
     /**
-     * @brief Default constructor. The onliy reason for it in generic template implementation
-     *        is to create run-time error.
+     * @brief Returns number of bits that are set.
      */
-    param_extractor()
+    size_t count() const
     {
-        // default template should fail at compile time: this will allow for
-        // compile-time reporting if parameters of specified functions are supported.
-        STATIC_ASSERT(false, EXTRACTING_PARAMETERS_OF_THIS_TYPE_IS_NOT_SUPPORTED);
+        size_t result = 0;
+        for (size_t i = 0; i < words.size(); i++)
+        {
+            for (word_type w = words[i]; w != 0; w &= w - 1)
+            {
+                result++;
+            }
+        }
+        return result;
     }
 
     /**
-     * @brief Extracts a parameter and returns a value according to the type.
-     *        In specialisation-classes this method should either attempt to extract
-     *        the parameter from next token of the 'from' and return it by value, or it
-     *        should throw an exception on failure.
-     * @param from - stream pointing at the next token where this parameter is expected to be found.
+     * @brief Returns true if all bits set in other are also set in this set.
      */
-    static ParamType extract(std::stringstream& from)
+    bool includes(const dynamic_bitset& other) const
     {
-        return ParamType();
+        for (size_t i = 0; i < other.words.size(); i++)
+        {
+            if (other.words[i] & ~word_at(i))
+            {
+                return false;
+            }
+        }
+        return true;
     }
 
     /**
-     * @brief This method should return a 'usage' for the parameter. It will be called by the
-     *        framework to prepare usage information for params that use it.
+     * @brief Returns true if any bit is set in both sets.
      */
-    static std::string usage()
+    bool intersects(const dynamic_bitset& other) const
     {
-        return std::string();
+        size_t n = (std::min)(words.size(), other.words.size());
+        for (size_t i = 0; i < n; i++)
+        {
+            if (words[i] & other.words[i])
+            {
+                return true;
+            }
+        }
+        return false;
     }
-};
 
-/**
- * @brief A helper-macro that is using above template to define a temporary param_extractor.
- *        If - no specialisation was implemented for a ParamType, the default (above) template
- *        will report a compile time error.
- */
-#define STATIC_ASSERT_IF_CAN_BE_EXTRACTED(param) { param_extractor<param> a; (void)a;}
-
-/**
- * @brief Specialisation of param_extractor for "int" type.
- */
-template<>
-class param_extractor<int>
-{
-public:
     /**
-     * @brief See generic template for description
+     * @brief Returns position of the first bit set at or after 'from', or npos if there's none.
      */
-    static int extract(std::stringstream& from)
+    size_t find_next(size_t from) const
     {
-        int param;
-        int sign = 1;
-        std::stringstream token(get_next_token(from));
-        token.unsetf(std::ios_base::skipws);
-
-        if (token.peek() == '-')
+        while (from < num_bits)
         {
-            sign = -1;
-            token.get();
+            word_type w = words[from / bits_per_word] >> (from % bits_per_word);
+            if (w != 0)
+            {
+                while ((w & 1) == 0)
+                {
+                    w >>= 1;
+                    from++;
+                }
+                return from;
+            }
+            from = (from / bits_per_word + 1) * bits_per_word;
         }
-        // try as if it was decimal first..
-        token >> param;
+        return npos;
+    }
 
-        // but in case there was something left.. try it as hex
-        if (!token.eof())
+    dynamic_bitset& operator|=(const dynamic_bitset& other)
+    {
+        if (other.num_bits > num_bits)
         {
-            token.unget();
-            token >> std::hex >> param;
+            resize(other.num_bits);
         }
-
-        if (token.fail() || !token.eof())
+        for (size_t i = 0; i < other.words.size(); i++)
         {
-            std::stringstream err;
-            err << usage() << ", got: \"" << token.str() << "\"";
-            throw option_error(err.str());
+            words[i] |= other.words[i];
         }
-        return param * sign;
+        return *this;
     }
 
-    /**
-     * @brief see generic template for description
-     */
-    static std::string usage()
+private:
+    word_type word_at(size_t i) const
     {
-        return std::string("<int>");
+        return i < words.size() ? words[i] : 0;
     }
+
+    static const size_t bits_per_word = sizeof(word_type) * 8;
+    std::vector<word_type> words;
+    size_t num_bits;
 };
 
 /**
- * @brief Specialisation of param_extractor for "unsigned int" type.
+ * @brief Extracts doxygen-like tags (i.e. "@brief", "@param name" or "@author") from
+ *        a description. It's done in a single pass: occurrences of tags are recorded as
+ *        spans (offsets) in the description, that is kept by the dictionary.
+ *        Text preceding the first tag is an implicit "@brief".
  */
-template<>
-class param_extractor<unsigned int>
+class doxy_dictionary
 {
 public:
     /**
-     * @brief See generic template for description.
+     * @brief Part of the description, i.e. name or a value of a tag.
      */
-    static unsigned int extract(std::stringstream& from)
+    struct text_span
     {
-        unsigned int param;
-        int sign = 1;
-        std::stringstream token(get_next_token(from));
-        token.unsetf(std::ios_base::skipws);
+        size_t at;
+        size_t length;
+    };
 
-        if (token.peek() == '-')
-        {
-            sign = -1;
-            token.get();
-        }
+    /**
+     * @brief One occurrence of a tag, e.g. "@param name value".
+     */
+    struct tag_occurrence
+    {
+        text_span name;
+        text_span value;
+    };
 
-        // try as if it was decimal first..
-        token >> param;
+    typedef std::vector<tag_occurrence> occurrences;
 
-        // but in case there was something left.. try it as hex
-        if (!token.eof())
+    class doxy_exception: public std::runtime_error
+    {
+    public:
+        doxy_exception(const std::string &what) :
+            std::runtime_error(what)
         {
-            token.unget();
-            token >> std::hex >> param;
         }
+    };
 
-        if (token.fail() || !token.eof() || sign == -1)
-        {
-            std::stringstream err;
-            err << usage() << ", got: \"" << token.str() << "\"";
-            throw option_error(err.str());
-        }
-        return param;
-    }
-    static std::string usage()
+    doxy_dictionary()
     {
-        return std::string("<unsigned int>");
     }
-};
 
-/**
- * @brief Specialisation of param_extractor for "long" type.
- */
-template<>
-class param_extractor<long>
-{
-public:
     /**
-     * @brief See generic template for description.
+     * @brief Extracts tags from the description.
+     * @return true if any tags were found.
      */
-    static long extract(std::stringstream& from)
+    bool setup(const std::string& from_str)
     {
-        long param;
-        long sign = 1;
-        std::stringstream token(get_next_token(from));
-        token.unsetf(std::ios_base::skipws);
+        static const char* tag_delims = "@ :\t.\n\r";
+        text = from_str;
+        tags.clear();
 
-        if (token.peek() == '-')
+        size_t at = text.find('@');
+        if (at == std::string::npos)
         {
-            sign = -1;
-            token.get();
+            return false;
         }
 
-        // try as if it was decimal first..
-        token >> param;
-
-        // but in case there was something left.. try it as hex
-        if (!token.eof())
+        size_t start = text.find_first_not_of(tag_delims);
+        if (start < at) // in case brief was not there..
         {
-            token.unget();
-            token >> std::hex >> param;
+            tag_occurrence brief = {span(start, start), span(start, at)};
+            occurrences_of("brief", 5).push_back(brief);
         }
 
-        if (token.fail() || !token.eof())
+        const size_t end = text.size();
+        while (at < end)
         {
-            std::stringstream err;
-            err << usage() << ", got: \"" << token.str() << "\"";
-            throw option_error(err.str());
-        }
-        return param * sign;
+            size_t tag_at = at + 1;
+            size_t tag_end = std::min(text.find_first_of(tag_delims, tag_at), end);
+            if (tag_end - tag_at < 2)
+            {
+                break;
+            }
+            size_t pos = skip_delimiter(tag_end);
+            size_t next = std::min(text.find('@', pos), end);
+
+            tag_occurrence o = {span(pos, pos), span(pos, pos)};
+            if (is_tag(tag_at, tag_end, "param"))
+            {
+                size_t name_at = std::min(text.find_first_not_of(" :\t-", pos), next);
+                size_t name_end = std::min(text.find_first_of(" :\t-@", name_at), next);
+                o.name = span(name_at, name_end);
+                pos = skip_delimiter(name_end);
+            }
+
+            if (is_tag(tag_at, tag_end, "author"))
+            {
+                size_t value_at = std::min(text.find_first_not_of(" :\t-\n\r", pos), next);
+                size_t value_end = std::min(text.find_first_of(" :\t-\n\r@", value_at), next);
+                if (value_end > value_at && text[value_end - 1] == '.')
+                {
+                    value_end--;
+                }
+                o.value = span(value_at, value_end);
+            }
+            else
+            {
+                o.value = span(std::min(text.find_first_not_of(" :\n\r.", pos), next), next);
+            }
+            occurrences_of(text.data() + tag_at, tag_end - tag_at).push_back(o);
+            at = next;
+        }
+        return !tags.empty();
+    }
+
+    void dump()
+    {
+        std::cout << "\n\nall: \n";
+        for (size_t t = 0; t < tags.size(); t++)
+        {
+            std::cout << "token: " << tags[t].first << "\n";
+            for (size_t i = 0; i < tags[t].second.size(); i++)
+            {
+                std::cout << "\tname : [" << text_of(tags[t].second[i].name) << "]\n";
+                std::cout << "\tvalue: [" << text_of(tags[t].second[i].value) << "]\n";
+            }
+        }
+    }
+
+    bool found_tokens(const std::string& token_name) const
+    {
+        return find(token_name.data(), token_name.size()) != NULL;
+    }
+
+    const occurrences& get_occurences(const std::string& token_name) const
+    {
+        const occurrences* o = find(token_name.data(), token_name.size());
+        if (o == NULL)
+        {
+            std::stringstream err;
+            err << "doxy_parser::" << __FUNCTION__ << "(): token ";
+            err << token_name << " doesn't exist.";
+            throw doxy_exception(err.str());
+        }
+        return *o;
     }
 
     /**
-     * @brief See generic template for description.
+     * @brief Returns the text of the specified span (name or value of a tag).
      */
-    static std::string usage()
+    std::string text_of(const text_span& s) const
+    {
+        return text.substr(s.at, s.length);
+    }
+
+private:
+    static text_span span(size_t from, size_t to)
+    {
+        text_span s = {from, to - from};
+        return s;
+    }
+
+    size_t skip_delimiter(size_t at) const
+    {
+        return (at < text.size() && text[at] != '@') ? at + 1 : at;
+    }
+
+    bool is_tag(size_t at, size_t end, const char* name) const
+    {
+        return text.compare(at, end - at, name) == 0;
+    }
+
+    const occurrences* find(const char* name, size_t length) const
+    {
+        for (size_t i = 0; i < tags.size(); i++)
+        {
+            if (tags[i].first.size() == length && tags[i].first.compare(0, length, name, length) == 0)
+            {
+                return &tags[i].second;
+            }
+        }
+        return NULL;
+    }
+
+    occurrences& occurrences_of(const char* name, size_t length)
+    {
+        const occurrences* o = find(name, length);
+        if (o == NULL)
+        {
+            tags.push_back(std::make_pair(std::string(name, length), occurrences()));
+            return tags.back().second;
+        }
+        return const_cast<occurrences&>(*o);
+    }
+
+    std::string text;
+    std::vector<std::pair<std::string, occurrences> > tags; // (there are only few of them)
+};
+
+/**
+ * @brief Tells which arguments end parameters of an option, i.e. can't be taken as parameters
+ *        by rest_of_args (e.g. names of options).
+ */
+class cmd_line_boundaries
+{
+public:
+    virtual ~cmd_line_boundaries()
     {
-        return std::string("<long>");
     }
+
+    virtual bool is_boundary(const char* arg, size_t size) const = 0;
 };
 
 /**
- * @brief Specialisation of param_extractor for "unsigned long" type.
+ * @brief Stream holding the command line being parsed (see get_next_token()). Apart from
+ *        tokens, it knows which of arguments (argv) each of them came from, so that
+ *        parameters (e.g. rest_of_args) can refer to arguments directly, without copying them.
  */
-template<>
-class param_extractor<unsigned long>
+class cmd_line_stream: public std::stringstream
 {
 public:
     /**
-     * @brief See generic template for description.
+     * @brief Constructor.
+     * @param cmd_line - arguments (all but argv[0]), each of them surrounded with "".
+     * @param argc, argv - arguments the cmd_line was made of.
+     * @param arg_boundaries - tells where the next option starts (see ends_params()).
      */
-    static unsigned long extract(std::stringstream& from)
+    cmd_line_stream(const std::string& cmd_line, int argc, char* const argv[],
+                    const cmd_line_boundaries* arg_boundaries)
     {
-        unsigned long param;
-        int sign = 1;
-        std::stringstream token(get_next_token(from));
-        token.unsetf(std::ios_base::skipws);
+        assign(cmd_line, argc, argv, arg_boundaries);
+    }
 
-        if (token.peek() == '-')
+    /**
+     * @brief Default constructor, (the stream is empty until assign() is called).
+     */
+    cmd_line_stream() :
+                    args(NULL),
+                    args_count(0),
+                    boundaries(NULL)
+    {
+    }
+
+    /**
+     * @brief Makes the stream hold another command line (parameters as for the constructor).
+     *        Buffers of the stream are reused, i.e. once they are big enough for command
+     *        lines that are parsed - no memory is allocated here.
+     */
+    void assign(const std::string& cmd_line, int argc, char* const argv[],
+                const cmd_line_boundaries* arg_boundaries)
+    {
+        str(cmd_line);
+        clear();
+        args = argv;
+        args_count = argc;
+        boundaries = arg_boundaries;
+
+        size_t at = 0;
+        offsets.clear();
+        offsets.reserve(argc > 1 ? argc - 1 : 0);
+        for (int i = 1; i < argc; i++)
         {
-            sign = -1;
-            token.get();
+            offsets.push_back(at);
+            at += strlen(argv[i]) + 2;
         }
+    }
 
-        // try as if it was decimal first..
-        token >> param;
-
-        // but in case there was something left.. try it as hex
-        if (!token.eof())
+    /**
+     * @brief Returns index (in argv) of the first argument that was not yet read.
+     */
+    int next_arg()
+    {
+        std::streamoff pos = tellg();
+        if (pos < 0)
         {
-            token.unget();
-            token >> std::hex >> param;
+            return args_count;
         }
+        std::vector<size_t>::iterator i = std::lower_bound(offsets.begin(), offsets.end(),
+                                                           static_cast<size_t>(pos));
+        return static_cast<int>(i - offsets.begin()) + 1;
+    }
 
-        if (token.fail() || !token.eof() || sign == -1)
+    /**
+     * @brief Moves the stream to the beginning of the specified argument.
+     */
+    void seek_arg(int index)
+    {
+        clear();
+        if (index < args_count)
         {
-            std::stringstream err;
-            err << usage() << ", got: \"" << token.str() << "\"";
-            throw option_error(err.str());
+            seekg(offsets[index - 1]);
+        }
+        else
+        {
+            seekg(0, std::ios_base::end);
         }
-        return param;
     }
+
     /**
-     * @brief See generic template for description.
+     * @brief Returns true if argument of the specified index ends parameters of an option
+     *        (e.g. it is a name of an option, see cmd_line_boundaries).
+     */
+    bool ends_params(int index) const
+    {
+        return boundaries != NULL && boundaries->is_boundary(args[index], strlen(args[index]));
+    }
+
+    char* const* argv() const
+    {
+        return args;
+    }
+
+    int argc() const
+    {
+        return args_count;
+    }
+
+private:
+    char* const* args;
+    int args_count;
+    const cmd_line_boundaries* boundaries;
+    std::vector<size_t> offsets; // of each argument (i.e. of its opening '"') in the stream
+};
+
+/**
+ * @brief This is a default template for a helper class used to extract parameters.
+ *        It must not be used directly (in fact it's purpose is to report compile-time
+ *        errors if cmd_line_parser::add_option() is called with a function for which any
+ *        of the parameters can not be extracted (see below and examples for more detail.
+ */
+template<class ParamType, class Other = void>
+class param_extractor
+{
+public:
+    /**
+     * @brief Default constructor. The onliy reason for it in generic template implementation
+     *        is to create run-time error.
+     */
+    param_extractor()
+    {
+        // default template should fail at compile time: this will allow for
+        // compile-time reporting if parameters of specified functions are supported.
+        STATIC_ASSERT(false, EXTRACTING_PARAMETERS_OF_THIS_TYPE_IS_NOT_SUPPORTED);
+    }
+
+    /**
+     * @brief Extracts a parameter and returns a value according to the type.
+     *        In specialisation-classes this method should either attempt to extract
+     *        the parameter from next token of the 'from' and return it by value, or it
+     *        should throw an exception on failure.
+     * @param from - stream pointing at the next token where this parameter is expected to be found.
+     */
+    static ParamType extract(std::stringstream& from)
+    {
+        return ParamType();
+    }
+
+    /**
+     * @brief This method should return a 'usage' for the parameter. It will be called by the
+     *        framework to prepare usage information for params that use it.
      */
     static std::string usage()
     {
-        return std::string("<unsigned long>");
+        return std::string();
     }
 };
 
 /**
- * @brief Specialisation of param_extractor for "short" type.
+ * @brief A helper-macro that is using above template to define a temporary param_extractor.
+ *        If - no specialisation was implemented for a ParamType, the default (above) template
+ *        will report a compile time error.
+ */
+#define STATIC_ASSERT_IF_CAN_BE_EXTRACTED(param) { param_extractor<param> a; (void)a;}
+
+/**
+ * @brief Specialisation of param_extractor for "int" type.
  */
 template<>
-class param_extractor<short>
+class param_extractor<int>
 {
 public:
     /**
-     * @brief See generic template for description.
+     * @brief See generic template for description
      */
-    static short extract(std::stringstream& from)
+    static int extract(std::stringstream& from)
     {
-        short param;
-        short sign = 1;
+        int param;
+        int sign = 1;
         std::stringstream token(get_next_token(from));
         token.unsetf(std::ios_base::skipws);
 
@@ -799,7 +985,6 @@ public:
             sign = -1;
             token.get();
         }
-
         // try as if it was decimal first..
         token >> param;
 
@@ -818,28 +1003,29 @@ public:
         }
         return param * sign;
     }
+
     /**
-     * @brief See generic template for description.
+     * @brief see generic template for description
      */
     static std::string usage()
     {
-        return std::string("<short>");
+        return std::string("<int>");
     }
 };
 
 /**
- * @brief Specialisation of param_extractor for "unsigned short" type.
+ * @brief Specialisation of param_extractor for "unsigned int" type.
  */
 template<>
-class param_extractor<unsigned short>
+class param_extractor<unsigned int>
 {
 public:
     /**
      * @brief See generic template for description.
      */
-    static unsigned short extract(std::stringstream& from)
+    static unsigned int extract(std::stringstream& from)
     {
-        unsigned short param;
+        unsigned int param;
         int sign = 1;
         std::stringstream token(get_next_token(from));
         token.unsetf(std::ios_base::skipws);
@@ -868,63 +1054,261 @@ public:
         }
         return param;
     }
-    /**
-     * @brief See generic template for description.
-     */
     static std::string usage()
     {
-        return std::string("<unsigned short>");
+        return std::string("<unsigned int>");
     }
 };
 
 /**
- * @brief Specialisation of param_extractor for "char" type.
+ * @brief Specialisation of param_extractor for "long" type.
  */
 template<>
-class param_extractor<char>
+class param_extractor<long>
 {
 public:
     /**
      * @brief See generic template for description.
      */
-    static char extract(std::stringstream& from)
+    static long extract(std::stringstream& from)
     {
-        char param;
+        long param;
+        long sign = 1;
         std::stringstream token(get_next_token(from));
-        param = token.get();
-        if (token.fail() || token.get() != std::char_traits<char>::eof())
+        token.unsetf(std::ios_base::skipws);
+
+        if (token.peek() == '-')
+        {
+            sign = -1;
+            token.get();
+        }
+
+        // try as if it was decimal first..
+        token >> param;
+
+        // but in case there was something left.. try it as hex
+        if (!token.eof())
+        {
+            token.unget();
+            token >> std::hex >> param;
+        }
+
+        if (token.fail() || !token.eof())
         {
             std::stringstream err;
             err << usage() << ", got: \"" << token.str() << "\"";
             throw option_error(err.str());
         }
-        return param;
+        return param * sign;
     }
+
     /**
      * @brief See generic template for description.
      */
     static std::string usage()
     {
-        return std::string("<char>");
+        return std::string("<long>");
     }
 };
 
 /**
- * @brief Specialisation of param_extractor for "signed char" type.
+ * @brief Specialisation of param_extractor for "unsigned long" type.
  */
 template<>
-class param_extractor<signed char>
+class param_extractor<unsigned long>
 {
 public:
     /**
      * @brief See generic template for description.
      */
-    static signed char extract(std::stringstream& from)
+    static unsigned long extract(std::stringstream& from)
     {
-        signed char param;
+        unsigned long param;
+        int sign = 1;
         std::stringstream token(get_next_token(from));
-        param = token.get();
-        if (token.fail() || token.get() != std::char_traits<char>::eof())
+        token.unsetf(std::ios_base::skipws);
+
+        if (token.peek() == '-')
+        {
+            sign = -1;
+            token.get();
+        }
+
+        // try as if it was decimal first..
+        token >> param;
+
+        // but in case there was something left.. try it as hex
+        if (!token.eof())
+        {
+            token.unget();
+            token >> std::hex >> param;
+        }
+
+        if (token.fail() || !token.eof() || sign == -1)
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token.str() << "\"";
+            throw option_error(err.str());
+        }
+        return param;
+    }
+    /**
+     * @brief See generic template for description.
+     */
+    static std::string usage()
+    {
+        return std::string("<unsigned long>");
+    }
+};
+
+/**
+ * @brief Specialisation of param_extractor for "short" type.
+ */
+template<>
+class param_extractor<short>
+{
+public:
+    /**
+     * @brief See generic template for description.
+     */
+    static short extract(std::stringstream& from)
+    {
+        short param;
+        short sign = 1;
+        std::stringstream token(get_next_token(from));
+        token.unsetf(std::ios_base::skipws);
+
+        if (token.peek() == '-')
+        {
+            sign = -1;
+            token.get();
+        }
+
+        // try as if it was decimal first..
+        token >> param;
+
+        // but in case there was something left.. try it as hex
+        if (!token.eof())
+        {
+            token.unget();
+            token >> std::hex >> param;
+        }
+
+        if (token.fail() || !token.eof())
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token.str() << "\"";
+            throw option_error(err.str());
+        }
+        return param * sign;
+    }
+    /**
+     * @brief See generic template for description.
+     */
+    static std::string usage()
+    {
+        return std::string("<short>");
+    }
+};
+
+/**
+ * @brief Specialisation of param_extractor for "unsigned short" type.
+ */
+template<>
+class param_extractor<unsigned short>
+{
+public:
+    /**
+     * @brief See generic template for description.
+     */
+    static unsigned short extract(std::stringstream& from)
+    {
+        unsigned short param;
+        int sign = 1;
+        std::stringstream token(get_next_token(from));
+        token.unsetf(std::ios_base::skipws);
+
+        if (token.peek() == '-')
+        {
+            sign = -1;
+            token.get();
+        }
+
+        // try as if it was decimal first..
+        token >> param;
+
+        // but in case there was something left.. try it as hex
+        if (!token.eof())
+        {
+            token.unget();
+            token >> std::hex >> param;
+        }
+
+        if (token.fail() || !token.eof() || sign == -1)
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token.str() << "\"";
+            throw option_error(err.str());
+        }
+        return param;
+    }
+    /**
+     * @brief See generic template for description.
+     */
+    static std::string usage()
+    {
+        return std::string("<unsigned short>");
+    }
+};
+
+/**
+ * @brief Specialisation of param_extractor for "char" type.
+ */
+template<>
+class param_extractor<char>
+{
+public:
+    /**
+     * @brief See generic template for description.
+     */
+    static char extract(std::stringstream& from)
+    {
+        char param;
+        std::stringstream token(get_next_token(from));
+        param = token.get();
+        if (token.fail() || token.get() != std::char_traits<char>::eof())
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token.str() << "\"";
+            throw option_error(err.str());
+        }
+        return param;
+    }
+    /**
+     * @brief See generic template for description.
+     */
+    static std::string usage()
+    {
+        return std::string("<char>");
+    }
+};
+
+/**
+ * @brief Specialisation of param_extractor for "signed char" type.
+ */
+template<>
+class param_extractor<signed char>
+{
+public:
+    /**
+     * @brief See generic template for description.
+     */
+    static signed char extract(std::stringstream& from)
+    {
+        signed char param;
+        std::stringstream token(get_next_token(from));
+        param = token.get();
+        if (token.fail() || token.get() != std::char_traits<char>::eof())
         {
             std::stringstream err;
             err << usage() << ", got: \"" << token.str() << "\"";
@@ -1225,752 +1609,957 @@ public:
 #define OPTIONAL_VALUE(type, name, value) optional_value<type, value> name = optional_value<type, value>()
 
 /**
- * @brief Base class for options. It is mainly to provide a common interface
- *        To allow all options (sort of 'commands' to be called using a common interface).
+ * @brief Item of a table of choices (see choice below): a name and a value it stands for.
  */
-class option
+template<typename ValueType>
+struct choice_item
+{
+    const char* name;
+    ValueType value;
+};
+
+/**
+ * @brief Parameter that accepts one of a fixed set of names (e.g. "fast", "safe" or "paranoid")
+ *        and converts it into a corresponding value (usually an enum). Choices are defined by
+ *        the Traits class, that has to provide a type of the value and a table of choices, e.g.:
+ *
+ * @code
+ * struct mode
+ * {
+ *     enum type { fast, safe, paranoid };
+ *     static const choice_item<type>* items(size_t& count)
+ *     {
+ *         static const choice_item<type> table[] = { {"fast", fast},
+ *                                                    {"safe", safe},
+ *                                                    {"paranoid", paranoid} };
+ *         count = sizeof(table) / sizeof(table[0]);
+ *         return table;
+ *     }
+ * };
+ *
+ * void set_mode(choice<mode> m)
+ * {
+ *     if (m == mode::paranoid) ...
+ * }
+ *
+ * parser.add_option(set_mode, "--mode", "sets the mode"); // usage: "--mode <fast|safe|paranoid>"
+ * @endcode
+ */
+template<class Traits>
+class choice
 {
 public:
+    typedef typename Traits::type value_type;
+
     /**
-     * @brief Constructor.
-     * @param  option_name - name of the option. It will be used also as a key that the option
-     *         is selected from the command line.
+     * @brief Default constructor.
      */
-    option(std::string& option_name) :
-                    standalone(false),
-                    name(option_name),
-                    params_extracted(0),
-                    indent_size(0),
-                    format_flags(f_full_info)
+    choice() :
+                    value()
     {
     }
+
     /**
-     * @brief Destructor. Required because of virtuals, but there's nothing really to clean-up
-     * at the moment.
+     * @brief Conversion constructor (allows to call the handler with a value directly).
      */
-    virtual ~option()
+    choice(const value_type& val) :
+                    value(val)
     {
     }
 
     /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
+     * @brief Getter..
      */
-    virtual void extract_params(std::stringstream& cmd_line_options) = 0;
+    value_type get_value() const
+    {
+        return value;
+    }
 
     /**
-     * @brief adds another option that this option requires
+     * @brief Conversion operator..
      */
-    void add_required_option(const std::string& option_name)
+    operator value_type() const
     {
-        required_options.push_back(option_name);
+        return value;
     }
 
+    value_type value;
+};
+
+/**
+ * @brief Perfect hash table of choices defined by Traits. It is built only once (on the first
+ *        use) and then each name is looked-up with a single probe and a single comparison.
+ *        It's built using "hash and displace" (CHD): names are split by their hash into
+ *        buckets (one per name on average), and for each bucket (biggest ones first)
+ *        a displacement is found, that places all of its names in free slots of the table.
+ *        A bucket with a single name is placed in any free slot directly, so that buckets
+ *        left for the end can always be placed, whatever the number of names is. Names are
+ *        hashed to 64 bits, so that (unlike with name_hash()) they don't collide.
+ */
+template<class Traits>
+class choice_table
+{
+public:
+    typedef typename Traits::type value_type;
+    typedef choice_item<value_type> item_type;
+
     /**
-     * @brief adds another option that this option must not be specified with.
+     * @brief Returns the table for this Traits.
+     * @throws option_error if names of choices are not unique.
      */
-    void add_not_wanted_option(const std::string& option_name)
+    static const choice_table& instance()
     {
-        not_wanted_options.push_back(option_name);
+        static const choice_table table;
+        return table;
     }
 
     /**
-     * @brief sets this option as a standalone (i.e. it must not be specified with any other option).
+     * @brief Finds the choice.
+     * @return pointer to the item or NULL if there is no choice with this name.
      */
-    void set_as_standalone()
+    const item_type* find(const std::string& name) const
     {
-        standalone = true;
+        if (slots.size() > 0)
+        {
+            const item_type* item = slots[slot_of(hash_of(name.data(), name.size()))];
+            if (item != NULL && name == item->name)
+            {
+                return item;
+            }
+        }
+        return NULL;
     }
 
     /**
-     * @brief Checks if specified options are valid with this option.
-     * @param all_specified_options - vector of all specified options.
-     * @throws option_error if specified options do not match requirements of this option.
+     * @brief Returns usage, i.e. all choices in order they were defined, e.g. "<fast|safe>".
      */
-    void check_if_valid_with_these_options(std::vector<std::string>& all_specified_options)
+    const std::string& usage() const
     {
-        std::stringstream result;
-        if (all_specified_options.size())
+        return usage_str;
+    }
+
+private:
+    enum constants
+    {
+        max_displacement = 1 << 16 // (before the table is made bigger)
+    };
+
+    static const uint32_t direct = 0x80000000u; // (displacement is the slot itself)
+
+    choice_table() :
+                    items(NULL),
+                    count(0),
+                    bits(1),
+                    bucket_bits(1)
+    {
+        items = Traits::items(count);
+
+        std::stringstream usg;
+        usg << "<";
+        std::vector<std::pair<uint64_t, size_t> > hashes(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            usg << (i ? "|" : "") << items[i].name;
+            hashes[i] = std::make_pair(hash_of(items[i].name, strlen(items[i].name)), i);
+        }
+        usg << ">";
+        usage_str = usg.str();
+
+        std::sort(hashes.begin(), hashes.end());
+        for (size_t i = 1; i < count; i++)
         {
-            if (required_options.size() && all_specified_options.size())
+            if (hashes[i - 1].first == hashes[i].first)
             {
-                Container diff = get_set_difference(required_options,
-                                                    all_specified_options);
-                if (diff.size())
+                const char* first = items[std::min(hashes[i - 1].second, hashes[i].second)].name;
+                const char* second = items[std::max(hashes[i - 1].second, hashes[i].second)].name;
+                std::stringstream err;
+                if (strcmp(first, second) == 0)
                 {
-                    result << "option \"" << name << "\" requires also: ";
-                    result << merge_items_to_string(diff);
+                    err << "choice \"" << first << "\" was defined more than once";
                 }
-            }
-
-            if (not_wanted_options.size())
-            {
-                Container isect = get_set_intersection(not_wanted_options,
-                                                       all_specified_options);
-                if (isect.size())
-                {
-                    if (result.str().size() == 0)
-                    {
-                        result << "option \"" << name << "\"";
-                    }
-                    else
-                    {
-                        result << ", and";
-                    }
-                    result << " can't be used with: ";
-                    result << merge_items_to_string(isect);
-                }
-            }
-
-            if (standalone)
-            {
-                if (all_specified_options.size() > 1)
+                else
                 {
-                    result.str().clear();
-                    result << "option \"" << name << "\"";
-                    result << " can't be used with other options, but specified with: ";
-                    all_specified_options.erase(std::remove(all_specified_options.begin(),
-                                                            all_specified_options.end(),
-                                                            name),
-                                                all_specified_options.end());
-                    result << merge_items_to_string(all_specified_options);
+                    // (no displacement would place these in different slots)
+                    err << "choices \"" << first << "\" and \"" << second << "\" have the same hash";
                 }
+                throw option_error(err.str());
             }
         }
 
-        if (result.str().length() > 0)
+        while ((static_cast<size_t>(1) << bucket_bits) < count)
         {
-            std::stringstream err;
-            err << "error: " << result.str();
-            throw option_error(err.str());
+            bucket_bits++;
+        }
+        while ((static_cast<size_t>(1) << bits) < count * 2)
+        {
+            bits++;
+        }
+        // (if displacements of some bucket can't be found, the table is made bigger)
+        for (; bits < 32; bits++)
+        {
+            if (try_to_place(hashes))
+            {
+                return;
+            }
         }
+        throw option_error("couldn't create a hash table for choices");
     }
 
     /**
-     * @brief Set the description of the program.
-     * @param description - a sort of brief that would usually say what your tool is meant for etc.
+     * @brief FNV-1a hash (64-bit variant of name_hash()).
      */
-    void set_description(std::string& description)
+    static uint64_t hash_of(const char* name, size_t size)
     {
-        descr = description;
-        if (doxy_dict.setup(description))
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++)
         {
-            try
-            {
-                doxy_dictionary::vector_of_string_pairs& brief = doxy_dict.get_occurences("brief");
-                doxy_dictionary::vector_of_string_pairs& params = doxy_dict.get_occurences("param");
-                descr = brief.begin()->second;
-
-                const int& number_of_params = num_params();
-                const int& number_of_param_descr = params.size();
-                if(number_of_params != number_of_param_descr)
-                {
-                    std::stringstream err;
-                    err << "Error while parsing description for option \"";
-                    err << name.c_str() << "\": \nexpected to find " << number_of_params;
-                    err << " parameters, but found " << number_of_param_descr << ".";
-                    throw std::runtime_error(err.str());
-                }
-            }
-            catch(const doxy_dictionary::doxy_exception&)
-            {
-                // ok, doxy_parser not constructed, carry on
-            }
-            catch(...)
-            {
-                throw;
-            }
+            h ^= static_cast<unsigned char>(name[i]);
+            h *= 1099511628211ull;
         }
+        return h;
     }
 
-    inline void fmt_usage_only()
+    static uint64_t mix(uint64_t h)
     {
-        format_flags = option::f_usage_only;
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return h;
     }
 
-    inline void fmt_full_info()
+    size_t bucket_of(uint64_t hash) const
     {
-        format_flags = option::f_full_info;
+        return static_cast<size_t>(mix(hash) >> (64 - bucket_bits));
     }
 
-    void fmt_set_indent(int num_of_characters)
+    size_t displaced_slot(uint64_t hash, uint32_t displacement) const
     {
-        indent_size = num_of_characters;
+        return static_cast<size_t>(mix(hash ^ ((displacement + 1) * 0x9e3779b97f4a7c15ull)) >> (64 - bits));
     }
 
-    friend std::ostream& operator<<(std::ostream &out,  option& o);
-
-    virtual int num_params()
+    size_t slot_of(uint64_t hash) const
     {
-        return 0; // default implementation..
+        uint32_t displacement = displacements[bucket_of(hash)];
+        return (displacement & direct) ? (displacement & ~direct) : displaced_slot(hash, displacement);
     }
 
     /**
-     * @brief Main interface that will be called by the cmd_line_parser if it will match a method being called.
-     *        For each of the possible options - it will usually implement calls to type-dependent param_extractor
-     *        methods to extract parameters and, on success (i.e. once all parameters are extracted)- it will call
-     *        the function with these values.
+     * @brief Places all items in the table (of the current size).
+     * @return false if displacement for some bucket couldn't be found.
      */
-    virtual void execute() = 0;
-
-    bool standalone;
-    std::string name;
-    std::string usage;
-    std::string descr;
-
-    typedef std::vector<std::string> Container;
-
-    Container required_options;
-    Container not_wanted_options;
-
-    doxy_dictionary doxy_dict;
-    size_t params_extracted;
-    int indent_size;
-
-    enum formatting_flags
-    {
-        f_full_info = 0,
-        f_usage_only = 1
-    };
-    int format_flags;
-};
-
-inline std::ostream& operator<<(std::ostream &out,  option& o)
-{
-    out << "\n";
-    int sub_indent_size = 0;
-    if(o.format_flags != option::f_usage_only)
+    bool try_to_place(const std::vector<std::pair<uint64_t, size_t> >& hashes)
     {
-        out << std::string(o.indent_size, ' ') << o.name << ": ";
-        std::string tmp = o.descr;
-        sub_indent_size = o.indent_size + o.name.size() - 2; // -2 because of ": "
-        if (sub_indent_size < 3)
+        // (indexes of hashes in each of buckets, buckets are placed biggest ones first)
+        std::vector<std::vector<uint32_t> > buckets(static_cast<size_t>(1) << bucket_bits);
+        for (size_t i = 0; i < count; i++)
         {
-            sub_indent_size = 3;
+            buckets[bucket_of(hashes[i].first)].push_back(static_cast<uint32_t>(i));
         }
-        indent_and_trim(tmp, sub_indent_size, DEFAULT_MAX_LINE_SIZE + o.name.size());
-        tmp.erase(0, sub_indent_size);
-        out << tmp;
-    }
-    else // always reset them to full afterwards..
-    {
-        o.format_flags = option::f_full_info;
-    }
-
-    sub_indent_size = o.name.size() - 5 + o.indent_size;
-    if (sub_indent_size < 0)
-    {
-        sub_indent_size = 3;
-    }
-
-    // add usage
-    try
-    {
-        doxy_dictionary::vector_of_string_pairs& brief = o.doxy_dict.get_occurences("brief");
-        doxy_dictionary::vector_of_string_pairs& params = o.doxy_dict.get_occurences("param");
-
-        if (brief.size() && params.size())
+        std::vector<std::pair<size_t, size_t> > order;
+        for (size_t b = 0; b < buckets.size(); b++)
         {
-            const int& number_of_params = params.size();
-            std::stringstream s;
-            s << "usage: " << split(o.name, " ,/|")[0] << " ";
-
-            // list parameters first, i.e. "option_name: <paramxx> <paramxy>"
-            for (int i = 0; i < number_of_params; i++)
+            if (buckets[b].size())
             {
-                s << "<" << params[i].first << "> "; // name of parameter
+                order.push_back(std::make_pair(buckets[b].size(), b));
             }
+        }
+        std::sort(order.begin(), order.end(), std::greater<std::pair<size_t, size_t> >());
 
-            std::string first_line(s.str());
-            indent_and_trim(first_line, sub_indent_size,
-                            DEFAULT_MAX_LINE_SIZE + sub_indent_size + 8,
-                            o.name.size() + 8); // indent by "usage: option_name"
-            out << first_line;
+        slots.assign(static_cast<size_t>(1) << bits, NULL);
+        displacements.assign(buckets.size(), 0);
+        std::vector<size_t> placed;
+        size_t next_free = 0;
+        for (size_t o = 0; o < order.size(); o++)
+        {
+            const std::vector<uint32_t>& bucket = buckets[order[o].second];
+            if (bucket.size() == 1)
+            {
+                while (slots[next_free] != NULL)
+                {
+                    next_free++;
+                }
+                slots[next_free] = &items[hashes[bucket[0]].second];
+                displacements[order[o].second] = direct | static_cast<uint32_t>(next_free);
+                continue;
+            }
 
-             // now the description for each of these parameters
-            std::stringstream u(o.usage);
-            std::string curr;
-            for (int i = 0; i < number_of_params; i++)
+            uint32_t d = 0;
+            for (; d < max_displacement; d++)
             {
-                u >> curr;
-                replace_all(curr, "<", "(");
-                replace_all(curr, ">", ")");
-                #ifdef ENDL_BETWEEN_OPTION_DESC
-                if (i != 0)
+                placed.clear();
+                for (size_t i = 0; i < bucket.size(); i++)
                 {
-                    out << std::string(8, ' ');
+                    size_t slot = displaced_slot(hashes[bucket[i]].first, d);
+                    if (slots[slot] != NULL ||
+                        std::find(placed.begin(), placed.end(), slot) != placed.end())
+                    {
+                        break;
+                    }
+                    placed.push_back(slot);
                 }
-                #endif
-                curr = params[i].first + curr + ": "; // name
-                indent_and_trim(curr, sub_indent_size + 3);
-                curr.erase(curr.find_last_of("\n"), curr.size());
-                curr += params[i].second; // description
-                indent_and_trim(curr, sub_indent_size + 3);
-                curr.erase(curr.find_last_of(" "), curr.size());
-                #ifdef ENDL_BETWEEN_OPTION_DESC
-                out << "\n" ;
-                #endif
-                out << curr << "\n";
+                if (placed.size() == bucket.size())
+                {
+                    break;
+                }
+            }
+            if (d == max_displacement)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < bucket.size(); i++)
+            {
+                slots[placed[i]] = &items[hashes[bucket[i]].second];
             }
+            displacements[order[o].second] = d;
         }
-    } catch (...)
-    {
-        // This will happen if option params were not extracted with the doxydict.
-        out << std::string(sub_indent_size, ' ');
-        out << "usage: " << split(o.name, " ,/|")[0] << " " << o.usage;
+        return true;
     }
-    return out;
-}
 
+    const item_type* items;
+    size_t count;
+    unsigned int bits;
+    unsigned int bucket_bits;
+    std::vector<uint32_t> displacements; // (of each of buckets)
+    std::vector<const item_type*> slots;
+    std::string usage_str;
+};
 
 /**
- * @brief Template for options taking no parameters.
- *        This template will be created / used to create a command-line options
- *        using existing functions that take no parameters.
+ * @brief Specialisation of param_extractor for "choice" type.
  */
-template<typename Fcn>
-class option_no_params: public option
+template<class Traits>
+class param_extractor<choice<Traits> >
 {
 public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     */
-    option_no_params(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
-    {
-    }
-
-    /**
-     * @brief  Does nothing for this option type.
+     * @brief See generic template for description
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    static choice<Traits> extract(std::stringstream& from)
     {
+        std::string token = get_next_token(from);
+        const choice_item<typename Traits::type>* item = choice_table<Traits>::instance().find(token);
+        if (item == NULL)
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token << "\"";
+            throw option_error(err.str());
+        }
+        return choice<Traits>(item->value);
     }
 
     /**
-     * @brief Execute method. Calls to the function.
-     */
-    virtual void execute()
-    {
-        f();
-    }
-protected:
-    /**
-     * @brief Hide default constructor to allow creating only named-options.
+     * @brief see generic template for description
      */
-    option_no_params()
+    static std::string usage()
     {
+        return choice_table<Traits>::instance().usage();
     }
-    Fcn f;
 };
 
 /**
- * @brief Template for options taking one parameter.
- *        This template will be created / used to create a command-line options
- *        using existing functions that take one parameter of type P1.
+ * @brief Parameter capturing all following arguments, up to the next option, help (e.g. "-h")
+ *        or the stats command (or the end of the command line), e.g. for:
+ *        "--files a b c --verbose", "--files" will get "a b c".
+ *        Arguments are not copied: it refers to them in argv passed to run() (so it's only
+ *        valid as long as that argv is). It could be the last parameter of an option, e.g.:
+ *
+ * @code
+ * void files(rest_of_args names)
+ * {
+ *     for (size_t i = 0; i < names.size(); i++)
+ *     {
+ *         std::cout << names[i] << "\n";
+ *     }
+ * }
+ * @endcode
  */
-template<typename Fcn, typename P1>
-class option_1_param: public option
+class rest_of_args
 {
 public:
-    /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter type.
-     */
-    option_1_param(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
+    typedef char* const* const_iterator;
+
+    rest_of_args() :
+                    args(NULL),
+                    count(0)
     {
+    }
 
-        if(doxy_dict.found_tokens("param"))
-        {
-            std::pair<std::string, std::string> name_desc = doxy_dict.dict["param"].front();
-        }
+    rest_of_args(char* const* first, size_t num_args) :
+                    args(first),
+                    count(num_args)
+    {
+    }
 
-        usage = param_extractor<P1>::usage();
+    size_t size() const
+    {
+        return count;
     }
 
-    /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
-     */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    bool empty() const
     {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
+        return count == 0;
     }
 
-    /**
-     * @brief Calls the requested function.
-     */
-    virtual void execute()
+    const char* operator[](size_t index) const
     {
-        f(p1);
+        return args[index];
     }
-protected:
 
-    virtual int num_params()
+    const_iterator begin() const
     {
-        return 1;
+        return args;
     }
 
-    option_1_param()
+    const_iterator end() const
     {
+        return args + count;
     }
-    Fcn f;
-    P1 p1;
+
+private:
+    char* const* args;
+    size_t count;
 };
 
-template<typename Fcn, typename P1, typename P2>
-class option_2_params: public option
+/**
+ * @brief Specialisation of param_extractor for "rest_of_args" type.
+ */
+template<>
+class param_extractor<rest_of_args>
 {
 public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief See generic template for description
      */
-    option_2_params(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
+    static rest_of_args extract(std::stringstream& from)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage();
-    }
+        cmd_line_stream* cmd_line = dynamic_cast<cmd_line_stream*>(&from);
+        if (cmd_line == NULL)
+        {
+            std::stringstream err;
+            err << usage() << " can only be extracted from the command line";
+            throw option_error(err.str());
+        }
 
-    /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
-     */
-    virtual void extract_params(std::stringstream& cmd_line_options)
-    {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
+        int first = cmd_line->next_arg();
+        int last = first;
+        while (last < cmd_line->argc() && !cmd_line->ends_params(last))
+        {
+            last++;
+        }
+        cmd_line->seek_arg(last);
+        return rest_of_args(cmd_line->argv() + first, last - first);
     }
 
     /**
-     * @brief Calls the requested function.
+     * @brief see generic template for description
      */
-    virtual void execute()
+    static std::string usage()
     {
-        f(p1, p2);
+        return std::string("[<arg> ...]");
     }
-protected:
-    virtual int num_params()
+};
+
+/**
+ * @brief Binary data specified as text, e.g. hex_blob (for: "0a1b2c") or base64_blob.
+ *        Decoded bytes are held by the vector this class derives from, e.g.:
+ *
+ * @code
+ * void set_key(hex_blob key)
+ * {
+ *     use_key(&key[0], key.size());
+ * }
+ * @endcode
+ */
+template<typename Encoding>
+class blob: public std::vector<uint8_t>
+{
+};
+
+typedef blob<hex_encoding> hex_blob;
+typedef blob<base64_encoding> base64_blob;
+
+/**
+ * @brief Binary data of a fixed size, held in an array (i.e. no memory is allocated
+ *        for it), e.g. fixed_blob<hex_encoding, 32> for a 256-bit key.
+ */
+template<typename Encoding, size_t Size>
+class fixed_blob
+{
+public:
+    size_t size() const
     {
-        return 2;
+        return Size;
     }
 
-    option_2_params()
+    uint8_t& operator[](size_t index)
     {
+        return bytes[index];
     }
-    Fcn f;
-    P1 p1;
-    P2 p2;
+
+    const uint8_t& operator[](size_t index) const
+    {
+        return bytes[index];
+    }
+
+    uint8_t bytes[Size];
 };
 
-template<typename Fcn, typename P1, typename P2, typename P3>
-class option_3_params: public option
+/**
+ * @brief Helper for param_extractors of blobs: decodes the token.
+ * @param out - buffer for the result (of at least Encoding::max_decoded_size(token.size()) bytes).
+ * @return number of bytes decoded.
+ * @throws option_error if the token is not valid (with the offset of the first invalid character).
+ */
+template<typename Encoding>
+inline size_t decode_blob(const std::string& token, uint8_t* out)
+{
+    size_t decoded = 0;
+    size_t error_at = Encoding::decode(token.data(), token.size(), out, decoded);
+    if (token.empty() || error_at != blob_decode_ok)
+    {
+        std::stringstream err;
+        err << Encoding::usage() << ", got: \"" << token << "\"";
+        if (error_at == token.size())
+        {
+            err << " (truncated)";
+        }
+        else if (error_at != blob_decode_ok)
+        {
+            err << " (invalid character at offset " << error_at << ")";
+        }
+        throw option_error(err.str());
+    }
+    return decoded;
+}
+
+/**
+ * @brief Specialisation of param_extractor for "blob" types.
+ */
+template<class Encoding>
+class param_extractor<blob<Encoding> >
 {
 public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief See generic template for description
      */
-    option_3_params(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
+    static blob<Encoding> extract(std::stringstream& from)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage();
+        std::string token = get_next_token(from);
+        blob<Encoding> param;
+        param.resize(Encoding::max_decoded_size(token.size()));
+        param.resize(decode_blob<Encoding>(token, param.empty() ? NULL : &param[0]));
+        return param;
     }
 
     /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
+     * @brief see generic template for description
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    static std::string usage()
     {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
+        return Encoding::usage();
     }
+};
 
+/**
+ * @brief Specialisation of param_extractor for "fixed_blob" types.
+ */
+template<class Encoding, size_t Size>
+class param_extractor<fixed_blob<Encoding, Size> >
+{
+public:
     /**
-     * @brief Calls the requested function.
+     * @brief See generic template for description
      */
-    virtual void execute()
-    {
-        f(p1, p2, p3);
-    }
-protected:
-    virtual int num_params()
+    static fixed_blob<Encoding, Size> extract(std::stringstream& from)
     {
-        return 3;
+        std::string token = get_next_token(from);
+        fixed_blob<Encoding, Size> param;
+        uint8_t buffer[Size + 3]; // max_decoded_size() could be bigger by up to 2 bytes
+        size_t decoded = Size + 1;
+        if (Encoding::max_decoded_size(token.size()) <= sizeof(buffer))
+        {
+            decoded = decode_blob<Encoding>(token, buffer);
+        }
+        if (decoded != Size)
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token << "\"";
+            throw option_error(err.str());
+        }
+        memcpy(param.bytes, buffer, Size);
+        return param;
     }
 
-    option_3_params()
+    /**
+     * @brief see generic template for description
+     */
+    static std::string usage()
     {
+        std::stringstream usg;
+        usg << Encoding::usage() << "(" << Size << " bytes)";
+        return usg.str();
     }
-    Fcn f;
-    P1 p1;
-    P2 p2;
-    P3 p3;
 };
 
-template<typename Fcn, typename P1, typename P2, typename P3, typename P4>
-class option_4_params: public option
+/**
+ * @brief Range of (unsigned) numbers, e.g. "0-1048575:8" (from 0 to 1048575, every 8th) or
+ *        a union of such ranges: "1,5-9,100-200:10". Numbers are never expanded: only
+ *        the ranges (segments) are stored, and numbers are computed when they are accessed.
+ *        Numbers can be accessed by their index, so e.g. the range could be split into parts
+ *        to be processed by multiple threads (see part()).
+ */
+class index_range
 {
 public:
+    typedef uint64_t value_type;
+
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief Numbers from first to last (inclusive), every stride.
      */
-    option_4_params(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
+    struct segment
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage() + " ";
-        usage += param_extractor<P4>::usage();
-    }
+        value_type first;
+        value_type last; // (the last number that belongs to the segment)
+        value_type stride;
+
+        size_t size() const
+        {
+            return static_cast<size_t>((last - first) / stride) + 1;
+        }
+    };
 
     /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
+     * @brief Forward iterator over numbers in the range.
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef index_range::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef value_type reference;
+
+        const_iterator(const index_range* r = NULL, size_t segment_index = 0) :
+                        range(r),
+                        seg(segment_index),
+                        value(0)
+        {
+            if (range != NULL && seg < range->segs.size())
+            {
+                value = range->segs[seg].first;
+            }
+        }
+
+        value_type operator*() const
+        {
+            return value;
+        }
+
+        const_iterator& operator++()
+        {
+            const segment& s = range->segs[seg];
+            if (s.last - value >= s.stride)
+            {
+                value += s.stride;
+            }
+            else
+            {
+                *this = const_iterator(range, seg + 1);
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator prev(*this);
+            ++(*this);
+            return prev;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return seg == other.seg && value == other.value;
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const index_range* range;
+        size_t seg;
+        value_type value;
+    };
+
+    index_range() :
+                    count(0)
     {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
-        params_extracted++;
-        p4 = param_extractor<P4>::extract(cmd_line_options);
     }
 
     /**
-     * @brief Calls the requested function.
+     * @brief Adds a segment to the range.
+     * @throws option_error if the segment is not valid (last < first, stride is 0, or the
+     *         range would have too many numbers for size() to be returned).
      */
-    virtual void execute()
+    void add(value_type first, value_type last, value_type stride = 1)
     {
-        f(p1, p2, p3, p4);
+        const size_t max_size = static_cast<size_t>(-1);
+        if (last < first || stride == 0 || (last - first) / stride >= max_size ||
+            static_cast<size_t>((last - first) / stride) >= max_size - count)
+        {
+            std::stringstream err;
+            err << "range " << first << "-" << last << ":" << stride << " is not valid";
+            throw option_error(err.str());
+        }
+        segment s;
+        s.first = first;
+        s.last = last - (last - first) % stride;
+        s.stride = stride;
+        segs.push_back(s);
+        count += s.size();
     }
-protected:
-    virtual int num_params()
+
+    /**
+     * @brief Returns number of numbers in the range (numbers that belong to more than one
+     *        of segments are counted each time).
+     */
+    size_t size() const
     {
-        return 4;
+        return count;
     }
 
-    option_4_params()
+    bool empty() const
     {
+        return count == 0;
     }
-    Fcn f;
-    P1 p1;
-    P2 p2;
-    P3 p3;
-    P4 p4;
-};
 
-template<typename Fcn, typename P1, typename P2, typename P3, typename P4, typename P5>
-class option_5_params: public option
-{
-public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief Returns true if the number belongs to the range.
      */
-    option_5_params(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
+    bool contains(value_type value) const
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage() + " ";
-        usage += param_extractor<P4>::usage() + " ";
-        usage += param_extractor<P5>::usage();
+        for (size_t i = 0; i < segs.size(); i++)
+        {
+            const segment& s = segs[i];
+            if (value >= s.first && value <= s.last && (value - s.first) % s.stride == 0)
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
     /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
+     * @brief Returns number of the specified index (0 .. size() - 1).
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    value_type operator[](size_t index) const
     {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
-        params_extracted++;
-        p4 = param_extractor<P4>::extract(cmd_line_options);
-        params_extracted++;
-        p5 = param_extractor<P5>::extract(cmd_line_options);
+        size_t i = 0;
+        while (index >= segs[i].size())
+        {
+            index -= segs[i++].size();
+        }
+        return segs[i].first + static_cast<value_type>(index) * segs[i].stride;
     }
 
     /**
-     * @brief Calls the requested function.
+     * @brief Returns one of num_parts (nearly) equal, consecutive parts of this range,
+     *        e.g. to be processed by one of num_parts threads.
+     * @throws option_error if part_index is not less than num_parts.
      */
-    virtual void execute()
+    index_range part(size_t part_index, size_t num_parts) const
     {
-        f(p1, p2, p3, p4, p5);
+        if (part_index >= num_parts)
+        {
+            std::stringstream err;
+            err << "part " << part_index << " of " << num_parts << " is not valid";
+            throw option_error(err.str());
+        }
+        index_range res;
+        size_t begin = count / num_parts * part_index + std::min(part_index, count % num_parts);
+        size_t size = count / num_parts + (part_index < count % num_parts ? 1 : 0);
+        for (size_t i = 0; i < segs.size() && size > 0; i++)
+        {
+            const segment& s = segs[i];
+            if (begin >= s.size())
+            {
+                begin -= s.size();
+                continue;
+            }
+            size_t taken = std::min(size, s.size() - begin);
+            value_type first = s.first + static_cast<value_type>(begin) * s.stride;
+            res.add(first, first + static_cast<value_type>(taken - 1) * s.stride, s.stride);
+            size -= taken;
+            begin = 0;
+        }
+        return res;
     }
-protected:
-    virtual int num_params()
+
+    const_iterator begin() const
     {
-        return 5;
+        return const_iterator(this, 0);
     }
 
-    option_5_params()
+    const_iterator end() const
     {
+        return const_iterator(this, segs.size());
     }
-    Fcn f;
-    P1 p1;
-    P2 p2;
-    P3 p3;
-    P4 p4;
-    P5 p5;
+
+    const std::vector<segment>& segments() const
+    {
+        return segs;
+    }
+
+private:
+    std::vector<segment> segs;
+    size_t count;
 };
 
-template<typename Fcn, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
-class option_6_params: public option
+/**
+ * @brief Specialisation of param_extractor for "index_range" type.
+ */
+template<>
+class param_extractor<index_range>
 {
 public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief See generic template for description
      */
-    option_6_params(Fcn f_ptr, std::string& name) :
-                    option(name), f(f_ptr)
+    static index_range extract(std::stringstream& from)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage() + " ";
-        usage += param_extractor<P4>::usage() + " ";
-        usage += param_extractor<P5>::usage() + " ";
-        usage += param_extractor<P6>::usage();
-    }
+        std::string token = get_next_token(from);
+        index_range range;
+        const char* p = token.c_str();
+        bool valid = token.size() > 0;
+        while (valid)
+        {
+            index_range::value_type first = 0;
+            index_range::value_type last = 0;
+            index_range::value_type stride = 1;
+            valid = parse_number(p, first);
+            last = first;
+            if (valid && *p == '-')
+            {
+                valid = parse_number(++p, last) && last >= first;
+                if (valid && *p == ':')
+                {
+                    valid = parse_number(++p, stride) && stride > 0;
+                }
+            }
+            if (valid)
+            {
+                range.add(first, last, stride);
+                if (*p != ',')
+                {
+                    valid = (*p == 0);
+                    break;
+                }
+                p++;
+            }
+        }
 
-    /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
-     */
-    virtual void extract_params(std::stringstream& cmd_line_options)
-    {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
-        params_extracted++;
-        p4 = param_extractor<P4>::extract(cmd_line_options);
-        params_extracted++;
-        p5 = param_extractor<P5>::extract(cmd_line_options);
-        params_extracted++;
-        p6 = param_extractor<P6>::extract(cmd_line_options);
+        if (!valid)
+        {
+            std::stringstream err;
+            err << usage() << ", got: \"" << token << "\"";
+            throw option_error(err.str());
+        }
+        return range;
     }
 
     /**
-     * @brief Calls the requested function.
+     * @brief see generic template for description
      */
-    virtual void execute()
-    {
-        f(p1, p2, p3, p4, p5, p6);
-    }
-protected:
-    virtual int num_params()
+    static std::string usage()
     {
-        return 6;
+        return std::string("<first[-last[:step]],...>");
     }
 
-    option_6_params()
+private:
+    static bool parse_number(const char*& p, index_range::value_type& value)
     {
+        const index_range::value_type max_value = static_cast<index_range::value_type>(-1);
+        const char* start = p;
+        value = 0;
+        for (; *p >= '0' && *p <= '9'; p++)
+        {
+            index_range::value_type digit = *p - '0';
+            if (value > (max_value - digit) / 10)
+            {
+                return false; // overflow
+            }
+            value = value * 10 + digit;
+        }
+        return p != start;
     }
-    Fcn f;
-    P1 p1;
-    P2 p2;
-    P3 p3;
-    P4 p4;
-    P5 p5;
-    P6 p6;
 };
 
-template<typename Fcn, typename ObjType>
-class option_no_params_pass_obj: public option
+/**
+ * @brief Descriptive (cold) part of an option: everything that is needed only while
+ *        the option is set-up or while help / errors are printed. It's kept separately,
+ *        so that the option itself (its name, id and the handler with parameters) stays
+ *        small for the parsing path.
+ */
+struct option_doc
 {
-public:
-    /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     */
-    option_no_params_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
-                    option(name), f(f_ptr), obj_addr(object_address)
+    option_doc() :
+                    description_pending(false),
+                    indent_size(0),
+                    format_flags(f_full_info)
     {
     }
 
-    /**
-     * @brief  Empty implementation of a pure-virtual...nothing to extract this time..
-     * @param  Input stream from which next token points to the parameter that needs to be extracted.
-     */
-    virtual void extract_params(std::stringstream& /*cmd_line_options*/)
-    {
-        return;
-    }
+    typedef std::vector<std::string> Container;
 
-    /**
-     * @brief Calls the requested function passing it an address of the object specified when
-     *        this option was created.
-     */
-    virtual void execute()
-    {
-        f(obj_addr);
-    }
-protected:
+    std::string usage;
+    std::string descr;
+    bool description_pending;
 
+    Container required_options;
+    Container not_wanted_options;
 
-    option_no_params_pass_obj() :
-                    obj_addr(NULL)
+    doxy_dictionary doxy_dict;
+    int indent_size;
+
+    enum formatting_flags
     {
-    }
-    Fcn f;
-    ObjType* obj_addr;
+        f_full_info = 0,
+        f_usage_only = 1
+    };
+    int format_flags;
 };
 
-template<typename Fcn, typename ObjType, typename P1>
-class option_1_param_pass_obj: public option
+/**
+ * @brief Base class for options. It is mainly to provide a common interface
+ *        To allow all options (sort of 'commands' to be called using a common interface).
+ */
+class option
 {
 public:
     /**
      * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter type.
+     * @param  option_name - name of the option. It will be used also as a key that the option
+     *         is selected from the command line.
      */
-    option_1_param_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
-                    option(name), f(f_ptr), obj_addr(object_address)
+    option(std::string& option_name) :
+                    standalone(false),
+                    repeated(each_occurrence),
+                    name(option_name),
+                    id(0),
+                    params_extracted(0),
+                    doc(new option_doc)
+    {
+    }
+    /**
+     * @brief Destructor.
+     */
+    virtual ~option()
     {
-        usage = param_extractor<P1>::usage();
+        delete doc;
     }
 
     /**
@@ -1978,160 +2567,332 @@ public:
      * @param  input stream from which next token points to the parameter that needs to be extracted.
      * @throws option_error if param can't be extracted.
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
-    {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-    }
+    virtual void extract_params(std::stringstream& cmd_line_options) = 0;
 
     /**
-     * @brief Calls the requested function, passing both: the address of object and extracted parameter.
+     * @brief Releases the descriptive part of the option (see option_doc). Once this is done,
+     *        the option can still be parsed and executed, but it can't be described (doc is NULL).
      */
-    virtual void execute()
-    {
-        f(obj_addr, p1);
-    }
-protected:
-    virtual int num_params()
+    void release_doc()
     {
-        return 1;
+        delete doc;
+        doc = NULL;
     }
 
-    option_1_param_pass_obj() :
-                    obj_addr(NULL)
+    /**
+     * @brief Called when the option is found in the command line for the first time (before
+     *        its parameters are extracted). Options that collect parameters of all occurrences
+     *        should forget these found in previous command lines here.
+     */
+    virtual void clear_params()
     {
     }
-    Fcn f;
-    ObjType* obj_addr;
-    P1 p1;
-};
 
-template<typename Fcn, typename ObjType, typename P1, typename P2>
-class option_2_params_pass_obj: public option
-{
-public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief adds another option that this option requires
      */
-    option_2_params_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
-                    option(name), f(f_ptr), obj_addr(object_address)
+    void add_required_option(const std::string& option_name)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage();
+        doc->required_options.push_back(option_name);
     }
 
     /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
+     * @brief adds another option that this option must not be specified with.
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    void add_not_wanted_option(const std::string& option_name)
     {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
+        doc->not_wanted_options.push_back(option_name);
     }
 
     /**
-     * @brief Calls the requested function,
-     *        passing both: the address of object and extracted parameters.
+     * @brief sets this option as a standalone (i.e. it must not be specified with any other option).
      */
-    virtual void execute()
+    void set_as_standalone()
     {
-        f(obj_addr, p1, p2);
+        standalone = true;
     }
-protected:
-    virtual int num_params()
+
+    /**
+     * @brief What happens if the option is specified more than once.
+     */
+    enum repeat_policy
     {
-        return 2;
-    }
+        each_occurrence, // the handler is executed for each of them
+        first_wins,      // the handler is executed once, with parameters of the first one
+        last_wins,       // the handler is executed once, with parameters of the last one
+        all_at_once      // the handler is executed once, with parameters of all of them
+    };
 
-    option_2_params_pass_obj() :
-                    obj_addr(NULL)
+    /**
+     * @brief sets what happens if this option is specified more than once.
+     */
+    void set_repeat_policy(repeat_policy policy)
     {
+        repeated = policy;
     }
-    Fcn f;
-    ObjType* obj_addr;
-    P1 p1;
-    P2 p2;
-};
 
-template<typename Fcn, typename ObjType, typename P1, typename P2, typename P3>
-class option_3_params_pass_obj: public option
-{
-public:
     /**
-     * @brief Constructor.
-     * @param name - name of the option.
-     *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
+     * @brief Set the description of the program.
+     * @param description - a sort of brief that would usually say what your tool is meant for etc.
      */
-    option_3_params_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
-                    option(name), f(f_ptr), obj_addr(object_address)
+    void set_description(std::string& description)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage();
+        doc->descr = description;
+        if (doc->doxy_dict.setup(description))
+        {
+            try
+            {
+                const doxy_dictionary::occurrences& brief = doc->doxy_dict.get_occurences("brief");
+                const doxy_dictionary::occurrences& params = doc->doxy_dict.get_occurences("param");
+                doc->descr = doc->doxy_dict.text_of(brief.front().value);
+
+                const int& number_of_params = num_params();
+                const int& number_of_param_descr = params.size();
+                if(number_of_params != number_of_param_descr)
+                {
+                    std::stringstream err;
+                    err << "Error while parsing description for option \"";
+                    err << name.c_str() << "\": \nexpected to find " << number_of_params;
+                    err << " parameters, but found " << number_of_param_descr << ".";
+                    throw std::runtime_error(err.str());
+                }
+            }
+            catch(const doxy_dictionary::doxy_exception&)
+            {
+                // ok, doxy_parser not constructed, carry on
+            }
+            catch(...)
+            {
+                throw;
+            }
+        }
     }
+
     /**
-     * @brief  Attempts to extract the parameter.
-     * @param  input stream from which next token points to the parameter that needs to be extracted.
-     * @throws option_error if param can't be extracted.
+     * @brief Stores the description without processing it (i.e. without extracting doxygen
+     *        tags etc.). This is used if the schema is restored from the image, where help
+     *        is already rendered. Description will be processed only if it's needed later.
+     * @param description - description (it is swapped-in, i.e. no copy is made).
      */
-    virtual void extract_params(std::stringstream& cmd_line_options)
+    void set_pending_description(std::string& description)
     {
-        p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
+        doc->descr.swap(description);
+        doc->description_pending = true;
     }
 
     /**
-     * @brief Calls the requested function,
-     *        passing both: the address of object and extracted parameters.
+     * @brief Processes the description stored by set_pending_description() (if any).
      */
-    virtual void execute()
+    void complete_description()
     {
-        f(obj_addr, p1, p2, p3);
+        if (doc->description_pending)
+        {
+            std::string description;
+            description.swap(doc->descr);
+            doc->description_pending = false;
+            set_description(description);
+        }
     }
-protected:
-    virtual int num_params()
+
+    inline void fmt_usage_only()
     {
-        return 3;
+        doc->format_flags = option_doc::f_usage_only;
     }
 
-    option_3_params_pass_obj() :
-                    obj_addr(NULL)
+    inline void fmt_full_info()
     {
+        doc->format_flags = option_doc::f_full_info;
     }
-    Fcn f;
-    ObjType* obj_addr;
-    P1 p1;
-    P2 p2;
-    P3 p3;
+
+    void fmt_set_indent(int num_of_characters)
+    {
+        doc->indent_size = num_of_characters;
+    }
+
+    friend std::ostream& operator<<(std::ostream &out,  option& o);
+
+    virtual int num_params()
+    {
+        return 0; // default implementation..
+    }
+
+    /**
+     * @brief Main interface that will be called by the cmd_line_parser if it will match a method being called.
+     *        For each of the possible options - it will usually implement calls to type-dependent param_extractor
+     *        methods to extract parameters and, on success (i.e. once all parameters are extracted)- it will call
+     *        the function with these values.
+     */
+    virtual void execute() = 0;
+
+    typedef option_doc::Container Container;
+
+    bool standalone;
+    repeat_policy repeated;
+    std::string name;
+    size_t id;
+    size_t params_extracted;
+    option_doc* doc;
+
+private:
+    option(const option&);
+    option& operator=(const option&);
 };
 
-template<typename Fcn, typename ObjType, typename P1, typename P2, typename P3, typename P4>
-class option_4_params_pass_obj: public option
+inline std::ostream& operator<<(std::ostream &out,  option& o)
+{
+    o.complete_description();
+    out << "\n";
+    int sub_indent_size = 0;
+    if(o.doc->format_flags != option_doc::f_usage_only)
+    {
+        out << std::string(o.doc->indent_size, ' ') << o.name << ": ";
+        std::string tmp = o.doc->descr;
+        sub_indent_size = o.doc->indent_size + o.name.size() - 2; // -2 because of ": "
+        if (sub_indent_size < 3)
+        {
+            sub_indent_size = 3;
+        }
+        indent_and_trim(tmp, sub_indent_size, DEFAULT_MAX_LINE_SIZE + o.name.size());
+        tmp.erase(0, sub_indent_size);
+        out << tmp;
+    }
+    else // always reset them to full afterwards..
+    {
+        o.doc->format_flags = option_doc::f_full_info;
+    }
+
+    sub_indent_size = o.name.size() - 5 + o.doc->indent_size;
+    if (sub_indent_size < 0)
+    {
+        sub_indent_size = 3;
+    }
+
+    // add usage
+    try
+    {
+        const doxy_dictionary& dict = o.doc->doxy_dict;
+        const doxy_dictionary::occurrences& brief = dict.get_occurences("brief");
+        const doxy_dictionary::occurrences& params = dict.get_occurences("param");
+
+        if (brief.size() && params.size())
+        {
+            const int& number_of_params = params.size();
+            std::stringstream s;
+            s << "usage: " << split(o.name, " ,/|")[0] << " ";
+
+            // list parameters first, i.e. "option_name: <paramxx> <paramxy>"
+            for (int i = 0; i < number_of_params; i++)
+            {
+                s << "<" << dict.text_of(params[i].name) << "> "; // name of parameter
+            }
+
+            std::string first_line(s.str());
+            indent_and_trim(first_line, sub_indent_size,
+                            DEFAULT_MAX_LINE_SIZE + sub_indent_size + 8,
+                            o.name.size() + 8); // indent by "usage: option_name"
+            out << first_line;
+
+             // now the description for each of these parameters
+            std::stringstream u(o.doc->usage);
+            std::string curr;
+            for (int i = 0; i < number_of_params; i++)
+            {
+                u >> curr;
+                replace_all(curr, "<", "(");
+                replace_all(curr, ">", ")");
+                #ifdef ENDL_BETWEEN_OPTION_DESC
+                if (i != 0)
+                {
+                    out << std::string(8, ' ');
+                }
+                #endif
+                curr = dict.text_of(params[i].name) + curr + ": "; // name
+                indent_and_trim(curr, sub_indent_size + 3);
+                curr.erase(curr.find_last_of("\n"), curr.size());
+                curr += dict.text_of(params[i].value); // description
+                indent_and_trim(curr, sub_indent_size + 3);
+                curr.erase(curr.find_last_of(" "), curr.size());
+                #ifdef ENDL_BETWEEN_OPTION_DESC
+                out << "\n" ;
+                #endif
+                out << curr << "\n";
+            }
+        }
+    } catch (...)
+    {
+        // This will happen if option params were not extracted with the doxydict.
+        out << std::string(sub_indent_size, ' ');
+        out << "usage: " << split(o.name, " ,/|")[0] << " " << o.doc->usage;
+    }
+    return out;
+}
+
+
+/**
+ * @brief Template for options taking no parameters.
+ *        This template will be created / used to create a command-line options
+ *        using existing functions that take no parameters.
+ */
+template<typename Fcn>
+class option_no_params: public option
 {
 public:
     /**
      * @brief Constructor.
      * @param name - name of the option.
      *        This name is used as a keyword to select this option on the command line.
-     *        It also prepares a 'usage' string based on parameter types.
      */
-    option_4_params_pass_obj(Fcn f_ptr, ObjType* obj_address, std::string& name) :
-                    option(name), f(f_ptr), obj_addr(obj_address)
+    option_no_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+    }
+
+    /**
+     * @brief  Does nothing for this option type.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+    }
+
+    /**
+     * @brief Execute method. Calls to the function.
+     */
+    virtual void execute()
+    {
+        f();
+    }
+protected:
+    /**
+     * @brief Hide default constructor to allow creating only named-options.
+     */
+    option_no_params()
+    {
+    }
+    Fcn f;
+};
+
+/**
+ * @brief Template for options taking one parameter.
+ *        This template will be created / used to create a command-line options
+ *        using existing functions that take one parameter of type P1.
+ */
+template<typename Fcn, typename P1>
+class option_1_param: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter type.
+     */
+    option_1_param(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage() + " ";
-        usage += param_extractor<P4>::usage();
+
+        doc->usage = param_extractor<P1>::usage();
     }
+
     /**
      * @brief  Attempts to extract the parameter.
      * @param  input stream from which next token points to the parameter that needs to be extracted.
@@ -2140,43 +2901,31 @@ public:
     virtual void extract_params(std::stringstream& cmd_line_options)
     {
         p1 = param_extractor<P1>::extract(cmd_line_options);
-        params_extracted++;
-        p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
-        params_extracted++;
-        p4 = param_extractor<P4>::extract(cmd_line_options);
     }
 
     /**
-     * @brief Calls the requested function,
-     *        passing both: the address of object and extracted parameters.
+     * @brief Calls the requested function.
      */
     virtual void execute()
     {
-        f(obj_addr, p1, p2, p3, p4);
+        f(p1);
     }
 protected:
+
     virtual int num_params()
     {
-        return 4;
+        return 1;
     }
 
-
-    option_4_params_pass_obj() :
-                    obj_addr(NULL)
+    option_1_param()
     {
     }
     Fcn f;
-    ObjType* obj_addr;
     P1 p1;
-    P2 p2;
-    P3 p3;
-    P4 p4;
 };
 
-template<typename Fcn, typename ObjType, typename P1, typename P2, typename P3, typename P4, typename P5>
-class option_5_params_pass_obj: public option
+template<typename Fcn, typename P1, typename P2>
+class option_2_params: public option
 {
 public:
     /**
@@ -2185,15 +2934,13 @@ public:
      *        This name is used as a keyword to select this option on the command line.
      *        It also prepares a 'usage' string based on parameter types.
      */
-    option_5_params_pass_obj(Fcn f_ptr, ObjType* obj_address, std::string& name) :
-                    option(name), f(f_ptr), obj_addr(obj_address)
+    option_2_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
     {
-        usage = param_extractor<P1>::usage() + " ";
-        usage += param_extractor<P2>::usage() + " ";
-        usage += param_extractor<P3>::usage() + " ";
-        usage += param_extractor<P4>::usage() + " ";
-        usage += param_extractor<P5>::usage();
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage();
     }
+
     /**
      * @brief  Attempts to extract the parameter.
      * @param  input stream from which next token points to the parameter that needs to be extracted.
@@ -2204,388 +2951,3067 @@ public:
         p1 = param_extractor<P1>::extract(cmd_line_options);
         params_extracted++;
         p2 = param_extractor<P2>::extract(cmd_line_options);
-        params_extracted++;
-        p3 = param_extractor<P3>::extract(cmd_line_options);
-        params_extracted++;
-        p4 = param_extractor<P4>::extract(cmd_line_options);
-        params_extracted++;
-        p5 = param_extractor<P5>::extract(cmd_line_options);
     }
 
     /**
-     * @brief Calls the requested function,
-     *        passing both: the address of object and extracted parameters.
+     * @brief Calls the requested function.
      */
     virtual void execute()
     {
-        f(obj_addr, p1, p2, p3, p4, p5);
+        f(p1, p2);
     }
 protected:
     virtual int num_params()
     {
-        return 5;
+        return 2;
     }
 
-
-    option_5_params_pass_obj() :
-                    obj_addr(NULL)
+    option_2_params()
     {
     }
     Fcn f;
-    ObjType* obj_addr;
     P1 p1;
     P2 p2;
-    P3 p3;
-    P4 p4;
-    P5 p5;
 };
 
-/**
- * @brief Wrapper class used to keep options and information about their groups etc.
- */
-class grouped_options
+template<typename Fcn, typename P1, typename P2, typename P3>
+class option_3_params: public option
 {
 public:
     /**
-     * @brief TYpe for container used to keep options.
-     */
-    typedef alias_map<std::string, option*> OptionContainer;
-
-    /**
-     * @brief Destructor. Cleans up allocated options.
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
      */
-    ~grouped_options()
+    option_3_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
     {
-        OptionContainer::iterator i;
-        for (i = options.begin(); i != options.end(); i++)
-        {
-            delete *i;
-        }
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage();
     }
 
     /**
-     * @brief Adds new group for options. Once this method is called, all options that
-     *        Are added following this call will be added to this group (and listed under
-     *        this group in help message).
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
      */
-    void add_new_group(std::string name, std::string description = "")
+    virtual void extract_params(std::stringstream& cmd_line_options)
     {
-        groups.push_back(group(name, description));
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
     }
 
     /**
-     * @brief Adds new option.
+     * @brief Calls the requested function.
      */
-    void add_new_option(option* new_option)
+    virtual void execute()
+    {
+        f(p1, p2, p3);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 3;
+    }
+
+    option_3_params()
+    {
+    }
+    Fcn f;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+};
+
+template<typename Fcn, typename P1, typename P2, typename P3, typename P4>
+class option_4_params: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_4_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage() + " ";
+        doc->usage += param_extractor<P4>::usage();
+    }
+
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
+        params_extracted++;
+        p4 = param_extractor<P4>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function.
+     */
+    virtual void execute()
+    {
+        f(p1, p2, p3, p4);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 4;
+    }
+
+    option_4_params()
+    {
+    }
+    Fcn f;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+    P4 p4;
+};
+
+template<typename Fcn, typename P1, typename P2, typename P3, typename P4, typename P5>
+class option_5_params: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_5_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage() + " ";
+        doc->usage += param_extractor<P4>::usage() + " ";
+        doc->usage += param_extractor<P5>::usage();
+    }
+
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
+        params_extracted++;
+        p4 = param_extractor<P4>::extract(cmd_line_options);
+        params_extracted++;
+        p5 = param_extractor<P5>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function.
+     */
+    virtual void execute()
+    {
+        f(p1, p2, p3, p4, p5);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 5;
+    }
+
+    option_5_params()
+    {
+    }
+    Fcn f;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+    P4 p4;
+    P5 p5;
+};
+
+template<typename Fcn, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+class option_6_params: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_6_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage() + " ";
+        doc->usage += param_extractor<P4>::usage() + " ";
+        doc->usage += param_extractor<P5>::usage() + " ";
+        doc->usage += param_extractor<P6>::usage();
+    }
+
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
+        params_extracted++;
+        p4 = param_extractor<P4>::extract(cmd_line_options);
+        params_extracted++;
+        p5 = param_extractor<P5>::extract(cmd_line_options);
+        params_extracted++;
+        p6 = param_extractor<P6>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function.
+     */
+    virtual void execute()
+    {
+        f(p1, p2, p3, p4, p5, p6);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 6;
+    }
+
+    option_6_params()
+    {
+    }
+    Fcn f;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+    P4 p4;
+    P5 p5;
+    P6 p6;
+};
+
+/**
+ * @brief Template for options whose handler is executed once with parameters of all
+ *        occurrences of the option (see cmd_line_parser::add_aggregated_option()).
+ *        Parameters are collected in vectors: one for each of parameters.
+ */
+template<typename Fcn, typename P1>
+class option_aggregated_1_param: public option
+{
+public:
+    option_aggregated_1_param(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+        repeated = all_at_once;
+        doc->usage = param_extractor<P1>::usage();
+    }
+
+    virtual void clear_params()
+    {
+        p1.clear();
+    }
+
+    /**
+     * @brief  Attempts to extract parameters (of the next occurrence).
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1.push_back(param_extractor<P1>::extract(cmd_line_options));
+    }
+
+    /**
+     * @brief Calls the requested function (with parameters of all occurrences).
+     */
+    virtual void execute()
+    {
+        f(p1);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 1;
+    }
+
+    Fcn f;
+    std::vector<P1> p1;
+};
+
+template<typename Fcn, typename P1, typename P2>
+class option_aggregated_2_params: public option
+{
+public:
+    option_aggregated_2_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+        repeated = all_at_once;
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage();
+    }
+
+    virtual void clear_params()
+    {
+        p1.clear();
+        p2.clear();
+    }
+
+    /**
+     * @brief  Attempts to extract parameters (of the next occurrence).
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        P1 v1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        P2 v2 = param_extractor<P2>::extract(cmd_line_options);
+        p1.push_back(v1);
+        p2.push_back(v2);
+    }
+
+    /**
+     * @brief Calls the requested function (with parameters of all occurrences).
+     */
+    virtual void execute()
+    {
+        f(p1, p2);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 2;
+    }
+
+    Fcn f;
+    std::vector<P1> p1;
+    std::vector<P2> p2;
+};
+
+template<typename Fcn, typename P1, typename P2, typename P3>
+class option_aggregated_3_params: public option
+{
+public:
+    option_aggregated_3_params(Fcn f_ptr, std::string& name) :
+                    option(name), f(f_ptr)
+    {
+        repeated = all_at_once;
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage();
+    }
+
+    virtual void clear_params()
+    {
+        p1.clear();
+        p2.clear();
+        p3.clear();
+    }
+
+    /**
+     * @brief  Attempts to extract parameters (of the next occurrence).
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        P1 v1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        P2 v2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        P3 v3 = param_extractor<P3>::extract(cmd_line_options);
+        p1.push_back(v1);
+        p2.push_back(v2);
+        p3.push_back(v3);
+    }
+
+    /**
+     * @brief Calls the requested function (with parameters of all occurrences).
+     */
+    virtual void execute()
+    {
+        f(p1, p2, p3);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 3;
+    }
+
+    Fcn f;
+    std::vector<P1> p1;
+    std::vector<P2> p2;
+    std::vector<P3> p3;
+};
+
+template<typename Fcn, typename ObjType>
+class option_no_params_pass_obj: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     */
+    option_no_params_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
+                    option(name), f(f_ptr), obj_addr(object_address)
+    {
+    }
+
+    /**
+     * @brief  Empty implementation of a pure-virtual...nothing to extract this time..
+     * @param  Input stream from which next token points to the parameter that needs to be extracted.
+     */
+    virtual void extract_params(std::stringstream& /*cmd_line_options*/)
+    {
+        return;
+    }
+
+    /**
+     * @brief Calls the requested function passing it an address of the object specified when
+     *        this option was created.
+     */
+    virtual void execute()
+    {
+        f(obj_addr);
+    }
+protected:
+
+
+    option_no_params_pass_obj() :
+                    obj_addr(NULL)
+    {
+    }
+    Fcn f;
+    ObjType* obj_addr;
+};
+
+template<typename Fcn, typename ObjType, typename P1>
+class option_1_param_pass_obj: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter type.
+     */
+    option_1_param_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
+                    option(name), f(f_ptr), obj_addr(object_address)
+    {
+        doc->usage = param_extractor<P1>::usage();
+    }
+
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function, passing both: the address of object and extracted parameter.
+     */
+    virtual void execute()
+    {
+        f(obj_addr, p1);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 1;
+    }
+
+    option_1_param_pass_obj() :
+                    obj_addr(NULL)
+    {
+    }
+    Fcn f;
+    ObjType* obj_addr;
+    P1 p1;
+};
+
+template<typename Fcn, typename ObjType, typename P1, typename P2>
+class option_2_params_pass_obj: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_2_params_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
+                    option(name), f(f_ptr), obj_addr(object_address)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage();
+    }
+
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function,
+     *        passing both: the address of object and extracted parameters.
+     */
+    virtual void execute()
+    {
+        f(obj_addr, p1, p2);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 2;
+    }
+
+    option_2_params_pass_obj() :
+                    obj_addr(NULL)
+    {
+    }
+    Fcn f;
+    ObjType* obj_addr;
+    P1 p1;
+    P2 p2;
+};
+
+template<typename Fcn, typename ObjType, typename P1, typename P2, typename P3>
+class option_3_params_pass_obj: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_3_params_pass_obj(Fcn f_ptr, ObjType* object_address, std::string& name) :
+                    option(name), f(f_ptr), obj_addr(object_address)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage();
+    }
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function,
+     *        passing both: the address of object and extracted parameters.
+     */
+    virtual void execute()
+    {
+        f(obj_addr, p1, p2, p3);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 3;
+    }
+
+    option_3_params_pass_obj() :
+                    obj_addr(NULL)
+    {
+    }
+    Fcn f;
+    ObjType* obj_addr;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+};
+
+template<typename Fcn, typename ObjType, typename P1, typename P2, typename P3, typename P4>
+class option_4_params_pass_obj: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_4_params_pass_obj(Fcn f_ptr, ObjType* obj_address, std::string& name) :
+                    option(name), f(f_ptr), obj_addr(obj_address)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage() + " ";
+        doc->usage += param_extractor<P4>::usage();
+    }
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
+        params_extracted++;
+        p4 = param_extractor<P4>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function,
+     *        passing both: the address of object and extracted parameters.
+     */
+    virtual void execute()
+    {
+        f(obj_addr, p1, p2, p3, p4);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 4;
+    }
+
+
+    option_4_params_pass_obj() :
+                    obj_addr(NULL)
+    {
+    }
+    Fcn f;
+    ObjType* obj_addr;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+    P4 p4;
+};
+
+template<typename Fcn, typename ObjType, typename P1, typename P2, typename P3, typename P4, typename P5>
+class option_5_params_pass_obj: public option
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name - name of the option.
+     *        This name is used as a keyword to select this option on the command line.
+     *        It also prepares a 'usage' string based on parameter types.
+     */
+    option_5_params_pass_obj(Fcn f_ptr, ObjType* obj_address, std::string& name) :
+                    option(name), f(f_ptr), obj_addr(obj_address)
+    {
+        doc->usage = param_extractor<P1>::usage() + " ";
+        doc->usage += param_extractor<P2>::usage() + " ";
+        doc->usage += param_extractor<P3>::usage() + " ";
+        doc->usage += param_extractor<P4>::usage() + " ";
+        doc->usage += param_extractor<P5>::usage();
+    }
+    /**
+     * @brief  Attempts to extract the parameter.
+     * @param  input stream from which next token points to the parameter that needs to be extracted.
+     * @throws option_error if param can't be extracted.
+     */
+    virtual void extract_params(std::stringstream& cmd_line_options)
+    {
+        p1 = param_extractor<P1>::extract(cmd_line_options);
+        params_extracted++;
+        p2 = param_extractor<P2>::extract(cmd_line_options);
+        params_extracted++;
+        p3 = param_extractor<P3>::extract(cmd_line_options);
+        params_extracted++;
+        p4 = param_extractor<P4>::extract(cmd_line_options);
+        params_extracted++;
+        p5 = param_extractor<P5>::extract(cmd_line_options);
+    }
+
+    /**
+     * @brief Calls the requested function,
+     *        passing both: the address of object and extracted parameters.
+     */
+    virtual void execute()
+    {
+        f(obj_addr, p1, p2, p3, p4, p5);
+    }
+protected:
+    virtual int num_params()
+    {
+        return 5;
+    }
+
+
+    option_5_params_pass_obj() :
+                    obj_addr(NULL)
+    {
+    }
+    Fcn f;
+    ObjType* obj_addr;
+    P1 p1;
+    P2 p2;
+    P3 p3;
+    P4 p4;
+    P5 p5;
+};
+
+/**
+ * @brief Wrapper class used to keep options and information about their groups etc.
+ *        Options are kept in order they were added (their position is their id), and
+ *        all their names / aliases are kept in the name_index.
+ */
+class grouped_options
+{
+public:
+    /**
+     * @brief TYpe for container used to keep options.
+     */
+    typedef std::vector<option*> OptionContainer;
+
+    grouped_options() :
+        image(NULL),
+        bulk(false),
+        bulk_first(0),
+        bulk_groups(0)
+    {
+    }
+
+    /**
+     * @brief Destructor. Cleans up allocated options.
+     */
+    ~grouped_options()
+    {
+        OptionContainer::iterator i;
+        for (i = options.begin(); i != options.end(); i++)
+        {
+            delete *i;
+        }
+    }
+
+    /**
+     * @brief Adds new group for options. Once this method is called, all options that
+     *        Are added following this call will be added to this group (and listed under
+     *        this group in help message).
+     */
+    void add_new_group(std::string name, std::string description = "")
+    {
+        groups.push_back(group(name, description));
+    }
+
+    /**
+     * @brief Adds new option.
+     */
+    void add_new_option(option* new_option)
+    {
+        if(new_option)
+        {
+            if (image != NULL)
+            {
+                detach_image();
+            }
+            if (bulk)
+            {
+                append(new_option); // (names are checked and indexed by end_bulk())
+                return;
+            }
+            check_names(new_option);
+            append(new_option);
+            index_names(new_option);
+        }
+    }
+
+    /**
+     * @brief Starts adding a number of options at once: containers are reserved up-front,
+     *        and names of options added until end_bulk() are checked and indexed in one go.
+     *        If the image is attached, options are added one by one as usual.
+     */
+    void begin_bulk(size_t number_of_options)
+    {
+        bulk = (image == NULL);
+        bulk_first = options.size();
+        bulk_groups = groups.size();
+        options.reserve(options.size() + number_of_options);
+    }
+
+    /**
+     * @brief Checks names of options added since begin_bulk() (sorting them, to find duplicates)
+     *        and adds them to the index.
+     * @throws option_error if any of these names is used already (options added since
+     *         begin_bulk() are removed in such case, see abort_bulk()).
+     */
+    void end_bulk()
+    {
+        if (!bulk)
+        {
+            return;
+        }
+        std::vector<name_span> names;
+        names.reserve((options.size() - bulk_first) * 2);
+        size_t pool_bytes = 0;
+        for (size_t id = bulk_first; id < options.size(); id++)
+        {
+            const std::string& all = options[id]->name;
+            size_t at = all.find_first_not_of(" ,/|");
+            while (at != std::string::npos)
+            {
+                size_t end = std::min(all.find_first_of(" ,/|", at), all.size());
+                name_span n = {all.data() + at, end - at, id};
+                names.push_back(n);
+                pool_bytes += n.size;
+                at = all.find_first_not_of(" ,/|", end);
+            }
+        }
+
+        std::vector<name_span> sorted(names);
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            if ((i > 0 && !(sorted[i - 1] < sorted[i])) || index.find(sorted[i].at, sorted[i].size))
+            {
+                std::stringstream err;
+                err << "add_new_option(\"" << options[sorted[i].id]->name << "\")";
+                err << ": another option was already defined with: \"";
+                err << std::string(sorted[i].at, sorted[i].size) << "\"!";
+                abort_bulk();
+                throw option_error(err.str());
+            }
+        }
+
+        index.reserve(index.size() + names.size(), index.pool_bytes() + pool_bytes);
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            index.insert(names[i].at, names[i].size, static_cast<uint32_t>(names[i].id));
+        }
+        bulk = false;
+    }
+
+    /**
+     * @brief Removes options (and groups) added since begin_bulk(). If their names were indexed
+     *        already (i.e. they were added one by one, see begin_bulk()), the index is re-built
+     *        from names of the remaining options.
+     */
+    void abort_bulk()
+    {
+        bool indexed = !bulk;
+        bulk = false;
+        for (size_t id = bulk_first; id < options.size(); id++)
+        {
+            delete options[id];
+        }
+        options.resize(bulk_first);
+        groups.erase(groups.begin() + bulk_groups, groups.end());
+        if (groups.size())
+        {
+            groups.back().remove_options_from(bulk_first);
+        }
+        if (indexed && image == NULL)
+        {
+            // (while the image is attached, its index is used: ids of removed options are not
+            // valid, and options added later must be the same as in the image)
+            index.clear();
+            OptionContainer::iterator i;
+            for (i = options.begin(); i != options.end(); i++)
+            {
+                index_names(*i);
+            }
+        }
+    }
+
+    /**
+     * @brief Uses names and help from the (loaded) image. Options added following this call
+     *        should be added using add_cached_option().
+     */
+    void attach_image(const schema_image& loaded_image)
+    {
+        const schema_image_header& h = loaded_image.header();
+        index.attach(loaded_image.slots(), h.slot_count, loaded_image.pool(), h.pool_size);
+        image = &loaded_image;
+    }
+
+    /**
+     * @brief Adds new option, that is already described by the attached image. Names of this option
+     *        are not indexed (index from the image is used instead).
+     * @return true if the option was added, false if it doesn't match the image (in which case
+     *         it is not added).
+     */
+    bool add_cached_option(option* new_option)
+    {
+        uint32_t next_id = static_cast<uint32_t>(options.size());
+        if (image == NULL || next_id >= image->header().option_count)
+        {
+            return false;
+        }
+
+        const schema_image_option& o = image->option_at(next_id);
+        if (!image->equals(o.name, new_option->name) ||
+            !image->equals(o.usage, new_option->doc->usage) ||
+            o.num_params != static_cast<uint32_t>(new_option->num_params()))
+        {
+            return false;
+        }
+        append(new_option);
+        return true;
+    }
+
+    /**
+     * @brief Stops using the image: names of all options are indexed again.
+     */
+    void detach_image()
+    {
+        image = NULL;
+        index.clear();
+        OptionContainer::iterator i;
+        for (i = options.begin(); i != options.end(); i++)
+        {
+            index_names(*i);
+        }
+    }
+
+    const schema_image* attached_image() const
+    {
+        return image;
+    }
+
+    /**
+     * @brief Releases descriptions of all options and information about groups
+     *        (see cmd_line_parser::compact()).
+     */
+    void compact()
+    {
+        OptionContainer::iterator i;
+        for (i = options.begin(); i != options.end(); i++)
+        {
+            (*i)->release_doc();
+        }
+        std::vector<group>().swap(groups);
+    }
+
+    /**
+     * @brief Fins option of a given name.
+     * @param name - name of the option to find.
+     * @return  - pointer to option if found, NULL otherwise.
+     */
+    option* find_option(const std::string& name) const
+    {
+        const name_index_slot* s = index.find(name);
+        if (s != NULL && s->id < options.size())
+        {
+            return options[s->id];
+        }
+        return NULL;
+    }
+
+    /**
+     * @brief Returns option of a given id.
+     */
+    option* option_at(size_t id) const
+    {
+        return options[id];
+    }
+
+    /**
+     * @brief Returns size of options.
+     */
+    size_t size() const
+    {
+        return options.size();
+    }
+
+    /**
+     * @brief Returns the name index (e.g. to be stored in the image).
+     */
+    const name_index& names() const
+    {
+        return index;
+    }
+
+    /**
+     * @brief Creates help using all information about options and their groups.
+     * @param help_content - stream into which help message is inserted.
+     */
+    void create_help(std::stringstream& help_content)
+    {
+        if (image != NULL)
+        {
+            help_content << image->text(image->header().help);
+            return;
+        }
+
+        size_t max_cmd_len = 0;
+        OptionContainer::iterator i;
+        for (i = options.begin(); i != options.end(); i++)
+        {
+            std::string &s = (*i)->name;
+            max_cmd_len = std::max<size_t>(max_cmd_len, s.length());
+        }
+        max_cmd_len++;
+
+        std::vector<group>::iterator g;
+        for(g = groups.begin(); g != groups.end(); g++)
+        {
+            help_content << "\n" << g->name();
+            if(g->description().length())
+                {
+                help_content << "(" << g->description() << ")";
+                }
+            help_content << ":\n";
+
+            group::options_iterator oi;
+            for (oi = g->options_begin(); oi != g->options_end(); oi++)
+            {
+                option* o = options[*oi];
+                const std::string& s = o->name;
+                // TODO: could assert here, just as a sanity check for development / changes
+                o->fmt_set_indent(max_cmd_len-s.length());
+                help_content << *o;
+                help_content << "\n\n";
+            }
+        }
+    }
+
+protected:
+
+    /**
+     * @brief Checks if none of names (aliases) of the new option is already used.
+     * @throws option_error if any of them is used already.
+     */
+    void check_names(option* new_option)
+    {
+        std::vector<std::string> aliases = split(new_option->name, " ,/|");
+        for(unsigned int i = 0; i < aliases.size(); i++)
+        {
+            bool used = index.find(aliases[i]) != NULL;
+            for(unsigned int j = 0; j < i && !used; j++)
+            {
+                used = (aliases[j] == aliases[i]);
+            }
+            if (used)
+            {
+                std::stringstream err;
+                err << "add_new_option(\"" << new_option->name << "\")";
+                if (i == 0)
+                {
+                    err << ": option \"" << aliases[i] << "\" already exists!";
+                }
+                else
+                {
+                    err << ": another option was already defined with: \"";
+                    err << aliases[i] << "\"!";
+                }
+                throw option_error(err.str());
+            }
+        }
+    }
+
+    /**
+     * @brief Adds names (aliases) of the option to the index.
+     */
+    void index_names(option* o)
+    {
+        std::vector<std::string> aliases = split(o->name, " ,/|");
+        for(unsigned int i = 0; i < aliases.size(); i++)
+        {
+            index.insert(aliases[i].data(), aliases[i].size(), static_cast<uint32_t>(o->id));
+        }
+    }
+
+    /**
+     * @brief Takes ownership of the option and adds it to the current group.
+     */
+    void append(option* new_option)
+    {
+        if(!groups.size())
+        {
+            add_new_group("Options");
+        }
+        new_option->id = options.size();
+        options.push_back(new_option);
+        groups.back().add_option(new_option->id);
+    }
+
+    /**
+     * @brief Helper class to allow associating options with groups.
+     */
+    class group
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param name - name of the group.
+         * @param (optional) description of the option group
+         */
+        explicit group(std::string name, std::string description = "") :
+            group_name(name), group_description(description)
+        {
+        }
+
+        /**
+         * @brief Returns name of the group.
+         */
+        std::string name()
+        {
+            return group_name;
+        }
+
+        /**
+         * @brief Returns description of the group.
+         */
+        std::string description()
+        {
+            return group_description;
+        }
+
+        /**
+         * @brief Adds option to the group.
+         */
+        void add_option(size_t id)
+        {
+            option_ids.push_back(id);
+        }
+
+        /**
+         * @brief Removes options of ids starting from the specified one.
+         */
+        void remove_options_from(size_t first_id)
+        {
+            while (option_ids.size() && option_ids.back() >= first_id)
+            {
+                option_ids.pop_back();
+            }
+        }
+
+        /**
+         * @brief Iterator for options.
+         */
+        typedef std::vector<size_t>::iterator options_iterator;
+
+        /**
+         * @brief Helper for iterators  to allow iterating through options within this group.
+         */
+        options_iterator options_begin()
+        {
+            return option_ids.begin();
+        }
+
+        /**
+         * @brief Helper for iterators  to allow iterating through options within this group.
+         */
+        options_iterator options_end()
+        {
+            return option_ids.end();
+        }
+
+    private:
+        std::string group_name;
+        std::string group_description;
+        std::vector<size_t> option_ids;
+    };
+
+    /**
+     * @brief Name (alias) of an option, i.e. a part of its (full) name.
+     */
+    struct name_span
+    {
+        const char* at;
+        size_t size;
+        size_t id;
+
+        bool operator<(const name_span& other) const
+        {
+            int res = memcmp(at, other.at, std::min(size, other.size));
+            return res < 0 || (res == 0 && size < other.size);
+        }
+    };
+
+    OptionContainer options;
+    std::vector<group> groups;
+    name_index index;
+    const schema_image* image;
+    bool bulk;
+    size_t bulk_first;
+    size_t bulk_groups;
+};
+
+/**
+ * @brief Handle of an option, returned when the option is added to the parser (see
+ *        cmd_line_parser::add_option()). Handles can be used instead of names of options
+ *        to set-up dependencies between them: this way the compiler checks that options
+ *        referred to exist, and there are no names to split and look-up at run-time.
+ */
+class option_handle
+{
+public:
+    option_handle() :
+        opt(NULL)
+    {
+    }
+
+    explicit option_handle(option* o) :
+        opt(o)
+    {
+    }
+
+    option* get() const
+    {
+        return opt;
+    }
+
+private:
+    option* opt;
+};
+
+/**
+ * @brief List of option handles, created using operator|, e.g.: a | b | c.
+ */
+class option_handle_list
+{
+public:
+    option_handle_list(const option_handle& h)
+    {
+        items.push_back(h.get());
+    }
+
+    option_handle_list& operator|(const option_handle& h)
+    {
+        items.push_back(h.get());
+        return *this;
+    }
+
+    size_t size() const
+    {
+        return items.size();
+    }
+
+    option* operator[](size_t i) const
+    {
+        return items[i];
+    }
+
+private:
+    std::vector<option*> items;
+};
+
+inline option_handle_list operator|(const option_handle& a, const option_handle& b)
+{
+    option_handle_list list(a);
+    list | b;
+    return list;
+}
+
+class cmd_line_parser;
+
+/**
+ * @brief Describes an option in a table of options, that are added all at once
+ *        (see cmd_line_parser::add_options()). e.g.:
+ *
+ *          static const cmd_line_option_entry table[] = {
+ *              {"v,--verbose", "sets verbosity @param level 0-3",
+ *               cmd_line_option_adder<void (*)(int), verbose>, "Output", NULL, NULL},
+ *              {"q,--quiet", "no output", cmd_line_option_adder<void (*)(), quiet>, NULL, NULL, "v"},
+ *          };
+ *          parser.add_options(table);
+ *
+ *        Such table can be constant-initialised (i.e. no code runs to create it).
+ */
+struct cmd_line_option_entry
+{
+    const char* name;        // name of the option (with its aliases)
+    const char* description;
+    void (*add_to)(cmd_line_parser& parser, const char* name, const char* description);
+    const char* group;       // if not NULL, a new group is started with this option
+    const char* required;    // if not NULL, list of options that this option requires
+    const char* not_wanted;  // if not NULL, list of options it can't be used with
+};
+
+/**
+ * @brief string describing help options.
+ */
+static const char* help_options = "\"?\", \"-h\" or \"--help\"";
+
+
+#if defined(__GNUC__) && defined(__ELF__)
+#define CMD_LINE_OPTIONS_STATIC_REGISTRATION
+
+class cmd_line_parser;
+
+/**
+ * @brief Descriptor of an option declared using CMD_LINE_OPTION() macro.
+ *        Descriptors are placed by the compiler in the "cmd_line_options" section, so that
+ *        the linker collects all of them (from all translation units) into one table.
+ *        They are constant-initialised (no code runs before main() to create them).
+ *        Each of them is explicitly aligned to the size of a pointer, otherwise the compiler
+ *        could pad them (and they could not be accessed as an array).
+ */
+struct cmd_line_option_descriptor
+{
+    const char* name;
+    const char* description;
+    void (*add_to)(cmd_line_parser& parser, const char* name, const char* description);
+};
+
+/**
+ * @brief Boundaries of the "cmd_line_options" section (provided by the linker). These are
+ *        weak, so that they are NULL if no option was declared using CMD_LINE_OPTION().
+ */
+extern "C" cmd_line_option_descriptor __start_cmd_line_options[] __attribute__((weak));
+extern "C" cmd_line_option_descriptor __stop_cmd_line_options[] __attribute__((weak));
+#endif /* __GNUC__ && __ELF__ */
+
+
+/**
+ * @brief This is the main class of this library.
+ */
+class cmd_line_parser: private cmd_line_boundaries
+{
+public:
+    /**
+     * @brief Options should be unique and referred by the key, so they are kept
+     *        by the parser using a map.
+     */
+    typedef grouped_options OptionContainer;
+
+    /**
+     * @brief What run_and_strip() did with the command line.
+     */
+    enum strip_result
+    {
+        not_valid,        // the command line was not valid (error was printed), argv is not changed
+        nothing_stripped, // it was valid, but there were no options in it, argv is not changed
+        stripped          // options were parsed (and executed), they were removed from argv
+    };
+
+    /**
+     * @brief Default constructor.
+     */
+    cmd_line_parser() :
+                    version("(not set)"),
+                    default_option(NULL),
+                    other_args_handler(NULL),
+                    messages(&std::cout),
+                    execute_handlers(true),
+                    nothing_specified(false),
+                    passthrough_enabled(false),
+                    passthrough_args(NULL),
+                    passthrough_count(0),
+                    next_parser(NULL),
+                    unclaimed_args(NULL),
+                    cache_state(cache_off),
+                    setup_hash(0),
+                    dependencies_ready(false),
+                    compacted(false),
+                    fingerprint(0),
+                    fingerprint_ready(false),
+                    parse_started(0),
+                    parse_duration(0)
+    {
+    }
+
+    /**
+     * @brief Enables the persistent schema cache. Must be called before any options are added.
+     *        If a valid image (created by this very binary, i.e. with the same build-id) is found
+     *        at the specified location, options that are added following this call are
+     *        not processed (their names are not indexed, descriptions are not parsed etc).
+     *        Instead: they are checked against the image, and the image is used for look-ups,
+     *        dependencies and help. If the image is missing or stale, options are added as usual,
+     *        and the image is (re)created once the setup is finished (i.e. on first call to run()).
+     *        Options must be added (and dependencies set-up) in the same order every time.
+     * @param path - location of the image.
+     * @return true if a valid image was found (and will be used), false otherwise.
+     * @throws option_error if options were already added.
+     */
+    bool use_schema_cache(const std::string& path)
+    {
+        if (options.size() || default_option != NULL)
+        {
+            std::stringstream err;
+            err << __FUNCTION__ << "(): must be called before options are added";
+            throw option_error(err.str());
+        }
+
+        cache_path = path;
+        cache_key = schema_image_build_id();
+        setup_hash = 0;
+        cache_state = cache_key.empty() ? cache_off : cache_to_write;
+        if (cache_state != cache_off && cache_image.load(cache_path, cache_key))
+        {
+            options.attach_image(cache_image);
+            cache_state = cache_attached;
+        }
+        return cache_state == cache_attached;
+    }
+
+
+    /**
+     * @brief Method to set the description of the program.
+     * @param desc - brief description of what the program does.
+     */
+    void set_description(const std::string& desc)
+    {
+        description = desc;
+        format_to_max_line_length(description);
+        append_to_lines(description, " ");
+    }
+
+    /**
+     * @brief Method to set the version of the program.
+     * @param new_version - new version (as string) to be used / presented by the program.
+     */
+    void set_version(const std::string& new_version)
+    {
+        version = new_version;
+    }
+
+    /**
+     * @brief adds new group of options. All options that are added following this call
+     *        will be associated with this group. If this method is not called before
+     *        first option is added- a default group called "Options" is created
+     *        (although it is still valid to add new option groups in such case).
+     */
+    void add_group(const std::string& group_name, std::string description="")
+    {
+        options.add_new_group(group_name, description);
+    }
+
+    /**
+     * @brief Method to display help. This involves generating and printing to stdout:
+     *        - name of the executable (from argv[0])
+     *        - version
+     *        - description
+     *        - list of options and usage information
+     */
+    void display_help()
+    {
+        std::stringstream help;
+
+        help << "\n" << program_name;
+        help << ", version: " << version << "\n\n";
+        help << description << std::endl;
+
+        if (compacted)
+        {
+            help << "(help is not available)\n";
+        }
+        else if (default_option != NULL)
+        {
+            // print option name and description..
+            default_option->fmt_set_indent(3);
+            if(!default_option->name.size())
+            {
+                default_option->name = program_name;
+            }
+            help << *default_option << "\n\n";
+        }
+        else
+        {
+           options.create_help(help);
+        }
+
+        *messages << help.str();
+    }
+
+    /**
+     * @brief sets options as required.
+     * @param list_of_required_options - list of all options that need to be specified.
+     *        If not all of options specified on this will appear in the command line,
+     *        parser will notify this as an error.
+     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     */
+    void setup_options_require_all(const std::string& list_of_required_options)
+    {
+        if (defer_setup(deferred_setup::require_all, "", list_of_required_options))
+        {
+            return;
+        }
+        dependencies_ready = false;
+
+        // now extract options from the list and store them
+        std::vector<std::string>req_options = split(list_of_required_options, " ,;\"\t\n\r");
+        for(unsigned int i = 0; i < req_options.size(); i++)
+        {
+            std::string& next_option_name = req_options[i];
+            option* other_option = options.find_option(next_option_name);
+            if (other_option != NULL)
+            {
+                options_required_all.push_back(other_option->name);
+            }
+            else
+            {
+                std::stringstream err;
+                err << "error: setting option \"" << next_option_name;
+                err << "\" as required failed: option not valid";
+                throw option_error(err.str());
+            }
+        }
+    }
+
+    /**
+     * @brief Use this method to instruct the parser to require at least one of specified options.
+     * @param list_of_options - list of all options, of which at least one should be specified.
+     *        If none from this list will appear in the command line, parser will notify this as an error.
+     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     */
+    void setup_options_require_any_of(const std::string& list_of_options)
+    {
+        if (defer_setup(deferred_setup::require_any_of, "", list_of_options))
+        {
+            return;
+        }
+        dependencies_ready = false;
+
+        // now extract options from the list and store them
+        std::vector<std::string>dep_options = split(list_of_options, " ,;\"\t\n\r");
+        for(unsigned int i = 0; i < dep_options.size(); i++)
+        {
+            std::string& next_option_name = dep_options[i];
+            option* other_option = options.find_option(next_option_name);
+            if (other_option != NULL)
+            {
+                optons_required_any_of.push_back(other_option->name);
+            }
+            else
+            {
+                std::stringstream err;
+                err << "error: " << __FUNCTION__ << " failed: option \"";
+                err << next_option_name << "\" is not valid";
+                throw option_error(err.str());
+            }
+        }
+    }
+
+    /**
+     * @brief Use this method to specify dependent options that also need to be present
+     *        whenever option_name is specified.
+     * @param option_name option name, for which dependent options are being specified
+     * @param list_of_dependent_options string containing list of options (comma/semicolon/space separated)
+     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     */
+    void setup_option_add_required(const std::string& option_name,
+                                   const std::string& list_of_dependent_options)
+    {
+        if (defer_setup(deferred_setup::add_required, option_name, list_of_dependent_options))
+        {
+            return;
+        }
+        dependencies_ready = false;
+
+        try
+        {
+            try_to_add_dependent_options(option_name, list_of_dependent_options,
+                                         &option::add_required_option);
+        }
+        catch (const option_error& err)
+        {
+            std::cout << err.what() << std::endl;
+            throw; // re-throw. This should indicate to the user that setup is wrong..
+        }
+    }
+
+    /**
+     * @brief Use this method to specify dependent options that must not be present
+     *        whenever option_name is specified.
+     * @param option_name option name, for which dependent options are being specified
+     * @param list_of_not_wanted_options string containing list of options (comma/semicolon/space separated)
+     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     */
+    void setup_option_add_not_wanted(const std::string& option_name,
+                                     const std::string& list_of_not_wanted_options)
+    {
+        if (defer_setup(deferred_setup::add_not_wanted, option_name, list_of_not_wanted_options))
+        {
+            return;
+        }
+        dependencies_ready = false;
+
+        try
+        {
+            try_to_add_dependent_options(option_name, list_of_not_wanted_options,
+                                         &option::add_not_wanted_option);
+        }
+        catch (const option_error& err)
+        {
+            std::cout << err.what() << std::endl;
+            throw; // re-throw. This should indicate to the user that setup is wrong..
+        }
+    }
+
+    /**
+     * @brief sets options as required (see setup_options_require_all() above).
+     * @param required - handles of options, e.g.: a | b.
+     * @throws option_error if any of handles is not of an option of this parser.
+     */
+    void setup_options_require_all(const option_handle_list& required)
+    {
+        if (defer_setup(deferred_setup::require_all, option_handle(), required))
+        {
+            return;
+        }
+        dependencies_ready = false;
+        for (size_t i = 0; i < required.size(); i++)
+        {
+            options_required_all.push_back(option_of(required[i], __FUNCTION__)->name);
+        }
+    }
+
+    /**
+     * @brief Requires at least one of specified options (see setup_options_require_any_of() above).
+     * @param options_list - handles of options, e.g.: a | b.
+     * @throws option_error if any of handles is not of an option of this parser.
+     */
+    void setup_options_require_any_of(const option_handle_list& options_list)
+    {
+        if (defer_setup(deferred_setup::require_any_of, option_handle(), options_list))
+        {
+            return;
+        }
+        dependencies_ready = false;
+        for (size_t i = 0; i < options_list.size(); i++)
+        {
+            optons_required_any_of.push_back(option_of(options_list[i], __FUNCTION__)->name);
+        }
+    }
+
+    /**
+     * @brief Specifies options that also need to be present whenever the option is specified
+     *        (see setup_option_add_required() above).
+     * @param o - handle of the option, for which dependent options are being specified.
+     * @param required - handles of options, e.g.: a | b.
+     * @throws option_error if any of handles is not of an option of this parser.
+     */
+    void setup_option_add_required(option_handle o, const option_handle_list& required)
+    {
+        if (defer_setup(deferred_setup::add_required, o, required))
+        {
+            return;
+        }
+        dependencies_ready = false;
+        option* curr_option = option_of(o.get(), __FUNCTION__);
+        for (size_t i = 0; i < required.size(); i++)
+        {
+            curr_option->add_required_option(option_of(required[i], __FUNCTION__)->name);
+        }
+    }
+
+    /**
+     * @brief Specifies options that must not be present whenever the option is specified
+     *        (see setup_option_add_not_wanted() above).
+     * @param o - handle of the option, for which dependent options are being specified.
+     * @param not_wanted - handles of options, e.g.: a | b.
+     * @throws option_error if any of handles is not of an option of this parser.
+     */
+    void setup_option_add_not_wanted(option_handle o, const option_handle_list& not_wanted)
+    {
+        if (defer_setup(deferred_setup::add_not_wanted, o, not_wanted))
+        {
+            return;
+        }
+        dependencies_ready = false;
+        option* curr_option = option_of(o.get(), __FUNCTION__);
+        for (size_t i = 0; i < not_wanted.size(); i++)
+        {
+            curr_option->add_not_wanted_option(option_of(not_wanted[i], __FUNCTION__)->name);
+        }
+    }
+
+    /**
+     * @brief Use this method to setup an option to be the only one, that can be specified.
+     *        i.e. no other option must be used with it at the same time.
+     * @param option_name option name, for which dependent options are being specified
+     * @throws option_error if option is not valid (i.e. has not been previously added)
+     */
+    void setup_option_as_standalone(const std::string& option_name)
+    {
+        if (defer_setup(deferred_setup::as_standalone, option_name, ""))
+        {
+            return;
+        }
+        dependencies_ready = false;
+
+        option* o = options.find_option(option_name);
+        if (o == NULL)
+        {
+            std::stringstream err;
+            err << "error: adding dependencies for option \"";
+            err << option_name << "\" failed, option is not valid";
+            throw option_error(err.str());
+        }
+        else
+        {
+            o->set_as_standalone();
+        }
+    }
+
+    /**
+     * @brief Use this method to setup an option to be idempotent, i.e. its handler will be
+     *        executed only once, even if the option is specified many times. Redundant
+     *        occurrences are still checked (i.e. their parameters must be valid), but then
+     *        dropped while parsing.
+     * @param option_name option name
+     * @param policy - which of occurrences to use: option::first_wins or option::last_wins
+     *        (or option::each_occurrence: the default behaviour).
+     * @throws option_error if option is not valid (i.e. has not been previously added), if it
+     *         was added using add_aggregated_option() (its handler is executed once already,
+     *         with parameters of all occurrences), or if the policy is option::all_at_once.
+     */
+    void setup_option_as_idempotent(const std::string& option_name,
+                                    option::repeat_policy policy = option::last_wins)
+    {
+        option* o = options.find_option(option_name);
+        if (o == NULL || o->repeated == option::all_at_once || policy == option::all_at_once)
+        {
+            std::stringstream err;
+            err << "error: setting option \"";
+            err << option_name << "\" as idempotent failed, ";
+            err << (o == NULL ? "option is not valid" : "option can't be aggregated and idempotent");
+            throw option_error(err.str());
+        }
+        o->set_repeat_policy(policy);
+    }
+
+    /**
+     * @brief Typedef for handler to be used with add_handler_for_other_options.
+     */
+    typedef void (*other_arguments_handler)(std::vector<std::string>& other_arguments);
+
+    /**
+     * @brief Adds handler for other (unrecognised) arguments.
+     *        If this method is used and proper handler is added: all command-line arguments
+     *        not recognised as options or option-arguments will be passed to this handler
+     *        at the end of execution (i.e. once all option-handlers have executed).
+     */
+    void add_handler_for_other_arguments(other_arguments_handler handler)
+    {
+        other_args_handler = handler;
+    }
+
+    /**
+     * @brief Chains another parser (e.g. with options of a library) to this one, so that
+     *        both of them (and any parsers chained later) consume the same command line.
+     *        The command line is tokenized once: each argument is offered to parsers in the
+     *        order they were chained, and those that a parser does not recognise are passed
+     *        (by their index in argv) to the next one. Arguments not recognised by any of
+     *        them are handled by the last parser (i.e. they go to its handler for other
+     *        arguments, or they are reported as errors).
+     *        Handlers are executed (in the order of parsers) only if the command line is
+     *        valid for all of them. Parsers can't be chained if any of them has a default option.
+     *        The chained parser must outlive this one, run() (or parse()) should be called
+     *        only for the first parser in the chain.
+     * @param next - parser to add at the end of the chain.
+     * @throws option_error if the parser is a part of this chain already.
+     */
+    void add_chained_parser(cmd_line_parser& next)
+    {
+        cmd_line_parser* last = this;
+        for (cmd_line_parser* p = &next; p != NULL; p = p->next_parser)
+        {
+            if (p == this)
+            {
+                std::stringstream err;
+                err << "error: parser can't be chained, it would create a loop";
+                throw option_error(err.str());
+            }
+        }
+        while (last->next_parser != NULL)
+        {
+            if (last->next_parser == &next)
+            {
+                std::stringstream err;
+                err << "error: parser can't be chained, it is in the chain already";
+                throw option_error(err.str());
+            }
+            last = last->next_parser;
+        }
+        last->next_parser = &next;
+    }
+
+    /**
+     * @brief Enables (or disables) pass-through of arguments following "--". If enabled, the
+     *        first "--" ends the command line: neither it nor anything after it is parsed.
+     *        Remaining arguments are not copied: passthrough_argv() points to them in the argv
+     *        passed to run() (or parse()), so they could be handed e.g. to a child process
+     *        (see spawn_passthrough() in passthrough_spawn.h).
+     */
+    void setup_passthrough(bool enable = true)
+    {
+        passthrough_enabled = enable;
+    }
+
+    /**
+     * @brief Returns number of arguments that followed "--" in the last command line
+     *        (see setup_passthrough()).
+     */
+    int passthrough_argc() const
+    {
+        return passthrough_count;
+    }
+
+    /**
+     * @brief Returns arguments that followed "--" in the last command line, i.e. a pointer into
+     *        the argv passed to run() (or parse()), so it's only valid as long as that argv is.
+     *        NULL if there were no such arguments.
+     */
+    char* const* passthrough_argv() const
+    {
+        return passthrough_count ? passthrough_args : NULL;
+    }
+
+    /**
+     * @brief Adds all options from the table (see cmd_line_option_entry). It's done as if
+     *        add_option() was called for each of them (followed by add_group() and set-up of
+     *        dependencies if they are specified), but containers are reserved up-front, and
+     *        names of all options are checked for duplicates (by sorting them) and indexed
+     *        in one go.
+     * @param table - options to add.
+     * @param number_of_options - number of entries in the table.
+     * @return number of options added.
+     * @throws option_error if any of these options can't be added (e.g. its name is not unique,
+     *         or options it depends on are not valid), none of them is added in such case.
+     */
+    size_t add_options(const cmd_line_option_entry* table, size_t number_of_options)
+    {
+        throw_if_compacted(__FUNCTION__);
+        size_t first = options.size();
+        options.begin_bulk(number_of_options);
+        try
+        {
+            for (size_t i = 0; i < number_of_options; i++)
+            {
+                if (table[i].name == NULL || table[i].name[0] == 0)
+                {
+                    std::stringstream err;
+                    err << __FUNCTION__ << "(): default option can't be added from a table";
+                    throw option_error(err.str());
+                }
+                if (table[i].group != NULL)
+                {
+                    add_group(table[i].group);
+                }
+                table[i].add_to(*this, table[i].name, table[i].description);
+            }
+            check_table_dependencies(table, number_of_options);
+            options.end_bulk();
+        }
+        catch (...)
+        {
+            options.abort_bulk();
+            throw;
+        }
+
+        for (size_t i = 0; i < number_of_options; i++)
+        {
+            if (table[i].required != NULL || table[i].not_wanted != NULL)
+            {
+                std::string name = split(options.option_at(first + i)->name, " ,/|")[0];
+                if (table[i].required != NULL)
+                {
+                    setup_option_add_required(name, table[i].required);
+                }
+                if (table[i].not_wanted != NULL)
+                {
+                    setup_option_add_not_wanted(name, table[i].not_wanted);
+                }
+            }
+        }
+        return number_of_options;
+    }
+
+    /**
+     * @brief Adds all options from the table (see above).
+     */
+    template<size_t N>
+    size_t add_options(const cmd_line_option_entry (&table)[N])
+    {
+        return add_options(table, N);
+    }
+
+#ifdef CMD_LINE_OPTIONS_STATIC_REGISTRATION
+    /**
+     * @brief Adds all options declared using CMD_LINE_OPTION() macro (in any translation unit
+     *        linked into the program). Options are added in the order the linker placed them,
+     *        i.e. in the order they appear in each of the files, files in the link order.
+     * @return number of options added.
+     * @throws option_error if any of these options can't be added (e.g. its name is not unique).
+     */
+    size_t add_registered_options()
+    {
+        size_t added = 0;
+        if (__start_cmd_line_options != NULL)
+        {
+            options.begin_bulk(__stop_cmd_line_options - __start_cmd_line_options);
+            try
+            {
+                for (cmd_line_option_descriptor* d = __start_cmd_line_options;
+                                d != __stop_cmd_line_options; d++)
+                {
+                    d->add_to(*this, d->name, d->description);
+                    added++;
+                }
+                options.end_bulk();
+            }
+            catch (...)
+            {
+                options.abort_bulk();
+                throw;
+            }
+        }
+        return added;
+    }
+#endif /* CMD_LINE_OPTIONS_STATIC_REGISTRATION */
+
+    /**
+     * @brief Analyses dependencies between options (it is called by run(), but could also be
+     *        called directly once all options are set-up, e.g. to validate the set-up in tests).
+     *        Options required by each option are followed transitively (i.e. if "a" requires "b"
+     *        and "b" requires "c", then "a" requires also "c"), and the result is kept, so that
+     *        each time the command line is checked it's only a few bitset operations.
+     * @throws option_error if dependencies can't be satisfied, i.e. if:
+     *         - an option requires itself (i.e. required options form a cycle),
+     *         - an option requires options that can't be used together (or with the option itself),
+     *         - a standalone option requires other options or is required by other options,
+     *         - options that are all required can't be used together.
+     */
+    void setup_check_dependencies()
+    {
+        if (dependencies_ready)
+        {
+            return;
+        }
+        throw_if_compacted(__FUNCTION__);
+        size_t n = options.size();
+        std::map<std::string, uint32_t> ids_by_name;
+        ids_by_full_name(ids_by_name);
+
+        specified.resize(n);
+        specified.reset();
+        dependencies.clear();
+        dependencies_of.assign(n, static_cast<size_t>(dynamic_bitset::npos));
+        for (size_t i = 0; i < n; i++)
+        {
+            option* o = options.option_at(i);
+            if (o->doc->required_options.size() || o->doc->not_wanted_options.size())
+            {
+                dependencies_of[i] = dependencies.size();
+                dependencies.push_back(option_dependencies());
+                option_dependencies& d = dependencies.back();
+                d.required = bits_of(ids_of(o->doc->required_options, ids_by_name), n);
+                d.not_wanted = bits_of(ids_of(o->doc->not_wanted_options, ids_by_name), n);
+            }
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (dependencies_of[i] != dynamic_bitset::npos)
+            {
+                follow_required(i);
+            }
+        }
+
+        required_all_set = bits_of(ids_of(options_required_all, ids_by_name), n);
+        required_any_of_set = bits_of(ids_of(optons_required_any_of, ids_by_name), n);
+        dynamic_bitset always = required_all_set;
+        for (size_t i = required_all_set.find_next(0); i != dynamic_bitset::npos;
+                        i = required_all_set.find_next(i + 1))
+        {
+            if (dependencies_of[i] != dynamic_bitset::npos)
+            {
+                always |= dependencies[dependencies_of[i]].required;
+            }
+        }
+        check_if_can_be_used_together(always, "error: required options can't be used together");
+        dependencies_ready = true;
+    }
+
+    /**
+     * @brief When done creating / adding options, run this method giving proper argc/argv values
+     *        To parse command-line options. All command-line arguments will be parsed.
+     *        If all is successful - appropriate handlers (functions used to create options) will
+     *        be executed in the order they were found in cmd-line arguments. By default - options
+     *        can be specified multiple times, and if all parameters are correct, their functions
+     *        will be called multiple times with parsed values. Once all recognised option-handlers
+     *        (functions) have executed - a handler for other arguments is executed.
+     * @param argc: number of elements in argv
+     * @param argv: command-line parameters.
+     * @return true - if command line contained anything to parse and parsing was successful or help was requested,
+     *         false otherwise.
+     * @throws option_error if argc/argv are not valid, or if dependencies between options can't
+     *         be satisfied (see setup_check_dependencies()).
+     * Options (and other arguments) found by a previous call are forgotten first, so it can be
+     * called for each of command lines received by a long-running process. Buffers used for
+     * parsing are kept between calls, so once they have grown - parsing does not allocate memory
+     * (apart from values of parameters that need it, e.g. long strings).
+     */
+    bool run(int argc, char *const argv[])
+    {
+        return parse_and_execute(argc, argv, true);
+    }
+
+    /**
+     * @brief Runs the parser as run() does, but arguments it does not recognise are not errors
+     *        (nor are they passed to the handler for other arguments). Instead - if the command
+     *        line was valid - arguments that were parsed are removed from argv: pointers to
+     *        the remaining ones are moved (in their original order) to the front of argv, just
+     *        after argv[0], getopt-style, and argc is updated. Pointers to removed arguments are
+     *        moved after them, so argv is only permuted. Arguments following "--" (if pass-through
+     *        is enabled) remain there too, i.e. they are left for whoever parses argv next.
+     *        Note, that parameters referring to argv (e.g. rest_of_args) are only valid until it
+     *        is permuted, i.e. while their handlers are executed.
+     * @param argc: number of elements in argv, on return - number of remaining arguments (+1).
+     * @param argv: command-line parameters, they are permuted in place.
+     * @return stripped if the command line contained any options and it was valid (argv was
+     *         permuted), nothing_stripped if it was valid but had no options (e.g. all of its
+     *         arguments are for someone else, or help was requested), not_valid otherwise.
+     *         Unless it's stripped - argc/argv are left as they were.
+     * @throws option_error if argc/argv are not valid, or if dependencies between options can't
+     *         be satisfied (see setup_check_dependencies()).
+     */
+    strip_result run_and_strip(int& argc, char* argv[])
+    {
+        std::vector<int> remaining;
+        unclaimed_args = &remaining;
+        bool result = false;
+        try
+        {
+            result = parse_and_execute(argc, argv, true);
+        }
+        catch (...)
+        {
+            unclaimed_args = NULL;
+            throw;
+        }
+        unclaimed_args = NULL;
+        if (!result)
+        {
+            return nothing_specified ? nothing_stripped : not_valid;
+        }
+
+        {
+            int parsed_argc = passthrough_args ? static_cast<int>(passthrough_args - argv) - 1 : argc;
+            for (int i = parsed_argc; i < argc; i++)
+            {
+                remaining.push_back(i); // ("--" and what follows it)
+            }
+
+            std::vector<char*> removed;
+            removed.reserve(argc - remaining.size());
+            int to = 1;
+            size_t next = 0;
+            for (int i = 1; i < argc; i++)
+            {
+                if (next < remaining.size() && remaining[next] == i)
+                {
+                    argv[to++] = argv[i];
+                    next++;
+                }
+                else
+                {
+                    removed.push_back(argv[i]);
+                }
+            }
+            std::copy(removed.begin(), removed.end(), argv + to);
+            if (passthrough_args != NULL)
+            {
+                passthrough_args = argv + to - passthrough_count;
+            }
+            argc = to;
+        }
+        return stripped;
+    }
+
+    /**
+     * @brief Parses and checks the command line exactly as run() does, but none of the handlers
+     *        is executed (and help is not displayed if it was requested). Options specified
+     *        (and other arguments) found previously are forgotten first, so that it can be called
+     *        any number of times, e.g. to benchmark the parser or to validate command lines.
+     * @param argc: number of elements in argv
+     * @param argv: command-line parameters.
+     * @return true - if command line contained anything to parse and parsing was successful or help was requested,
+     *         false otherwise.
+     * @throws option_error if argc/argv are not valid, or if dependencies between options can't
+     *         be satisfied (see setup_check_dependencies()).
+     */
+    bool parse(int argc, char *const argv[])
+    {
+        return parse_and_execute(argc, argv, false);
+    }
+
+    /**
+     * @brief Checks the command line exactly as parse() does (no handlers are executed), but
+     *        instead of printing the error (if the command line is not valid) it returns it.
+     * @param argc: number of elements in argv
+     * @param argv: command-line parameters.
+     * @param error: description of the error (empty if the command line is valid).
+     * @return true if the command line is valid, false otherwise.
+     * @throws option_error if dependencies between options can't be satisfied
+     *         (see setup_check_dependencies()).
+     */
+    bool validate(int argc, char *const argv[], std::string& error)
+    {
+        std::stringstream found_errors;
+        std::ostream* prev = messages;
+        messages = &found_errors;
+        bool valid = false;
+        try
+        {
+            finish_setup();
+            valid = parse(argc, argv);
+        }
+        catch (const option_error& e)
+        {
+            if (!dependencies_ready)
+            {
+                messages = prev;
+                throw; // set-up is not valid
+            }
+            found_errors << e.what();
+        }
+        catch (...)
+        {
+            messages = prev;
+            throw;
+        }
+        messages = prev;
+        error.clear();
+        if (!valid)
+        {
+            error = found_errors.str();
+            error.erase(0, error.find_first_not_of(" \t\n\r"));
+            error.erase(error.find_last_not_of(" \t\n\r") + 1);
+            if (error.empty())
+            {
+                error = "nothing specified";
+            }
+        }
+        return valid;
+    }
+
+    /**
+     * @brief Returns a fingerprint of the schema, i.e. a hash of names, usage and number of
+     *        parameters of all options. It can be used to tell if command lines (e.g. recorded
+     *        earlier) were meant for the same set of options. It is computed once and then
+     *        cached until another option is added.
+     */
+    uint32_t schema_fingerprint()
+    {
+        if (fingerprint_ready || compacted)
+        {
+            return fingerprint; // (once compacted, options can't be described anymore)
+        }
+        std::stringstream schema;
+        if (default_option != NULL)
+        {
+            schema << default_option->doc->usage << "\n" << default_option->num_params() << "\n";
+        }
+        for (size_t i = 0; i < options.size(); i++)
+        {
+            option* o = options.option_at(i);
+            schema << o->name << "\n" << o->doc->usage << "\n" << o->num_params() << "\n";
+        }
+        std::string s = schema.str();
+        fingerprint = name_hash(s.data(), s.size());
+        fingerprint_ready = true;
+        return fingerprint;
+    }
+
+    /**
+     * @brief Releases everything that is needed only to set-up the parser or to describe its
+     *        options: descriptions, usage, doxygen tags and groups. It's meant for long running
+     *        processes, that keep the parser only to query options that were specified
+     *        (e.g. check_if_option_specified()). Command lines can still be parsed afterwards,
+     *        but help is not available and errors don't include usage of options.
+     *        Options can't be added (nor the set-up changed) once this is done.
+     * @throws option_error if dependencies between options can't be satisfied
+     *         (see setup_check_dependencies()).
+     */
+    void compact()
+    {
+        finish_setup();
+        schema_fingerprint();
+        options.compact();
+        if (default_option != NULL)
+        {
+            default_option->release_doc();
+        }
+        std::string().swap(description);
+        compacted = true;
+    }
+
+    /**
+     * @brief Checks if option was specified.
+     * @param option_name name of option to check.
+     * @return true if option was specified, false otherwise.
+     */
+    bool check_if_option_specified(std::string option_name)
+    {
+        std::set<std::string> el(execute_list.begin(), execute_list.end()); // lazy 'two-liner' way..
+        return (el.find(option_name) != el.end());
+    }
+
+    /**
+     * @brief Returns names of all specified options.
+     */
+    std::vector<std::string> all_specified_option_names()
+    {
+        return execute_list;
+    }
+
+    /**
+     * @brief Returns ids of options specified (one for each occurrence, in the order they
+     *        were found). Ids are given to options in the order they are added.
+     * @param ids - vector to store them in (it's cleared first).
+     */
+    void specified_option_ids(std::vector<uint32_t>& ids)
+    {
+        ids.clear();
+        for (size_t i = 0; i < execute_list.size(); i++)
+        {
+            option* o = options.find_option(execute_list[i]);
+            if (o != NULL)
+            {
+                ids.push_back(static_cast<uint32_t>(o->id));
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the (full) name of the option of the specified id (see specified_option_ids()),
+     *        or an empty string if there's no such option.
+     */
+    std::string option_name(uint32_t id)
+    {
+        return id < options.size() ? options.option_at(id)->name : std::string();
+    }
+
+    /**
+     * @brief Returns how long (in nanoseconds) it took to parse the last command line,
+     *        i.e. the time run() (or parse()) spent before handlers were executed.
+     */
+    uint64_t last_parse_duration_ns() const
+    {
+        return parse_duration;
+    }
+
+    /**
+     * @brief Returns latencies of parsing and of handlers of each of options (indexed by
+     *        their ids), recorded (always) by run() and parse(). Recording them costs two
+     *        reads of the clock, and doesn't allocate memory, apart from the first time each
+     *        of handlers is executed (a histogram, ~2KB, is created only for those executed). The parser can't be used by many threads at a time,
+     *        so a program that parses command lines in many threads has a parser for each
+     *        of them. Latencies are not shared between these parsers: to get ones of the
+     *        whole program, each of threads should copy latencies of its parser, and these
+     *        copies can be merged (see parser_latency::merge()).
+     *        Note, that they must be read by the thread using the parser (e.g. handling
+     *        the stats command, see setup_stats_command()), or while it doesn't use it.
+     */
+    const parser_latency& latency() const
+    {
+        return latencies;
+    }
+
+    /**
+     * @brief Forgets latencies recorded so far (see latency()), histograms are kept.
+     */
+    void reset_latency()
+    {
+        latencies.reset();
+    }
+
+    /**
+     * @brief Reserves a command, that (like help) can be specified instead of options.
+     *        When it is found in the command line, latencies (see latency()) are printed
+     *        (to std::cout, or where help is printed) and nothing else is done.
+     * @param name - name of the command, or an empty string to disable it.
+     * @throws option_error if an option of that name exists.
+     */
+    void setup_stats_command(const std::string& name = "--parser-stats")
+    {
+        if (name.size() && options.find_option(name) != NULL)
+        {
+            std::stringstream err;
+            err << __FUNCTION__ << "(): \"" << name << "\" is a name of an option already";
+            throw option_error(err.str());
+        }
+        stats_command = name;
+    }
+
+    template<class RetType>
+    option_handle add_option(RetType function_ptr(), std::string name, std::string description);
+
+    template<class RetType, typename P1>
+    option_handle add_option(RetType function_ptr(P1), std::string name, std::string description);
+
+    template<class RetType, typename P1, typename P2>
+    option_handle add_option(RetType function_ptr(P1, P2), std::string name, std::string description);
+
+    template<class RetType, typename P1, typename P2, typename P3>
+    option_handle add_option(RetType function_ptr(P1, P2, P3), std::string name, std::string description);
+
+    template<class RetType, typename P1, typename P2, typename P3, typename P4>
+    option_handle add_option(RetType function_ptr(P1, P2, P3, P4), std::string name,
+                    std::string description);
+
+    template<class RetType, typename P1, typename P2, typename P3, typename P4, typename P5>
+    option_handle add_option(RetType function_ptr(P1, P2, P3, P4, P5), std::string name,
+                    std::string description);
+
+    template<class RetType, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+    option_handle add_option(RetType function_ptr(P1, P2, P3, P4, P5, P6), std::string name,
+                    std::string description);
+
+// adding options for functions taking pointer (to object) as a first parameter
+    template<class RetType, typename ObjType>
+    option_handle add_option(RetType function_ptr(ObjType*), ObjType* obj_address, std::string name,
+                    std::string description);
+
+    template<class RetType, typename ObjType, typename P1>
+    option_handle add_option(RetType function_ptr(ObjType*, P1), ObjType* obj_address, std::string name,
+                    std::string description);
+
+    template<class RetType, typename ObjType, typename P1, typename P2>
+    option_handle add_option(RetType function_ptr(ObjType*, P1, P2), ObjType* obj_address, std::string name,
+                    std::string description);
+
+    template<class RetType, typename ObjType, typename P1, typename P2, typename P3>
+    option_handle add_option(RetType function_ptr(ObjType*, P1, P2, P3), ObjType* obj_address,
+                    std::string name, std::string description);
+
+    template<class RetType, typename ObjType, typename P1, typename P2, typename P3, typename P4>
+    option_handle add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4), ObjType* obj_address,
+                    std::string name, std::string description);
+
+    template<class RetType, typename ObjType, typename P1, typename P2, typename P3, typename P4, typename P5>
+    option_handle add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4, P5), ObjType* obj_address,
+                    std::string name, std::string description);
+// adding options, which handlers are executed once, with parameters of all occurrences
+    template<class RetType, typename P1>
+    option_handle add_aggregated_option(RetType function_ptr(const std::vector<P1>&), std::string name,
+                               std::string description);
+
+    template<class RetType, typename P1, typename P2>
+    option_handle add_aggregated_option(RetType function_ptr(const std::vector<P1>&, const std::vector<P2>&),
+                               std::string name, std::string description);
+
+    template<class RetType, typename P1, typename P2, typename P3>
+    option_handle add_aggregated_option(RetType function_ptr(const std::vector<P1>&, const std::vector<P2>&,
+                                                    const std::vector<P3>&),
+                               std::string name, std::string description);
+protected:
+    /**
+     * @brief Internal method to add a raw-option.
+     *        It adds an option or a default option (if name of option is zero-length),
+     *        performing various checks if it is valid do to so.
+     */
+    option_handle add_option(option* a, std::string description)
+    {
+        std::stringstream err;
+        throw_if_compacted(__FUNCTION__);
+        fingerprint_ready = false;
+        if (a != NULL)
+        {
+            if (cache_state == cache_attached)
+            {
+                if (a->name.length() != 0 && options.add_cached_option(a))
+                {
+                    a->set_pending_description(description);
+                    return option_handle(a);
+                }
+                drop_schema_cache();
+            }
+
+            a->set_description(description);
+            dependencies_ready = false;
+            if (a->name.length() != 0) // adding standard option
+            {
+                if (default_option == NULL)
+                {
+                    options.add_new_option(a);
+                }
+                else
+                {
+                    err << __FUNCTION__ << "(): trying to add \"" << a->name;
+                    err << "\" option, but default option was set";
+                }
+            }
+            else  // adding default option
+            {
+                if (default_option == NULL)
+                {
+                    if(options.size() > 0)
+                    {
+                        err << __FUNCTION__ << "(): Trying to add default option when other options exist";
+                    }
+                    else
+                    {
+                        default_option = a;
+                        // we will set option name to program name, but it will happen when it
+                        // will be about to execute (i.e. we don't know argv[0] yet)
+                    }
+                }
+                else
+                {
+                    err << __FUNCTION__;
+                    err << "(): Trying to add another default option";
+                }
+            }
+        }
+        else
+        {
+            err << __FUNCTION__ << "(): option can't be NULL";
+        }
+
+        if (err.str().length() > 0)
+        {
+            throw option_error(err.str());
+        }
+        return option_handle(a);
+    }
+
+    /**
+     * @brief Internal method implementing run() and parse().
+     * @param execute - if false, handlers are not executed and help is not displayed.
+     */
+    bool parse_and_execute(int argc, char *const argv[], bool execute)
+    {
+        parse_started = cmd_line_time_ns();
+        parse_duration = 0;
+        bool result = parse_and_execute_handlers(argc, argv, execute);
+        parsing_finished(); // (if no handlers were executed)
+        return result;
+    }
+
+    /**
+     * @brief Records how long parsing took. It's called before first of handlers is executed.
+     */
+    void parsing_finished()
+    {
+        if (parse_started != 0)
+        {
+            parse_duration = cmd_line_time_ns() - parse_started;
+            parse_started = 0;
+            latencies.parse.record(parse_duration);
+        }
+    }
+
+    /**
+     * @brief Executes handler of the option and records how long it took.
+     */
+    void execute_timed(option* o)
+    {
+        uint64_t started = cmd_line_time_ns();
+        o->execute();
+        latencies.handler(o->id).record(cmd_line_time_ns() - started);
+    }
+
+    /**
+     * @brief Prints latencies (see latency()) of parsing and of handlers that were executed,
+     *        with names of their options.
+     */
+    void print_latency(std::ostream& out) const
+    {
+        out << "parse [ns]: " << latencies.parse << "\n";
+        for (size_t id = 0; id < latencies.handler_ids(); id++)
+        {
+            const latency_histogram* h = latencies.find_handler(id);
+            if (h != NULL && h->count() > 0)
+            {
+                const option* o = (id < options.size()) ? options.option_at(id) : default_option;
+                out << "handler \"" << (o ? o->name : "") << "\" [ns]: " << *h << "\n";
+            }
+        }
+    }
+
+    /**
+     * @brief Parses the command line and executes handlers (see parse_and_execute()).
+     */
+    bool parse_and_execute_handlers(int argc, char *const argv[], bool execute)
+    {
+        bool result = false;
+        execute_handlers = execute;
+        nothing_specified = false;
+        finish_setup();
+        argc = split_passthrough(argc, argv);
+        recycle(execute_list);
+        recycle(other_args);
+        convert_cmd_line_to_string(argc, argv, parsed_text);
+        cmd_line_stream& cmd_line = parsed_cmd_line;
+        cmd_line.assign(parsed_text, argc, argv, this);
+        if (next_parser != NULL)
+        {
+            return parse_chain(cmd_line);
+        }
+
+        if (default_option != NULL)
+        {
+            if(!handle_default_option(cmd_line))
+                {
+                // will return false if it's help or error extracting
+                // params. No point to contiune any further for default option
+                // (otherwise - if returns true: following loop would extract
+                // other (non-option) params from cmd_line etc.
+                return false;
+                }
+        }
+
+        occurred.resize(options.size());
+        occurred.reset();
+        first_occurrences.clear();
+
+        bool found = false;
+        do
+        {
+            try
+            {
+                found = could_find_next_option(cmd_line);
+            }
+            catch (const option_error& err)
+            {
+                *messages << err.what();
+                return false;
+            }
+        } while (found);
+        if (unclaimed_args != NULL)
+        {
+            // (parsing stopped, e.g. on help: what follows it was not parsed)
+            for (int i = cmd_line.next_arg(); i < argc; i++)
+            {
+                unclaimed_args->push_back(i);
+            }
+        }
+        restore_first_occurrences(cmd_line);
+
+
+        result = check_options_and_execute();
+        if(!result)
+        {
+            recycle(execute_list);
+        }
+
+        // regardless of result from options - execute other_args_handler
+        // and update result if successful
+        if (other_args_handler != NULL && other_args.size() > 0)
+        {
+            if (execute_handlers)
+            {
+                parsing_finished();
+                other_args_handler(other_args);
+            }
+            result = true;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Internal method implementing run() and parse() for chained parsers
+     *        (see add_chained_parser()).
+     */
+    bool parse_chain(cmd_line_stream& cmd_line)
     {
-        if(new_option)
+        std::vector<int>* remaining = unclaimed_args; // (see run_and_strip())
+        std::vector<cmd_line_parser*> chain;
+        for (cmd_line_parser* p = this; p != NULL; p = p->next_parser)
         {
-            std::vector<std::string> aliases = split(new_option->name, " ,/|");
-            std::string& name = aliases[0];
-            if(options.find(name) == options.end())
-            {
-                if(!groups.size())
-                {
-                    add_new_group("Options");
-                }
-
-                options.insert(std::make_pair(name, new_option));
-                std::vector<group>::iterator g = groups.end() - 1;
-                g->add_option(name);
-            }
-            else
+            if (p->default_option != NULL)
             {
                 std::stringstream err;
-                err << __FUNCTION__ << "(\"" << new_option->name << "\")";
-                err << ": option \"" << name << "\" already exists!";
+                err << "error: parsers with a default option can't be chained";
                 throw option_error(err.str());
             }
+            chain.push_back(p);
+        }
+
+        std::vector<int> offered;
+        std::vector<int> unclaimed;
+        offered.reserve(cmd_line.argc());
+        for (int i = 1; i < cmd_line.argc(); i++)
+        {
+            offered.push_back(i);
+        }
+
+        bool valid = true;
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            cmd_line_parser* p = chain[i];
+            std::ostream* own_messages = p->messages;
+            p->messages = messages;
+            p->program_name = program_name;
+            p->execute_handlers = execute_handlers;
+            p->finish_setup();
+            p->recycle(p->execute_list);
+            p->recycle(p->other_args);
+            unclaimed.clear();
+            valid = valid && p->parse_offered(cmd_line, offered,
+                                              (i + 1 < chain.size()) ? &unclaimed : remaining);
+            valid = valid && p->check_specified_options();
+            p->messages = own_messages;
+            offered.swap(unclaimed);
+        }
 
-            for(unsigned int i = 1; i < aliases.size(); i++)
+        bool result = false;
+        parsing_finished();
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            std::vector<std::string>& to_execute = chain[i]->execute_list;
+            if (!valid)
             {
-                try
-                {
-                    options.add_alias(name, aliases[i]);
-                }
-                catch(...)
-                {
-                    std::stringstream err;
-                    err << __FUNCTION__ << "(\"" << new_option->name << "\")";
-                    err << ": another option was already defined with: \"";
-                    err << aliases[i] << "\"!";
-                    throw option_error(err.str());
-                }
+                chain[i]->recycle(to_execute);
+                chain[i]->recycle(chain[i]->other_args);
+            }
+            for (size_t n = 0; execute_handlers && n < to_execute.size(); n++)
+            {
+                chain[i]->execute_timed(chain[i]->options.find_option(to_execute[n]));
             }
+            result |= !to_execute.empty();
         }
-    }
 
-    /**
-     * @brief Fins option of a given name.
-     * @param name - name of the option to find.
-     * @return  - pointer to option if found, NULL otherwise.
-     */
-    option* find_option(std::string name)
-    {
-        option* result = NULL;
-        OptionContainer::iterator i = options.find(name);
-        if(name.length() && i != options.end())
+        // (unlike for a single parser, other arguments are handled only if all options were valid)
+        cmd_line_parser* last = chain.back();
+        if (last->other_args_handler != NULL && last->other_args.size() > 0)
         {
-            result = *i;
+            if (execute_handlers)
+            {
+                last->other_args_handler(last->other_args);
+            }
+            result = true;
         }
+        nothing_specified = valid && !result;
         return result;
     }
 
     /**
-     * @brief Returns size of options.
+     * @brief Internal method to parse arguments (of specified indexes) of a chained parser.
+     * @param offered - indexes (in argv) of arguments to parse, in ascending order.
+     * @param unclaimed - indexes of arguments that were not recognised are added to it. If NULL,
+     *        they are handled as other arguments (i.e. it's the last parser in the chain).
+     * @return false if arguments were not valid (error was printed to messages).
      */
-    size_t size()
+    bool parse_offered(cmd_line_stream& cmd_line, const std::vector<int>& offered,
+                       std::vector<int>* unclaimed)
     {
-        return options.size();
+        occurred.resize(options.size());
+        occurred.reset();
+        first_occurrences.clear();
+        unclaimed_args = unclaimed;
+
+        bool valid = true;
+        try
+        {
+            size_t k = 0;
+            while (k < offered.size())
+            {
+                cmd_line.seek_arg(offered[k]);
+                if (!could_find_next_option(cmd_line))
+                {
+                    // help was requested: stop here, but let the following parsers display it too
+                    if (unclaimed != NULL)
+                    {
+                        unclaimed->insert(unclaimed->end(), offered.begin() + k, offered.end());
+                    }
+                    break;
+                }
+
+                // option with its parameters must not take arguments claimed by previous parsers
+                size_t last = k + (cmd_line.next_arg() - offered[k]) - 1;
+                if (last >= offered.size() || offered[last] != cmd_line.next_arg() - 1)
+                {
+                    std::stringstream err;
+                    err << program_name << ": \"" << cmd_line.argv()[offered[k]] << "\": ";
+                    err << "parameters are missing, try " << help_options << " to see usage.\n";
+                    throw option_error(err.str());
+                }
+                k = last + 1;
+            }
+            restore_first_occurrences(cmd_line);
+        }
+        catch (const option_error& err)
+        {
+            *messages << err.what();
+            recycle(execute_list);
+            valid = false;
+        }
+        unclaimed_args = NULL;
+        return valid;
     }
 
     /**
-     * @brief Creates help using all information about options and their groups.
-     * @param help_content - stream into which help message is inserted.
+     * @brief Internal method to find "--" (if pass-through is enabled).
+     * @returns number of arguments to parse (i.e. preceding "--").
      */
-    void create_help(std::stringstream& help_content)
+    int split_passthrough(int argc, char* const argv[])
     {
-        size_t max_cmd_len = 0;
-        OptionContainer::iterator i;
-        for (i = options.begin(); i != options.end(); i++)
-        {
-            std::string &s = (*i)->name;
-            max_cmd_len = std::max<size_t>(max_cmd_len, s.length());
-        }
-        max_cmd_len++;
-
-        std::vector<group>::iterator g;
-        for(g = groups.begin(); g != groups.end(); g++)
+        passthrough_args = NULL;
+        passthrough_count = 0;
+        if (passthrough_enabled && argv != NULL)
         {
-            help_content << "\n" << g->name();
-            if(g->description().length())
+            for (int i = 1; i < argc; i++)
+            {
+                if (argv[i] != NULL && strcmp(argv[i], "--") == 0)
                 {
-                help_content << "(" << g->description() << ")";
+                    passthrough_args = argv + i + 1;
+                    passthrough_count = argc - i - 1;
+                    return i;
                 }
-            help_content << ":\n";
-
-            group::options_iterator oi;
-            for (oi = g->options_begin(); oi != g->options_end(); oi++)
-            {
-                option* o = find_option(*oi);
-                const std::string& s = o->name;
-                // TODO: could assert here, just as a sanity check for development / changes
-                o->fmt_set_indent(max_cmd_len-s.length());
-                help_content << *o;
-                help_content << "\n\n";
             }
         }
+        return argc;
     }
 
-protected:
-
     /**
-     * @brief Helper class to allow associating options with groups.
+     * @brief Internal method to extract program name and the rest of arguments
+     *        from argc/argv
+     * @param cmd_line - string that will contain parameters, each of them surrounded with "".
+     * @throws option_error if argc / argv are not valid.
      */
-    class group
+    void convert_cmd_line_to_string(int argc, char* const argv[], std::string& cmd_line)
     {
-    public:
-        /**
-         * @brief Constructor.
-         * @param name - name of the group.
-         * @param (optional) description of the option group
-         */
-        explicit group(std::string name, std::string description = "") :
-            group_name(name), group_description(description)
+        if (argv == NULL || argc < 1)
         {
+            std::stringstream err;
+            err << __FUNCTION__ << "(): argc/argv are not valid";
+            throw option_error(err.str());
         }
 
-        /**
-         * @brief Returns name of the group.
-         */
-        std::string name()
+        cmd_line.clear();
+        program_name = argv[0];
+        int path_end = program_name.rfind('\\');
+        if (path_end < 0)
         {
-            return group_name;
+            path_end = program_name.rfind('/');
+            if (path_end > 0)
+            {
+                program_name.erase(0, path_end + 1);
+            }
         }
-
-        /**
-         * @brief Returns description of the group.
-         */
-        std::string description()
+        if (argc > 1)
         {
-            return group_description;
+            int cnt = 1;
+            while (cnt < argc)
+            {
+                // surround them with ""
+                cmd_line += '\"';
+                cmd_line += argv[cnt++];
+                cmd_line += "\"";
+            }
+            // strip it at the end (removing also space added above)
+            cmd_line.erase(cmd_line.find_last_not_of(" \t\n\r") + 1);
         }
+    }
 
-        /**
-         * @brief Adds option to the group.
-         */
-        void add_option(std::string name)
+    /**
+     * @brief Empties the list, but its strings (with their buffers) are kept in spare_strings,
+     *        so that they can be reused by add_recycled() instead of allocating new ones.
+     */
+    void recycle(std::vector<std::string>& list)
+    {
+        for (size_t i = 0; i < list.size(); i++)
         {
-            option_names.push_back(name);
+            spare_strings.push_back(std::string());
+            spare_strings.back().swap(list[i]);
         }
+        list.clear();
+    }
 
-        /**
-         * @brief Iterator for options.
-         */
-        typedef std::vector<std::string>::iterator options_iterator;
-
-        /**
-         * @brief Helper for iterators  to allow iterating through options within this group.
-         */
-        options_iterator options_begin()
+    /**
+     * @brief Adds a copy of the value at the end of the list, re-using one of spare_strings.
+     */
+    void add_recycled(std::vector<std::string>& list, const std::string& value)
+    {
+        list.push_back(std::string());
+        if (spare_strings.size())
         {
-            return option_names.begin();
+            list.back().swap(spare_strings.back());
+            spare_strings.pop_back();
         }
+        list.back().assign(value);
+    }
 
-        /**
-         * @brief Helper for iterators  to allow iterating through options within this group.
-         */
-        options_iterator options_end()
+    bool is_it_help(std::stringstream& from)
+    {
+        std::streamoff pos = from.tellg();
+        read_next_token(from, next_token);
+        bool is_help = is_help_name(next_token.c_str());
+        if (!is_help)
         {
-            return option_names.end();
+            from.seekg(pos); // (it is read again)
         }
-
-    private:
-        std::string group_name;
-        std::string group_description;
-        std::vector<std::string> option_names;
-    };
-
-    OptionContainer options;
-    std::vector<group> groups;
-};
-
-
-/**
- * @brief string describing help options.
- */
-static const char* help_options = "\"?\", \"-h\" or \"--help\"";
-
-
-/**
- * @brief This is the main class of this library.
- */
-class cmd_line_parser
-{
-public:
-    /**
-     * @brief Options should be unique and referred by the key, so they are kept
-     *        by the parser using a map.
-     */
-    typedef grouped_options OptionContainer;
+        return is_help;
+    }
 
     /**
-     * @brief Default constructor.
+     * @brief Returns true if the name is one of help options, i.e. "?", "h" or "help", preceded
+     *        by any number of '-' (case is ignored).
      */
-    cmd_line_parser() :
-                    version("(not set)"),
-                    default_option(NULL),
-                    other_args_handler(NULL)
+    static bool is_help_name(const char* name)
     {
+        name += strspn(name, "-");
+        char h[5] = {0};
+        size_t i = 0;
+        for (; name[i] != 0 && i < sizeof(h) - 1; i++)
+        {
+            h[i] = static_cast<char>(tolower(static_cast<unsigned char>(name[i])));
+        }
+        return name[i] == 0 && (strcmp(h, "?") == 0 || strcmp(h, "h") == 0 || strcmp(h, "help") == 0);
     }
 
-
     /**
-     * @brief Method to set the description of the program.
-     * @param desc - brief description of what the program does.
+     * @brief See cmd_line_boundaries: parameters end at names of options, help options and
+     *        the stats command, (of this and of all parsers chained to it, so that options
+     *        of following parsers are not taken as parameters, see add_chained_parser()).
      */
-    void set_description(const std::string& desc)
+    virtual bool is_boundary(const char* arg, size_t size) const
     {
-        description = desc;
-        format_to_max_line_length(description);
-        append_to_lines(description, " ");
+        if (is_help_name(arg))
+        {
+            return true;
+        }
+        for (const cmd_line_parser* p = this; p != NULL; p = p->next_parser)
+        {
+            if (p->options.names().find(arg, size) != NULL ||
+                (p->stats_command.size() &&
+                 p->stats_command.compare(0, std::string::npos, arg, size) == 0))
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
-    /**
-     * @brief Method to set the version of the program.
-     * @param new_version - new version (as string) to be used / presented by the program.
-     */
-    void set_version(const std::string& new_version)
+    void try_to_extract_params(option* opt, std::stringstream& from)
     {
-        version = new_version;
-    }
+        if(opt != NULL)
+        {
+            try
+            {
+                opt->extract_params(from);
+            }
+            catch (const option_error& e)
+            {
+                if (opt->doc == NULL) // (see compact())
+                {
+                    std::stringstream s;
+                    s << "\n" << program_name << ": \"" << opt->name << "\": ";
+                    s << "error while parsing parameter: " << opt->params_extracted + 1 << ", ";
+                    s << e.what() << "\n";
+                    throw option_error(s.str());
+                }
+                // failed, print usage information..
+                opt->complete_description();
+                std::stringstream s;
+                int indent_size = 0;
+                const size_t option_name_len = opt->name.length();
+                if(option_name_len > 0)
+                {
+                    s << "\n" << program_name << ": \"" << opt->name << "\": ";
+                    indent_size = 0; //opt->name.size();
+                }
+                else // default option..
+                {
+                    s << "\n " << program_name << ": ";
+                    indent_size = program_name.size();
+                    if (opt->name.length() == 0)
+                    {
+                        opt->name = program_name;
+                    }
+                }
+
+                std::string indent(indent_size + 3, ' ');
+                s << "error while parsing parameter: " << opt->params_extracted + 1 << "\n";
+
+                s << indent << "expected: ";
+                if (opt->doc->doxy_dict.found_tokens("param"))
+                {
+                    const doxy_dictionary::occurrences& params =
+                                      opt->doc->doxy_dict.get_occurences("param");
+                    if (params.size() && opt->params_extracted < params.size())
+                    {
+                        s << "\"" << opt->doc->doxy_dict.text_of(params[opt->params_extracted].name) << "\"";
+                    }
+                }
 
-    /**
-     * @brief adds new group of options. All options that are added following this call
-     *        will be associated with this group. If this method is not called before
-     *        first option is added- a default group called "Options" is created
-     *        (although it is still valid to add new option groups in such case).
-     */
-    void add_group(const std::string& group_name, std::string description="")
-    {
-        options.add_new_group(group_name, description);
+                s << e.what() << "\n";
+                opt->fmt_usage_only();
+                opt->fmt_set_indent(3);
+                s << *opt << "\n";
+
+                throw option_error(s.str());
+            }
+        }
+        else
+        {
+            std::stringstream err;
+            err << "error using " << __FUNCTION__ << "(): option can't be NULL";
+            throw option_error(err.str());
+        }
     }
 
     /**
-     * @brief Method to display help. This involves generating and printing to stdout:
-     *        - name of the executable (from argv[0])
-     *        - version
-     *        - description
-     *        - list of options and usage information
+     * @brief Internal method to check if there are more options in the stream
+     *        IF there are any, true will be returned and option list will be stored
+     *        in the execute_list. Additionally - if other_args_handler is not NULL
+     *        any unrecognised options will be added to other_args.
+     * @returns true if new option has been found, false - otherwise.
+     * @throws option_error if option is not valid or parameters for the option
+     *         that has been found are not correct.
      */
-    void display_help()
+    bool could_find_next_option(std::stringstream& from)
     {
-        std::stringstream help;
-
-        help << "\n" << program_name;
-        help << ", version: " << version << "\n\n";
-        help << description << std::endl;
+        std::string& option_name = next_token;
+        bool found = false;
 
-        if (default_option != NULL)
+        if (is_it_help(from))
         {
-            // print option name and description..
-            default_option->fmt_set_indent(3);
-            if(!default_option->name.size())
+            if (execute_handlers)
             {
-                default_option->name = program_name;
+                display_help();
             }
-            help << *default_option << "\n\n";
+            recycle(execute_list);
         }
         else
         {
-           options.create_help(help);
-        }
+            read_next_token(from, option_name);
 
-        std::cout << help.str();
+            if (stats_command.size() && option_name == stats_command)
+            {
+                if (execute_handlers)
+                {
+                    print_latency(*messages);
+                }
+                recycle(execute_list);
+            }
+            else if (option_name.length() != 0)
+            {
+                option* o = options.find_option(option_name);
+                if(o != NULL)
+                {
+                    bool repeated = (o->repeated != option::each_occurrence && occurred.test(o->id));
+                    if (o->repeated == option::first_wins && !repeated)
+                    {
+                        first_occurrence f = {o, from.tellg(), false};
+                        first_occurrences.push_back(f);
+                    }
+                    if (!repeated)
+                    {
+                        o->clear_params();
+                    }
+                    try_to_extract_params(o, from);
+                    if (!repeated)
+                    {
+                        add_recycled(execute_list, option_name); // TODO: if options can be specified more than once - we should really make copies of option* objects here..
+                        occurred.set(o->id);
+                    }
+                    else if (o->repeated == option::first_wins)
+                    {
+                        for (size_t i = 0; i < first_occurrences.size(); i++)
+                        {
+                            first_occurrences[i].overwritten |= (first_occurrences[i].o == o);
+                        }
+                    }
+                    found = true;
+                }
+                else if (unclaimed_args != NULL)
+                {
+                    // (parsing as a part of a chain, the next parser will get it)
+                    unclaimed_args->push_back(static_cast<cmd_line_stream&>(from).next_arg() - 1);
+                    found = true;
+                }
+                else
+                {
+                    if (other_args_handler == NULL/* && default_option == NULL*/)
+                    {
+                        std::stringstream err;
+                        err << program_name << ": \"" <<  option_name << "\": ";
+                        err << "no such option, try " << help_options << " to see usage.\n";
+                        throw option_error(err.str());
+                    }
+                    else
+                    {
+                        add_recycled(other_args, option_name);
+                        found = true;
+                    }
+                }
+            }
+        }
+        return found;
     }
 
     /**
-     * @brief sets options as required.
-     * @param list_of_required_options - list of all options that need to be specified.
-     *        If not all of options specified on this will appear in the command line,
-     *        parser will notify this as an error.
-     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     * @brief Parameters of "first_wins" options (see setup_option_as_idempotent()) that were
+     *        specified more than once were overwritten by following occurrences, so they are
+     *        extracted again from the first one.
      */
-    void setup_options_require_all(const std::string& list_of_required_options)
+    void restore_first_occurrences(std::stringstream& from)
     {
-        // now extract options from the list and store them
-        std::vector<std::string>req_options = split(list_of_required_options, " ,;\"\t\n\r");
-        for(unsigned int i = 0; i < req_options.size(); i++)
+        for (size_t i = 0; i < first_occurrences.size(); i++)
         {
-            std::string& next_option_name = req_options[i];
-            option* other_option = options.find_option(next_option_name);
-            if (other_option != NULL)
-            {
-                options_required_all.push_back(other_option->name);
-            }
-            else
+            first_occurrence& f = first_occurrences[i];
+            if (f.overwritten && f.params_at >= 0)
             {
-                std::stringstream err;
-                err << "error: setting option \"" << next_option_name;
-                err << "\" as required failed: option not valid";
-                throw option_error(err.str());
+                from.clear();
+                from.seekg(f.params_at);
+                f.o->extract_params(from);
             }
         }
     }
 
     /**
-     * @brief Use this method to instruct the parser to require at least one of specified options.
-     * @param list_of_options - list of all options, of which at least one should be specified.
-     *        If none from this list will appear in the command line, parser will notify this as an error.
-     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     * @brief Internal typedef for option member pointer (will be used either for
+     *        option::add_required_option or option::add_not_wanted_option
      */
-    void setup_options_require_any_of(const std::string& list_of_options)
+    typedef void (option::*operation_type)(const std::string&);
+
+    /**
+     * @brief Internal method to add selected list of option to either required or not wanted list.
+     * @throws option_error any of specified options is not valid.
+     */
+    void try_to_add_dependent_options(const std::string& to_option,
+                                      const std::string& list_of_options,
+                                      operation_type add_dependent_option)
     {
-        // now extract options from the list and store them
+        option* curr_option = options.find_option(to_option);
+        if (curr_option == NULL)
+        {
+            std::stringstream err;
+            err << "error: adding dependencies for option \"";
+            err << to_option << "\" failed, option is not valid";
+            throw option_error(err.str());
+        }
+
+        // now extract options from the list, check and add them to current one
         std::vector<std::string>dep_options = split(list_of_options, " ,;\"\t\n\r");
         for(unsigned int i = 0; i < dep_options.size(); i++)
         {
@@ -2593,622 +6019,666 @@ public:
             option* other_option = options.find_option(next_option_name);
             if (other_option != NULL)
             {
-                optons_required_any_of.push_back(other_option->name);
+                (curr_option->*add_dependent_option)(other_option->name);
             }
             else
             {
                 std::stringstream err;
-                err << "error: " << __FUNCTION__ << " failed: option \"";
-                err << next_option_name << "\" is not valid";
+                err << "error: adding dependencies for option \"";
+                err << to_option << "\" failed, option \"" << next_option_name << "\" is not valid";
                 throw option_error(err.str());
             }
         }
     }
 
     /**
-     * @brief Use this method to specify dependent options that also need to be present
-     *        whenever option_name is specified.
-     * @param option_name option name, for which dependent options are being specified
-     * @param list_of_dependent_options string containing list of options (comma/semicolon/space separated)
-     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
-     */
-    void setup_option_add_required(const std::string& option_name,
-                                   const std::string& list_of_dependent_options)
-    {
-        try
-        {
-            try_to_add_dependent_options(option_name, list_of_dependent_options,
-                                         &option::add_required_option);
-        }
-        catch (const option_error& err)
-        {
-            std::cout << err.what() << std::endl;
-            throw; // re-throw. This should indicate to the user that setup is wrong..
-        }
-    }
-
-    /**
-     * @brief Use this method to specify dependent options that must not be present
-     *        whenever option_name is specified.
-     * @param option_name option name, for which dependent options are being specified
-     * @param list_of_not_wanted_options string containing list of options (comma/semicolon/space separated)
-     * @throws option_error if any of specified options is not valid (i.e. has not been previously added)
+     * @brief Internal method to check (before names of options from the table are indexed, see
+     *        add_options()) that options, which those from the table depend on, are either
+     *        in the table or were added before, so that dependencies can be set-up once they
+     *        are indexed.
+     * @throws option_error if any of them is not valid.
      */
-    void setup_option_add_not_wanted(const std::string& option_name,
-                                     const std::string& list_of_not_wanted_options)
+    void check_table_dependencies(const cmd_line_option_entry* table, size_t number_of_options)
     {
-        try
-        {
-            try_to_add_dependent_options(option_name, list_of_not_wanted_options,
-                                         &option::add_not_wanted_option);
-        }
-        catch (const option_error& err)
+        std::vector<std::string> names;
+        for (size_t i = 0; i < number_of_options; i++)
         {
-            std::cout << err.what() << std::endl;
-            throw; // re-throw. This should indicate to the user that setup is wrong..
+            std::vector<std::string> aliases = split(table[i].name, " ,/|");
+            names.insert(names.end(), aliases.begin(), aliases.end());
         }
-    }
+        std::sort(names.begin(), names.end());
 
-    /**
-     * @brief Use this method to setup an option to be the only one, that can be specified.
-     *        i.e. no other option must be used with it at the same time.
-     * @param option_name option name, for which dependent options are being specified
-     * @throws option_error if option is not valid (i.e. has not been previously added)
-     */
-    void setup_option_as_standalone(const std::string& option_name)
-    {
-        option* o = options.find_option(option_name);
-        if (o == NULL)
-        {
-            std::stringstream err;
-            err << "error: adding dependencies for option \"";
-            err << option_name << "\" failed, option is not valid";
-            throw option_error(err.str());
-        }
-        else
+        for (size_t i = 0; i < number_of_options; i++)
         {
-            o->set_as_standalone();
+            const char* lists[] = {table[i].required, table[i].not_wanted};
+            for (size_t l = 0; l < sizeof(lists) / sizeof(lists[0]); l++)
+            {
+                std::vector<std::string> dep_options = split(lists[l] ? lists[l] : "", " ,;\"\t\n\r");
+                for (size_t d = 0; d < dep_options.size(); d++)
+                {
+                    if (!std::binary_search(names.begin(), names.end(), dep_options[d]) &&
+                        options.find_option(dep_options[d]) == NULL)
+                    {
+                        std::stringstream err;
+                        err << "error: adding dependencies for option \"" << table[i].name;
+                        err << "\" failed, option \"" << dep_options[d] << "\" is not valid";
+                        throw option_error(err.str());
+                    }
+                }
+            }
         }
     }
 
-    /**
-     * @brief Typedef for handler to be used with add_handler_for_other_options.
-     */
-    typedef void (*other_arguments_handler)(std::vector<std::string>& other_arguments);
-
-    /**
-     * @brief Adds handler for other (unrecognised) arguments.
-     *        If this method is used and proper handler is added: all command-line arguments
-     *        not recognised as options or option-arguments will be passed to this handler
-     *        at the end of execution (i.e. once all option-handlers have executed).
-     */
-    void add_handler_for_other_arguments(other_arguments_handler handler)
-    {
-        other_args_handler = handler;
-    }
-
-    /**
-     * @brief When done creating / adding options, run this method giving proper argc/argv values
-     *        To parse command-line options. All command-line arguments will be parsed.
-     *        If all is successful - appropriate handlers (functions used to create options) will
-     *        be executed in the order they were found in cmd-line arguments. By default - options
-     *        can be specified multiple times, and if all parameters are correct, their functions
-     *        will be called multiple times with parsed values. Once all recognised option-handlers
-     *        (functions) have executed - a handler for other arguments is executed.
-     * @param argc: number of elements in argv
-     * @param argv: command-line parameters.
-     * @return true - if command line contained anything to parse and parsing was successful or help was requested,
-     *         false otherwise.
-     * @throws option_error if argc/argv are not valid.
-     */
-    bool run(int argc, char *const argv[])
+    bool handle_default_option(std::stringstream& cmd_line)
     {
         bool result = false;
-        std::stringstream cmd_line(convert_cmd_line_to_string(argc, argv));
-
-        if (default_option != NULL)
+        if (is_it_help(cmd_line))
         {
-            if(!handle_default_option(cmd_line))
-                {
-                // will return false if it's help or error extracting
-                // params. No point to contiune any further for default option
-                // (otherwise - if returns true: following loop would extract
-                // other (non-option) params from cmd_line etc.
-                return false;
-                }
+            if (execute_handlers)
+            {
+                display_help();
+            }
         }
-
-        bool found = false;
-        do
+        else
         {
             try
             {
-                found = could_find_next_option(cmd_line);
+                try_to_extract_params(default_option, cmd_line);
+                result = true;
             }
-            catch (const option_error& err)
+            catch (const option_error& e)
             {
-                std::cout << err.what();
-                return false;
+                *messages << e.what() << std::endl;
             }
-        } while (found);
-
-
-        result = check_options_and_execute();
-        if(!result)
-        {
-            execute_list.clear();
         }
+        return result;
+    }
 
-        // regardless of result from options - execute other_args_handler
-        // and update result if successful
-        if (other_args_handler != NULL && other_args.size() > 0)
+    bool check_options_and_execute()
+    {
+        bool result = false;
+        if (default_option != NULL)
         {
-            other_args_handler(other_args);
+            if(!default_option->name.size())
+            {
+                default_option->name = program_name;
+            }
+            if (execute_handlers)
+            {
+                parsing_finished();
+                execute_timed(default_option);
+            }
             result = true;
         }
+        else if (check_specified_options())
+        {
+            nothing_specified = execute_list.empty();
+            if (!nothing_specified)
+            {
+                parsing_finished();
+                std::vector<std::string>::iterator i;
+                for (i = execute_list.begin(); execute_handlers && i != execute_list.end(); i++)
+                {
+                    option* option_to_execute = options.find_option(*i);
+                    if(option_to_execute) // TODO: similarly here..
+                    {
+                        execute_timed(option_to_execute);
+                    }
+                }
+                result = true;
+            }
+        }
         return result;
     }
 
     /**
-     * @brief Checks if option was specified.
-     * @param option_name name of option to check.
-     * @return true if option was specified, false otherwise.
-     */
-    bool check_if_option_specified(std::string option_name)
-    {
-        std::set<std::string> el(execute_list.begin(), execute_list.end()); // lazy 'two-liner' way..
-        return (el.find(option_name) != el.end());
-    }
-
-    /**
-     * @brief Returns names of all specified options.
+     * @brief Internal method to check if options specified (i.e. in the execute_list)
+     *        can be used together and if all required options were specified.
+     * @return false (and error is printed to messages) if they can't be used.
      */
-    std::vector<std::string> all_specified_option_names()
+    bool check_specified_options()
     {
-        return execute_list;
-    }
-
-    template<class RetType>
-    void add_option(RetType function_ptr(), std::string name, std::string description);
-
-    template<class RetType, typename P1>
-    void add_option(RetType function_ptr(P1), std::string name, std::string description);
-
-    template<class RetType, typename P1, typename P2>
-    void add_option(RetType function_ptr(P1, P2), std::string name, std::string description);
+        std::vector<std::string>::iterator i;
 
-    template<class RetType, typename P1, typename P2, typename P3>
-    void add_option(RetType function_ptr(P1, P2, P3), std::string name, std::string description);
-
-    template<class RetType, typename P1, typename P2, typename P3, typename P4>
-    void add_option(RetType function_ptr(P1, P2, P3, P4), std::string name,
-                    std::string description);
-
-    template<class RetType, typename P1, typename P2, typename P3, typename P4, typename P5>
-    void add_option(RetType function_ptr(P1, P2, P3, P4, P5), std::string name,
-                    std::string description);
-
-    template<class RetType, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
-    void add_option(RetType function_ptr(P1, P2, P3, P4, P5, P6), std::string name,
-                    std::string description);
-
-// adding options for functions taking pointer (to object) as a first parameter
-    template<class RetType, typename ObjType>
-    void add_option(RetType function_ptr(ObjType*), ObjType* obj_address, std::string name,
-                    std::string description);
+        // convert our execute list into a list containing full option names
+        // (we will need it for error messages) and into a set of specified options.
+        specified.reset();
+        recycle(specified_full_names);
+        specified_full_names.reserve(execute_list.size()); // (instead of growing it in steps)
+        for(i = execute_list.begin(); i != execute_list.end(); i++)
+        {
+            option* o = options.find_option(*i);
+            add_recycled(specified_full_names, o->name);
+            specified.set(o->id);
+        }
 
-    template<class RetType, typename ObjType, typename P1>
-    void add_option(RetType function_ptr(ObjType*, P1), ObjType* obj_address, std::string name,
-                    std::string description);
+        if (options_required_all.size())
+        {
+            std::stringstream err_msg;
+            if (!specified.includes(required_all_set))
+            {
+                err_msg << "required following option(s): \n ";
+                err_msg << merge_items_to_string(options_required_all) << "\n\n";
 
-    template<class RetType, typename ObjType, typename P1, typename P2>
-    void add_option(RetType function_ptr(ObjType*, P1, P2), ObjType* obj_address, std::string name,
-                    std::string description);
+                if(execute_list.size())
+                {
+                    err_msg << "but specified only:\n ";
+                    err_msg << merge_items_to_string(execute_list);
+                }
+                else
+                {
+                    err_msg << "but nothing was specified.";
+                }
+                err_msg << "\ntry " << help_options << " to see usage.\n";
+                *messages << "\n" << program_name << ": " << err_msg.str() << "\n";
+                return false;
+            }
+        }
 
-    template<class RetType, typename ObjType, typename P1, typename P2, typename P3>
-    void add_option(RetType function_ptr(ObjType*, P1, P2, P3), ObjType* obj_address,
-                    std::string name, std::string description);
+        if (optons_required_any_of.size())
+        {
+            std::stringstream err_msg;
+            if (!specified.intersects(required_any_of_set))
+            {
+                err_msg << "at least one of the following option(s) is required:\n";
+                std::string require_list = merge_items_to_string(optons_required_any_of);
+                indent_and_trim(require_list, 2);
+                err_msg << require_list;
+                err_msg << "\n\ntry " << help_options << " to see usage.\n";
+                *messages << "\n" << program_name << ": " << err_msg.str() << "\n";
+                return false;
+            }
+        }
 
-    template<class RetType, typename ObjType, typename P1, typename P2, typename P3, typename P4>
-    void add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4), ObjType* obj_address,
-                    std::string name, std::string description);
+        for (i = execute_list.begin(); i != execute_list.end(); i++)
+        {
+            try
+            {
+                option* option_to_execute = options.find_option(*i);
+                if(option_to_execute)
+                {
+                    check_if_valid_with_specified_options(option_to_execute, specified_full_names);
+                }
+            }
+            catch (const option_error& e)
+            {
+                *messages << "\n" << program_name << ": " <<  e.what() << std::endl;
+                // should skip any execution if options were not right.
+                recycle(execute_list);
+                return false;
+            }
+        }
+        return true;
+    }
 
-    template<class RetType, typename ObjType, typename P1, typename P2, typename P3, typename P4, typename P5>
-    void add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4, P5), ObjType* obj_address,
-                    std::string name, std::string description);
-protected:
     /**
-     * @brief Internal method to add a raw-option.
-     *        It adds an option or a default option (if name of option is zero-length),
-     *        performing various checks if it is valid do to so.
+     * @brief Checks if specified options are valid with this option.
+     * @param o - option to check (it must be one of specified options).
+     * @param all_specified_options - vector of (full names of) all specified options.
+     * @throws option_error if specified options do not match requirements of this option.
      */
-    void add_option(option* a, std::string description)
+    void check_if_valid_with_specified_options(option* o,
+                                               std::vector<std::string>& all_specified_options)
     {
-        std::stringstream err;
-        if (a != NULL)
+        std::stringstream result;
+        size_t at = dependencies_of[o->id];
+        if (at != dynamic_bitset::npos)
         {
-            a->set_description(description);
-            if (a->name.length() != 0) // adding standard option
+            const option_dependencies& d = dependencies[at];
+            if (!specified.includes(d.required))
             {
-                if (default_option == NULL)
-                {
-                    options.add_new_option(a);
-                }
-                else
-                {
-                    err << __FUNCTION__ << "(): trying to add \"" << a->name;
-                    err << "\" option, but default option was set";
-                }
+                result << "option \"" << o->name << "\" requires also: ";
+                result << merge_items_to_string(names_of(d.required, false));
             }
-            else  // adding default option
+
+            if (specified.intersects(d.not_wanted))
             {
-                if (default_option == NULL)
+                if (result.str().size() == 0)
                 {
-                    if(options.size() > 0)
-                    {
-                        err << __FUNCTION__ << "(): Trying to add default option when other options exist";
-                    }
-                    else
-                    {
-                        default_option = a;
-                        // we will set option name to program name, but it will happen when it
-                        // will be about to execute (i.e. we don't know argv[0] yet)
-                    }
+                    result << "option \"" << o->name << "\"";
                 }
                 else
                 {
-                    err << __FUNCTION__;
-                    err << "(): Trying to add another default option";
+                    result << ", and";
                 }
+                result << " can't be used with: ";
+                result << merge_items_to_string(names_of(d.not_wanted, true));
             }
         }
-        else
+
+        if (o->standalone && all_specified_options.size() > 1)
         {
-            err << __FUNCTION__ << "(): option can't be NULL";
+            result << "option \"" << o->name << "\"";
+            result << " can't be used with other options, but specified with: ";
+            all_specified_options.erase(std::remove(all_specified_options.begin(),
+                                                    all_specified_options.end(),
+                                                    o->name),
+                                        all_specified_options.end());
+            result << merge_items_to_string(all_specified_options);
         }
 
-        if (err.str().length() > 0)
+        if (result.str().length() > 0)
         {
+            std::stringstream err;
+            err << "error: " << result.str();
             throw option_error(err.str());
         }
     }
 
     /**
-     * @brief Internal method to extract program name and the rest of arguments
-     *        from argc/argv
-     * @returns string containing parameters, delimited by space.
-     * @throws option_error if argc / argv are not valid.
+     * @brief Returns (sorted) names of options from the set that either were or were not specified.
      */
-    std::string convert_cmd_line_to_string(int argc, char* const argv[])
+    std::vector<std::string> names_of(const dynamic_bitset& set, bool if_specified)
     {
-        if (argv == NULL || argc < 1)
-        {
-            std::stringstream err;
-            err << __FUNCTION__ << "(): argc/argv are not valid";
-            throw option_error(err.str());
-        }
-
-        std::string cmd_line;
-        program_name = argv[0];
-        int path_end = program_name.rfind('\\');
-        if (path_end < 0)
-        {
-            path_end = program_name.rfind('/');
-            if (path_end > 0)
-            {
-                program_name.erase(0, path_end + 1);
-            }
-        }
-        if (argc > 1)
+        std::vector<std::string> names;
+        for (size_t i = set.find_next(0); i != dynamic_bitset::npos; i = set.find_next(i + 1))
         {
-            int cnt = 1;
-            while (cnt < argc)
+            if (specified.test(i) == if_specified)
             {
-                // surround them with ""
-                cmd_line += '\"';
-                cmd_line += argv[cnt++];
-                cmd_line += "\"";
+                names.push_back(options.option_at(i)->name);
             }
-            // strip it at the end (removing also space added above)
-            cmd_line.erase(cmd_line.find_last_not_of(" \t\n\r") + 1);
         }
-        return cmd_line;
+        std::sort(names.begin(), names.end());
+        return names;
     }
 
-    bool is_it_help(std::stringstream& from)
+    /**
+     * @brief Helper to convert ids into a set.
+     */
+    static dynamic_bitset bits_of(const std::vector<uint32_t>& ids, size_t size)
     {
-        std::string option;
-        std::streamoff pos = from.tellg();
-        option = get_next_token(from);
-        bool is_help = false;
-
-        std::string h(option);
-        h.erase(0, h.find_first_not_of("-"));
-        std::transform(h.begin(), h.end(), h.begin(), ::tolower);
-        if (h == "?" || h == "h" || h == "help")
-        {
-            is_help = true;
-        }
-        else
+        dynamic_bitset result(size);
+        for (size_t i = 0; i < ids.size(); i++)
         {
-            from.seekg(pos);
+            result.set(ids[i]);
         }
-        return is_help;
+        return result;
     }
 
-    void try_to_extract_params(option* opt, std::stringstream& from)
+    /**
+     * @brief Replaces options required by the option with all options it requires directly or
+     *        indirectly, and checks if they can be used together.
+     * @throws option_error if they can't.
+     */
+    void follow_required(size_t id)
     {
-        if(opt != NULL)
+        option_dependencies& d = dependencies[dependencies_of[id]];
+        option* o = options.option_at(id);
+        dynamic_bitset closure = d.required;
+        std::vector<size_t> to_visit;
+        for (size_t i = closure.find_next(0); i != dynamic_bitset::npos; i = closure.find_next(i + 1))
         {
-            try
+            to_visit.push_back(i);
+        }
+
+        while (to_visit.size())
+        {
+            size_t next = to_visit.back();
+            to_visit.pop_back();
+            if (dependencies_of[next] == dynamic_bitset::npos)
             {
-                opt->extract_params(from);
+                continue;
             }
-            catch (const option_error& e)
+            const dynamic_bitset& required = dependencies[dependencies_of[next]].required;
+            for (size_t i = required.find_next(0); i != dynamic_bitset::npos; i = required.find_next(i + 1))
             {
-                // failed, print usage information..
-                std::stringstream s;
-                int indent_size = 0;
-                const size_t option_name_len = opt->name.length();
-                if(option_name_len > 0)
-                {
-                    s << "\n" << program_name << ": \"" << opt->name << "\": ";
-                    indent_size = 0; //opt->name.size();
-                }
-                else // default option..
+                if (!closure.test(i))
                 {
-                    s << "\n " << program_name << ": ";
-                    indent_size = program_name.size();
-                    if (opt->name.length() == 0)
-                    {
-                        opt->name = program_name;
-                    }
+                    closure.set(i);
+                    to_visit.push_back(i);
                 }
+            }
+        }
+        d.required = closure;
 
-                std::string indent(indent_size + 3, ' ');
-                s << "error while parsing parameter: " << opt->params_extracted + 1 << "\n";
+        std::stringstream err;
+        if (closure.test(id))
+        {
+            err << "error: option \"" << o->name << "\" requires itself (required options form a cycle)";
+            throw option_error(err.str());
+        }
 
-                s << indent << "expected: ";
-                if (opt->doxy_dict.found_tokens("param"))
-                {
-                    doxy_dictionary::vector_of_string_pairs& params =
-                                      opt->doxy_dict.get_occurences("param");
-                    if (params.size() && opt->params_extracted < params.size())
-                    {
-                        s << "\"" << params[opt->params_extracted].first << "\"";
-                    }
-                }
+        if (o->standalone && closure.any())
+        {
+            err << "error: option \"" << o->name << "\" can't be used with other options, ";
+            err << "but it requires: " << merge_items_to_string(names_of(closure, false));
+            throw option_error(err.str());
+        }
 
-                s << e.what() << "\n";
-                opt->fmt_usage_only();
-                opt->fmt_set_indent(3);
-                s << *opt << "\n";
+        closure.set(id);
+        err << "error: option \"" << o->name << "\" can't be used";
+        check_if_can_be_used_together(closure, err.str());
+    }
 
-                throw option_error(s.str());
+    /**
+     * @brief Checks if options from the set can be used together.
+     * @throws option_error (with the message prefixed by what) if they can't.
+     */
+    void check_if_can_be_used_together(const dynamic_bitset& set, const std::string& what)
+    {
+        size_t count = set.count();
+        for (size_t i = set.find_next(0); i != dynamic_bitset::npos; i = set.find_next(i + 1))
+        {
+            std::stringstream err;
+            option* o = options.option_at(i);
+            if (o->standalone && count > 1)
+            {
+                err << what << ": \"" << o->name << "\" can't be used with other options";
+                throw option_error(err.str());
+            }
+
+            size_t at = dependencies_of[i];
+            if (at != dynamic_bitset::npos && set.intersects(dependencies[at].not_wanted))
+            {
+                const dynamic_bitset& not_wanted = dependencies[at].not_wanted;
+                size_t other = not_wanted.find_next(0);
+                while (!set.test(other))
+                {
+                    other = not_wanted.find_next(other + 1);
+                }
+                err << what << ": \"" << o->name << "\" can't be used with \"";
+                err << options.option_at(other)->name << "\"";
+                throw option_error(err.str());
             }
         }
-        else
-        {
-            std::stringstream err;
-            err << "error using " << __FUNCTION__ << "(): option can't be NULL";
-            throw option_error(err.str());
-        }
     }
 
     /**
-     * @brief Internal method to check if there are more options in the stream
-     *        IF there are any, true will be returned and option list will be stored
-     *        in the execute_list. Additionally - if other_args_handler is not NULL
-     *        any unrecognised options will be added to other_args.
-     * @returns true if new option has been found, false - otherwise.
-     * @throws option_error if option is not valid or parameters for the option
-     *         that has been found are not correct.
+     * @brief Sets of options each option depends on.
      */
-    bool could_find_next_option(std::stringstream& from)
+    struct option_dependencies
+    {
+        dynamic_bitset required;
+        dynamic_bitset not_wanted;
+    };
+
+    /**
+     * @brief Setup call (dependencies etc.) that was made while the schema is restored from the image.
+     *        These are only replayed if the image turns out to be stale.
+     */
+    struct deferred_setup
     {
+        enum kind
+        {
+            require_all,
+            require_any_of,
+            add_required,
+            add_not_wanted,
+            as_standalone
+        };
+
+        kind what;
         std::string option_name;
-        bool found = false;
+        std::string list;
+    };
 
-        if (is_it_help(from))
+    /**
+     * @brief Records the setup call if the schema is being restored from the image. If the
+     *        schema cache is used, all setup calls are also added to the setup_hash, so that
+     *        an image created by a different sequence of these calls is not used.
+     * @return true if the call was recorded (and should not be processed now), false otherwise.
+     */
+    bool defer_setup(deferred_setup::kind what, const std::string& option_name,
+                     const std::string& list)
+    {
+        throw_if_compacted(__FUNCTION__);
+        if (cache_state != cache_attached && cache_state != cache_to_write)
         {
-            display_help();
-            execute_list.clear();
+            return false;
         }
-        else
+        std::stringstream call_text;
+        call_text << what << ":" << option_name << ":" << list << "\n";
+        std::string text = call_text.str();
+        setup_hash = setup_hash * 31 + name_hash(text.data(), text.size());
+        if (cache_state == cache_to_write)
         {
-            option_name = get_next_token(from);
+            return false;
+        }
+        deferred_setup call;
+        call.what = what;
+        call.option_name = option_name;
+        call.list = list;
+        deferred.push_back(call);
+        return true;
+    }
 
-            if (option_name.length() != 0)
-            {
-                option* o = options.find_option(option_name);
-                if(o != NULL)
-                {
-                    try_to_extract_params(o, from);
-                    execute_list.push_back(option_name); // TODO: if options can be specified more than once - we should really make copies of option* objects here..
-                    found = true;
-                }
-                else
-                {
-                    if (other_args_handler == NULL/* && default_option == NULL*/)
-                    {
-                        std::stringstream err;
-                        err << program_name << ": \"" <<  option_name << "\": ";
-                        err << "no such option, try " << help_options << " to see usage.\n";
-                        throw option_error(err.str());
-                    }
-                    else
-                    {
-                        other_args.push_back(option_name);
-                        found = true;
-                    }
-                }
-            }
+    /**
+     * @brief Records the setup call (made with handles) if the schema is being restored from the image.
+     * @return true if the call was recorded (and should not be processed now), false otherwise.
+     */
+    bool defer_setup(deferred_setup::kind what, option_handle o, const option_handle_list& list)
+    {
+        throw_if_compacted(__FUNCTION__);
+        if (cache_state != cache_attached && cache_state != cache_to_write)
+        {
+            return false;
         }
-        return found;
+        std::string names;
+        for (size_t i = 0; i < list.size(); i++)
+        {
+            names += split(option_of(list[i], __FUNCTION__)->name, " ,/|")[0] + ",";
+        }
+        std::string option_name;
+        if (o.get() != NULL)
+        {
+            option_name = split(option_of(o.get(), __FUNCTION__)->name, " ,/|")[0];
+        }
+        return defer_setup(what, option_name, names);
     }
 
     /**
-     * @brief Internal typedef for option member pointer (will be used either for
-     *        option::add_required_option or option::add_not_wanted_option
+     * @brief Internal method to check if the handle is of an option of this parser.
+     * @return the option.
+     * @throws option_error if it's not.
      */
-    typedef void (option::*operation_type)(const std::string&);
+    option* option_of(option* o, const char* fcn_name)
+    {
+        if (o == NULL || o->id >= options.size() || options.option_at(o->id) != o)
+        {
+            std::stringstream err;
+            err << "error: " << fcn_name << "(): option handle is not valid";
+            if (o != NULL)
+            {
+                err << " (\"" << o->name << "\" is not an option of this parser)";
+            }
+            throw option_error(err.str());
+        }
+        return o;
+    }
 
     /**
-     * @brief Internal method to add selected list of option to either required or not wanted list.
-     * @throws option_error any of specified options is not valid.
+     * @brief Internal method to check if the parser was compacted (see compact()).
+     * @throws option_error if it was.
      */
-    void try_to_add_dependent_options(const std::string& to_option,
-                                      const std::string& list_of_options,
-                                      operation_type add_dependent_option)
+    void throw_if_compacted(const char* fcn_name)
     {
-        option* curr_option = options.find_option(to_option);
-        if (curr_option == NULL)
+        if (compacted)
         {
             std::stringstream err;
-            err << "error: adding dependencies for option \"";
-            err << to_option << "\" failed, option is not valid";
+            err << "error: " << fcn_name << "(): options can't be set-up or described after compact()";
             throw option_error(err.str());
         }
+    }
 
-        // now extract options from the list, check and add them to current one
-        std::vector<std::string>dep_options = split(list_of_options, " ,;\"\t\n\r");
-        for(unsigned int i = 0; i < dep_options.size(); i++)
+    /**
+     * @brief Called when all options are added and set-up (i.e. on run()). Depending on the
+     *        state of the schema cache: either restores dependencies from the image, or stores
+     *        the image if it was missing or stale.
+     */
+    void finish_setup()
+    {
+        if (cache_state == cache_attached)
         {
-            std::string& next_option_name = dep_options[i];
-            option* other_option = options.find_option(next_option_name);
-            if (other_option != NULL)
+            const schema_image_header& h = cache_image.header();
+            if (options.size() == h.option_count && setup_hash == h.setup_hash)
             {
-                (curr_option->*add_dependent_option)(other_option->name);
+                restore_from_cache();
             }
             else
             {
-                std::stringstream err;
-                err << "error: adding dependencies for option \"";
-                err << to_option << "\" failed, option \"" << next_option_name << "\" is not valid";
-                throw option_error(err.str());
+                drop_schema_cache();
             }
         }
-    }
 
-    bool handle_default_option(std::stringstream& cmd_line)
-    {
-        bool result = false;
-        if (is_it_help(cmd_line))
+        if (cache_state == cache_to_write)
         {
-            display_help();
+            save_schema_cache();
         }
-        else
+        setup_check_dependencies();
+    }
+
+    /**
+     * @brief Restores dependencies between options from the image. Deferred setup calls
+     *        are not needed: they were the same when the image was created (see setup_hash).
+     */
+    void restore_from_cache()
+    {
+        const schema_image_header& h = cache_image.header();
+        for (uint32_t i = 0; i < h.option_count; i++)
         {
-            try
+            const schema_image_option& o = cache_image.option_at(i);
+            option* curr_option = options.option_at(i);
+            if (o.flags & schema_image_option::f_standalone)
             {
-                try_to_extract_params(default_option, cmd_line);
-                result = true;
+                curr_option->set_as_standalone();
             }
-            catch (const option_error& e)
+            for (uint32_t r = 0; r < o.required_count; r++)
+            {
+                uint32_t id = cache_image.ids(o.required_first)[r];
+                curr_option->add_required_option(options.option_at(id)->name);
+            }
+            for (uint32_t n = 0; n < o.not_wanted_count; n++)
             {
-                std::cout << e.what() << std::endl;
+                uint32_t id = cache_image.ids(o.not_wanted_first)[n];
+                curr_option->add_not_wanted_option(options.option_at(id)->name);
             }
         }
-        return result;
+        dependencies_ready = false;
+
+        for (uint32_t i = 0; i < h.required_all_count; i++)
+        {
+            uint32_t id = cache_image.ids(h.required_all_first)[i];
+            options_required_all.push_back(options.option_at(id)->name);
+        }
+        for (uint32_t i = 0; i < h.any_of_count; i++)
+        {
+            uint32_t id = cache_image.ids(h.any_of_first)[i];
+            optons_required_any_of.push_back(options.option_at(id)->name);
+        }
+        deferred.clear();
+        cache_state = cache_in_use;
     }
 
-    bool check_options_and_execute()
+    /**
+     * @brief Falls back to the usual setup if the image turns out to be stale: options added so
+     *        far are processed and all deferred setup calls are replayed. The image will be
+     *        re-created once the setup is finished.
+     */
+    void drop_schema_cache()
     {
-        bool result = false;
-        if (default_option != NULL)
+        cache_state = cache_to_write;
+        for (size_t i = 0; i < options.size(); i++)
         {
-            if(!default_option->name.size())
-            {
-                default_option->name = program_name;
-            }
-            default_option->execute();
-            result = true;
+            options.option_at(i)->complete_description();
         }
-        else
+        options.detach_image();
+        cache_image.release();
+
+        std::vector<deferred_setup> calls;
+        calls.swap(deferred);
+        setup_hash = 0; // (replayed calls are added to it again)
+        std::vector<deferred_setup>::iterator c;
+        for (c = calls.begin(); c != calls.end(); c++)
         {
-            std::vector<std::string> specified_full_names;
-            std::vector<std::string>::iterator i;
-
-            // convert our execute list into a list containing full option names
-            // we will need it for 'valid with these options' check
-            for(i = execute_list.begin(); i != execute_list.end(); i++)
+            switch (c->what)
             {
-                specified_full_names.push_back(options.find_option(*i)->name);
+            case deferred_setup::require_all:
+                setup_options_require_all(c->list);
+                break;
+            case deferred_setup::require_any_of:
+                setup_options_require_any_of(c->list);
+                break;
+            case deferred_setup::add_required:
+                setup_option_add_required(c->option_name, c->list);
+                break;
+            case deferred_setup::add_not_wanted:
+                setup_option_add_not_wanted(c->option_name, c->list);
+                break;
+            case deferred_setup::as_standalone:
+                setup_option_as_standalone(c->option_name);
+                break;
             }
+        }
+    }
 
-            if (options_required_all.size())
-            {
-                std::stringstream err_msg;
-                std::vector<std::string> isect = get_set_intersection(options_required_all, specified_full_names);
-                if (isect.size() != options_required_all.size())
-                {
-                    err_msg << "required following option(s): \n ";
-                    err_msg << merge_items_to_string(options_required_all) << "\n\n";
+    /**
+     * @brief Helper to convert (full) option names into ids.
+     */
+    static std::vector<uint32_t> ids_of(const std::vector<std::string>& names,
+                                        std::map<std::string, uint32_t>& ids_by_name)
+    {
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            result.push_back(ids_by_name[names[i]]);
+        }
+        return result;
+    }
 
-                    if(execute_list.size())
-                    {
-                        err_msg << "but specified only:\n ";
-                        err_msg << merge_items_to_string(execute_list);
-                    }
-                    else
-                    {
-                        err_msg << "but nothing was specified.";
-                    }
-                    err_msg << "\ntry " << help_options << " to see usage.\n";
-                    std::cout << "\n" << program_name << ": " << err_msg.str() << "\n";
-                    return false;
-                }
-            }
+    /**
+     * @brief Helper to create a mapping between full names of options and their ids.
+     */
+    void ids_by_full_name(std::map<std::string, uint32_t>& ids_by_name)
+    {
+        for (size_t i = 0; i < options.size(); i++)
+        {
+            ids_by_name[options.option_at(i)->name] = static_cast<uint32_t>(i);
+        }
+    }
 
-            if (optons_required_any_of.size())
-            {
-                std::stringstream err_msg;
-                std::vector<std::string> isect = get_set_intersection(optons_required_any_of, specified_full_names);
-                if (isect.size() == 0)
-                {
-                    err_msg << "at least one of the following option(s) is required:\n";
-                    std::string require_list = merge_items_to_string(optons_required_any_of);
-                    indent_and_trim(require_list, 2);
-                    err_msg << require_list;
-                    err_msg << "\n\ntry " << help_options << " to see usage.\n";
-                    std::cout << "\n" << program_name << ": " << err_msg.str() << "\n";
-                    return false;
-                }
-            }
+    /**
+     * @brief Stores the image of the schema. Failing to do so is not an error
+     *        (image will be created next time).
+     */
+    void save_schema_cache()
+    {
+        cache_state = cache_off;
+        if (default_option != NULL)
+        {
+            return;
+        }
 
-            for (i = execute_list.begin(); i != execute_list.end(); i++)
-            {
-                try
-                {
-                    option* option_to_execute = options.find_option(*i);
-                    if(option_to_execute)
-                    {
-                        option_to_execute->check_if_valid_with_these_options(specified_full_names);
-                    }
-                }
-                catch (const option_error& e)
-                {
-                    std::cout << "\n" << program_name << ": " <<  e.what() << std::endl;
-                    // should skip any execution if options were not right.
-                    execute_list.clear();
-                    break;
-                }
-            }
+        std::map<std::string, uint32_t> ids_by_name;
+        ids_by_full_name(ids_by_name);
 
-            if (execute_list.size())
-            {
-                for (i = execute_list.begin(); i != execute_list.end(); i++)
-                {
-                    option* option_to_execute = options.find_option(*i);
-                    if(option_to_execute) // TODO: similarly here..
-                    {
-                        option_to_execute->execute();
-                    }
-                }
-                result = true;
-            }
+        schema_image_writer writer(options.names());
+        for (size_t i = 0; i < options.size(); i++)
+        {
+            option* o = options.option_at(i);
+            schema_image_option record;
+            memset(&record, 0, sizeof(record));
+            record.name = writer.add_string(o->name);
+            record.usage = writer.add_string(o->doc->usage);
+            record.num_params = static_cast<uint32_t>(o->num_params());
+            record.flags = o->standalone ? schema_image_option::f_standalone : 0;
+
+            std::vector<uint32_t> ids = ids_of(o->doc->required_options, ids_by_name);
+            record.required_count = static_cast<uint32_t>(ids.size());
+            record.required_first = writer.add_ids(ids);
+
+            ids = ids_of(o->doc->not_wanted_options, ids_by_name);
+            record.not_wanted_count = static_cast<uint32_t>(ids.size());
+            record.not_wanted_first = writer.add_ids(ids);
+            writer.add_option(record);
         }
-        return result;
+        writer.set_required_all(ids_of(options_required_all, ids_by_name));
+        writer.set_any_of(ids_of(optons_required_any_of, ids_by_name));
+
+        std::stringstream help;
+        options.create_help(help);
+        writer.set_help(help.str());
+        writer.set_setup_hash(setup_hash);
+        writer.write(cache_path, cache_key);
     }
 
     OptionContainer options;
@@ -3221,6 +6691,65 @@ protected:
     std::vector<std::string> execute_list;
     std::vector<std::string> options_required_all;
     std::vector<std::string> optons_required_any_of;
+    std::ostream* messages; // (help and errors found in the command line are printed here)
+    bool execute_handlers;
+    bool nothing_specified; // (the last command line was valid, but without options)
+
+    /**
+     * @brief Where parameters of a "first_wins" option start in the command line.
+     */
+    struct first_occurrence
+    {
+        option* o;
+        std::streamoff params_at;
+        bool overwritten;
+    };
+
+    dynamic_bitset occurred; // (options found so far in the command line)
+    std::vector<first_occurrence> first_occurrences;
+    bool passthrough_enabled;
+    char* const* passthrough_args;
+    int passthrough_count;
+    cmd_line_parser* next_parser; // (see add_chained_parser())
+    std::vector<int>* unclaimed_args; // (if not NULL, unknown arguments are passed here)
+
+    enum cache_states
+    {
+        cache_off,
+        cache_to_write,
+        cache_attached,
+        cache_in_use
+    };
+
+    schema_image cache_image;
+    std::string cache_path;
+    std::string cache_key;
+    int cache_state;
+    std::vector<deferred_setup> deferred;
+    uint32_t setup_hash; // (of setup calls made since use_schema_cache())
+
+    bool dependencies_ready;
+    std::vector<size_t> dependencies_of; // position in dependencies (by option id), or npos
+    std::vector<option_dependencies> dependencies;
+    dynamic_bitset required_all_set;
+    dynamic_bitset required_any_of_set;
+    dynamic_bitset specified;
+    bool compacted; // (see compact())
+    uint32_t fingerprint; // (see schema_fingerprint())
+    bool fingerprint_ready;
+
+    // buffers used while parsing: they are kept between calls to run() (or parse()),
+    // so that a long-running process, parsing one command line after another, does not
+    // allocate memory for each of them once these buffers are big enough.
+    std::string parsed_text;
+    cmd_line_stream parsed_cmd_line;
+    std::string next_token;
+    std::vector<std::string> specified_full_names;
+    std::vector<std::string> spare_strings; // (see recycle())
+    uint64_t parse_started; // (see parsing_finished())
+    uint64_t parse_duration;
+    parser_latency latencies;
+    std::string stats_command; // (see setup_stats_command())
 };
 
 /**
@@ -3231,14 +6760,13 @@ protected:
  * @param name: name of the option. This name is a key, that the command-line option is selected with.
  *        It should be unique, and if an option with a given name exists - option_error will be thrown.
  * @param description: a sort of brief explanation what the option is meant for.
- * @return id for_this option, or -1 if it couldn't be added (e.g. option with the same name exists).
- *         This id can be used against cmd_line_parser::run() return to see if this option has executed.
+ * @return handle of the option, that can be used to set-up dependencies (see option_handle).
  */
 template<class RetType>
-inline void cmd_line_parser::add_option(RetType function_ptr(), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(), std::string name,
                 std::string description)
 {
-    add_option(new option_no_params<RetType (*)()>(function_ptr, name), description);
+    return add_option(new option_no_params<RetType (*)()>(function_ptr, name), description);
 }
 
 /**
@@ -3249,19 +6777,18 @@ inline void cmd_line_parser::add_option(RetType function_ptr(), std::string name
  * @param name: name of the option. This name is a key, that the command-line option is selected with.
  *        It should be unique, and if an option with a given name exists - option_error will be thrown.
  * @param description: a sort of brief explanation what the option is meant for.
- * @return id for_this option, or -1 if it couldn't be added (e.g. option with the same name exists).
- *         This id can be used against cmd_line_parser::run() return to see if this option has executed.
+ * @return handle of the option, that can be used to set-up dependencies (see option_handle).
  * @note that this template uses STATIC_ASSERT macros to check if each of the parameters could be extracted.
  *       This is to ensure at compile time - that the function pointed by function_ptr is suitable.
  *       if you get this assertion it means that one or more of the parameter types for this function is
  *       not supported - and such a function can't be used as 'command-line option' prototype.
  */
 template<class RetType, typename P1>
-inline void cmd_line_parser::add_option(RetType function_ptr(P1), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(P1), std::string name,
                 std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
-    add_option(new option_1_param<RetType (*)(P1), P1>(function_ptr, name), description);
+    return add_option(new option_1_param<RetType (*)(P1), P1>(function_ptr, name), description);
 }
 
 /**
@@ -3272,20 +6799,19 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1), std::string na
  * @param name: name of the option. This name is a key, that the command-line option is selected with.
  *        It should be unique, and if an option with a given name exists - option_error will be thrown.
  * @param description: a sort of brief explanation what the option is meant for.
- * @return id for_this option, or -1 if it couldn't be added (e.g. option with the same name exists).
- *         This id can be used against cmd_line_parser::run() return to see if this option has executed.
+ * @return handle of the option, that can be used to set-up dependencies (see option_handle).
  * @note that this template uses STATIC_ASSERT macros to check if each of the parameters could be extracted.
  *       This is to ensure at compile time - that the function pointed by function_ptr is suitable.
  *       if you get this assertion it means that one or more of the parameter types for this function is
  *       not supported - and such a function can't be used as 'command-line option' prototype.
  */
 template<class RetType, typename P1, typename P2>
-inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(P1, P2), std::string name,
                 std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
-    add_option(new option_2_params<RetType (*)(P1, P2), P1, P2>(function_ptr, name), description);
+    return add_option(new option_2_params<RetType (*)(P1, P2), P1, P2>(function_ptr, name), description);
 }
 
 /**
@@ -3295,13 +6821,13 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2), std::strin
  * Description is similar to other similar add_option method templates.
  */
 template<class RetType, typename P1, typename P2, typename P3>
-inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3), std::string name,
                 std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
-    add_option(new option_3_params<RetType (*)(P1, P2, P3), P1, P2, P3>(function_ptr, name),
+    return add_option(new option_3_params<RetType (*)(P1, P2, P3), P1, P2, P3>(function_ptr, name),
                description);
 }
 
@@ -3312,14 +6838,14 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3), std::s
  * Description is similar to other similar add_option method templates.
  */
 template<class RetType, typename P1, typename P2, typename P3, typename P4>
-inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4), std::string name,
                 std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P4);
-    add_option(new option_4_params<RetType (*)(P1, P2, P3, P4), P1, P2, P3, P4>(function_ptr, name),
+    return add_option(new option_4_params<RetType (*)(P1, P2, P3, P4), P1, P2, P3, P4>(function_ptr, name),
                description);
 }
 
@@ -3330,7 +6856,7 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4), st
  * Description is similar to other similar add_option method templates.
  */
 template<class RetType, typename P1, typename P2, typename P3, typename P4, typename P5>
-inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5), std::string name,
                 std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
@@ -3338,7 +6864,7 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5)
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P4);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P5);
-    add_option(new option_5_params<RetType (*)(P1, P2, P3, P4, P5), P1, P2, P3, P4, P5>(function_ptr, name),
+    return add_option(new option_5_params<RetType (*)(P1, P2, P3, P4, P5), P1, P2, P3, P4, P5>(function_ptr, name),
                description);
 }
 
@@ -3350,7 +6876,7 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5)
  */
 // (TODO: really need variadic-template version of this!)
 template<class RetType, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
-inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5, P6), std::string name,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5, P6), std::string name,
                 std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
@@ -3359,7 +6885,7 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5,
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P4);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P5);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P6);
-    add_option(new option_6_params<RetType (*)(P1, P2, P3, P4, P5, P6), P1, P2, P3, P4, P5, P6>(function_ptr, name),
+    return add_option(new option_6_params<RetType (*)(P1, P2, P3, P4, P5, P6), P1, P2, P3, P4, P5, P6>(function_ptr, name),
                description);
 }
 
@@ -3373,14 +6899,13 @@ inline void cmd_line_parser::add_option(RetType function_ptr(P1, P2, P3, P4, P5,
  * @param name: name of the option. This name is a key, that the command-line option is selected with.
  *        It should be unique, and if an option with a given name exists - option_error will be thrown.
  * @param description: a sort of brief explanation what the option is meant for.
- * @return id for_this option, or -1 if it couldn't be added (e.g. option with the same name exists).
- *         This id can be used against cmd_line_parser::run() return to see if this option has executed.
+ * @return handle of the option, that can be used to set-up dependencies (see option_handle).
  */
 template<class RetType, typename ObjType>
-inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*), ObjType* obj_address,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(ObjType*), ObjType* obj_address,
                 std::string name, std::string description)
 {
-    add_option(new option_no_params_pass_obj<RetType (*)(ObjType*), ObjType>(function_ptr,
+    return add_option(new option_no_params_pass_obj<RetType (*)(ObjType*), ObjType>(function_ptr,
                                                                             obj_address, name),
                description);
 }
@@ -3395,19 +6920,18 @@ inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*), ObjType*
  * @param name: name of the option. This name is a key, that the command-line option is selected with.
  *        It should be unique, and if an option with a given name exists - option_error will be thrown.
  * @param description: a sort of brief explanation what the option is meant for.
- * @return id for_this option, or -1 if it couldn't be added (e.g. option with the same name exists).
- *         This id can be used against cmd_line_parser::run() return to see if this option has executed.
+ * @return handle of the option, that can be used to set-up dependencies (see option_handle).
  * @note that this template uses STATIC_ASSERT macros to check if each of the parameters could be extracted.
  *       This is to ensure at compile time - that the function pointed by function_ptr is suitable.
  *       if you get this assertion it means that one or more of the parameter types for this function is
  *       not supported - and such a function can't be used as 'command-line option' prototype.
  */
 template<class RetType, typename ObjType, typename P1>
-inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1), ObjType* obj_address,
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1), ObjType* obj_address,
                 std::string name, std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
-    add_option(new option_1_param_pass_obj<RetType (*)(ObjType*, P1), ObjType, P1>(function_ptr,
+    return add_option(new option_1_param_pass_obj<RetType (*)(ObjType*, P1), ObjType, P1>(function_ptr,
                                                                                    obj_address, 
                                                                                    name),
                description);
@@ -3420,12 +6944,12 @@ inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1), ObjT
  * Description is similar to other add_option method templates that take ObjType parameter.
  */
 template<class RetType, typename ObjType, typename P1, typename P2>
-inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2),
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2),
                 ObjType* obj_address, std::string name, std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
-    add_option(new option_2_params_pass_obj<RetType (*)(ObjType*, P1, P2), ObjType, P1, P2>(function_ptr,
+    return add_option(new option_2_params_pass_obj<RetType (*)(ObjType*, P1, P2), ObjType, P1, P2>(function_ptr,
                                                                                             obj_address,
                                                                                             name),
                description);
@@ -3438,13 +6962,13 @@ inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2),
  * Description is similar to other add_option method templates that take ObjType parameter.
  */
 template<class RetType, typename ObjType, typename P1, typename P2, typename P3>
-inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P3),
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P3),
                 ObjType* obj_address, std::string name, std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
-    add_option(new option_3_params_pass_obj<RetType (*)(ObjType*, P1, P2, P3), ObjType, P1, P2, P3>(function_ptr,
+    return add_option(new option_3_params_pass_obj<RetType (*)(ObjType*, P1, P2, P3), ObjType, P1, P2, P3>(function_ptr,
                                                                                                     obj_address,
                                                                                                     name),
                description);
@@ -3458,14 +6982,14 @@ inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P
  * Description is similar to other add_option method templates that take ObjType parameter.
  */
 template<class RetType, typename ObjType, typename P1, typename P2, typename P3, typename P4>
-inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4),
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4),
                 ObjType* obj_address, std::string name, std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P4);
-    add_option(new option_4_params_pass_obj<RetType (*)(ObjType*, P1, P2, P3, P4), ObjType, P1, P2, P3, P4>(
+    return add_option(new option_4_params_pass_obj<RetType (*)(ObjType*, P1, P2, P3, P4), ObjType, P1, P2, P3, P4>(
                     function_ptr, obj_address, name),
                     description);
 }
@@ -3478,7 +7002,7 @@ inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P
  */
 //(TODO: really need variadic-template version of this!)
 template<class RetType, typename ObjType, typename P1, typename P2, typename P3, typename P4, typename P5>
-inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4, P5),
+inline option_handle cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P3, P4, P5),
                 ObjType* obj_address, std::string name, std::string description)
 {
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
@@ -3486,9 +7010,124 @@ inline void cmd_line_parser::add_option(RetType function_ptr(ObjType*, P1, P2, P
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P4);
     STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P5);
-    add_option(new option_5_params_pass_obj<RetType (*)(ObjType*, P1, P2, P3, P4, P5), ObjType, P1, P2, P3, P4, P5>(
+    return add_option(new option_5_params_pass_obj<RetType (*)(ObjType*, P1, P2, P3, P4, P5), ObjType, P1, P2, P3, P4, P5>(
                     function_ptr, obj_address, name),
                     description);
 }
 
+/**
+ * @brief Adds an option, which handler is executed once (after all options were found), with
+ *        parameters of all occurrences of this option. Values of each of parameters are passed
+ *        in a (contiguous) vector, in the order they were found, e.g.:
+ *
+ * @code
+ * void points(const std::vector<int>& x, const std::vector<int>& y)
+ * {
+ *     // x[i], y[i]: i-th point
+ * }
+ * ...
+ * parser.add_aggregated_option(points, "-p", "adds a point @param x x @param y y");
+ * @endcode
+ *
+ *        Otherwise it's the same as add_option() (taking a function with the same number
+ *        of parameters).
+ */
+template<class RetType, typename P1>
+inline option_handle cmd_line_parser::add_aggregated_option(RetType function_ptr(const std::vector<P1>&),
+                std::string name, std::string description)
+{
+    STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
+    return add_option(new option_aggregated_1_param<RetType (*)(const std::vector<P1>&), P1>(function_ptr,
+                                                                                      name),
+               description);
+}
+
+/**
+ * @brief Adds an option, which handler is executed once with parameters of all occurrences.
+ * Description is similar to other add_aggregated_option method templates.
+ */
+template<class RetType, typename P1, typename P2>
+inline option_handle cmd_line_parser::add_aggregated_option(RetType function_ptr(const std::vector<P1>&,
+                                                                        const std::vector<P2>&),
+                std::string name, std::string description)
+{
+    STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
+    STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
+    return add_option(new option_aggregated_2_params<RetType (*)(const std::vector<P1>&,
+                                                          const std::vector<P2>&), P1, P2>(function_ptr,
+                                                                                           name),
+               description);
+}
+
+/**
+ * @brief Adds an option, which handler is executed once with parameters of all occurrences.
+ * Description is similar to other add_aggregated_option method templates.
+ */
+template<class RetType, typename P1, typename P2, typename P3>
+inline option_handle cmd_line_parser::add_aggregated_option(RetType function_ptr(const std::vector<P1>&,
+                                                                        const std::vector<P2>&,
+                                                                        const std::vector<P3>&),
+                std::string name, std::string description)
+{
+    STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P1);
+    STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P2);
+    STATIC_ASSERT_IF_CAN_BE_EXTRACTED(P3);
+    return add_option(new option_aggregated_3_params<RetType (*)(const std::vector<P1>&,
+                                                          const std::vector<P2>&,
+                                                          const std::vector<P3>&), P1, P2, P3>(
+                    function_ptr, name),
+               description);
+}
+
+/**
+ * @brief Adds an option with the handler (see cmd_line_option_entry), e.g.:
+ *        cmd_line_option_adder<void (*)(int), verbose>.
+ */
+template<class Handler, Handler handler>
+inline void cmd_line_option_adder(cmd_line_parser& parser, const char* name, const char* description)
+{
+    parser.add_option(handler, name, description);
+}
+
+#ifdef CMD_LINE_OPTIONS_STATIC_REGISTRATION
+#define CMD_LINE_OPTION_PASTE0(x, y)  x ## y
+#define CMD_LINE_OPTION_PASTE(x, y)  CMD_LINE_OPTION_PASTE0(x, y)
+
+/**
+ * @brief Declares an option next to its handler. It can be used (at file scope) in any number
+ *        of translation units, and all options declared this way are added to the parser
+ *        by calling cmd_line_parser::add_registered_options(). e.g.:
+ *
+ *          void verbose(int level) { ... }
+ *          CMD_LINE_OPTION(verbose, "v,--verbose", "sets verbosity @param level 0-3");
+ *
+ *        Handler can be any of the functions accepted by cmd_line_parser::add_option()
+ *        (parameter types are deduced as usual). If its name contains a comma (e.g. an
+ *        instance of a function template) - use a typedef or wrap it in parentheses.
+ */
+#define CMD_LINE_OPTION(handler, option_name, option_description) \
+    CMD_LINE_OPTION_WITH_ID(handler, option_name, option_description, CMD_LINE_OPTION_UNIQUE_ID)
+
+/**
+ * @brief Unique part of names of objects defined by CMD_LINE_OPTION(). __LINE__ is only unique
+ *        within a file, so (if supported) __COUNTER__ is used, allowing e.g. to use the macro
+ *        in other macros or in headers.
+ */
+#ifdef __COUNTER__
+#define CMD_LINE_OPTION_UNIQUE_ID  __COUNTER__
+#else
+#define CMD_LINE_OPTION_UNIQUE_ID  __LINE__
+#endif
+
+#define CMD_LINE_OPTION_WITH_ID(handler, option_name, option_description, id) \
+    static void CMD_LINE_OPTION_PASTE(cmd_line_option_add_, id)( \
+                    cmd_line_parser& parser, const char* name, const char* description) \
+    { \
+        parser.add_option(handler, name, description); \
+    } \
+    static cmd_line_option_descriptor CMD_LINE_OPTION_PASTE(cmd_line_option_, id) \
+        __attribute__((section("cmd_line_options"), aligned(sizeof(void*)), used)) = \
+        { option_name, option_description, CMD_LINE_OPTION_PASTE(cmd_line_option_add_, id) }
+#endif /* CMD_LINE_OPTIONS_STATIC_REGISTRATION */
+
 #endif /* CMD_LINE_OPTIONS_ */
@@ -0,0 +1,45 @@
+/*
+ * example_lint.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  @brief This is an example of a linter: it checks command lines (e.g. generated ones, one
+ *         per line) against the schema of a tool (here: of example2) without running them.
+ */
+
+#include "cmd_line_lint.h"
+
+void nothing()
+{
+}
+
+// the same options as in example2 (handlers are never called by the linter)
+void define_example2_options(cmd_line_parser& parser)
+{
+    parser.add_option(nothing, "-a,option_a", "simple option - no specific requirements");
+    parser.add_option(nothing, "bb", "another option - no specific requirements");
+    parser.add_option(nothing, "a_b", "option that requires specifying another two..");
+    parser.add_option(nothing, "a_only", "only use with a specific sub-set of options.");
+    parser.add_option(nothing, "b_only", "also with only specific sub-set of options.");
+    parser.add_option(nothing, "standalone", "If specified-it should be the only option.");
+
+    parser.setup_option_add_required("a_b", "-a, bb");
+    parser.setup_option_add_not_wanted("a_only", "bb, a_b, standalone");
+    parser.setup_option_add_not_wanted("b_only", "option_a, a_b, standalone");
+    parser.setup_option_as_standalone("standalone");
+}
+
+int main(int argc, char **argv)
+{
+    return cmd_line_lint_main(argc, argv, define_example2_options);
+}
+
+/* Example outputs:
+ ____________________________________
+
+ ~$ printf 'example2 a_b -a bb\nexample2 a_b\n\nexample2 standalone bb\n' | ./example_lint
+-:2: example2: error: option "a_b" requires also: "-a,option_a", "bb"
+-:4: example2: error: option "standalone" can't be used with other options, but specified with: "bb"
+3 command line(s) checked
+ ____________________________________
+*/
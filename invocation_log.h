@@ -0,0 +1,392 @@
+/**
+ * @file   invocation_log.h
+ * @date   17 Oct 2026
+ * @brief  Recording of command lines (argv) the program was invoked with, and replaying
+ *         them through the parser (without executing handlers) to measure its latency.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INVOCATION_LOG_H_
+#define INVOCATION_LOG_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "cmd_line_options.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INVOCATION_LOG_USE_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Header of each record of the log. It is followed by argc arguments, each stored
+ *        as its length (uint32_t) followed by its characters (not terminated).
+ *        Values are stored in the native byte order.
+ */
+struct invocation_record_header
+{
+    enum constants
+    {
+        record_magic = 0x4c494c43 // "CLIL"
+    };
+
+    uint32_t magic;
+    uint32_t size;        // of the record, including this header
+    uint32_t fingerprint; // of the schema (see cmd_line_parser::schema_fingerprint())
+    uint32_t argc;
+};
+
+/**
+ * @brief Appends command lines to the log. Recording is opt-in: the program has to create
+ *        the recorder and record its argv (usually just before calling run()), e.g.:
+ *
+ * @code
+ *  invocation_recorder recorder("/var/tmp/my_tool.invocations");
+ *  recorder.record(parser, argc, argv);
+ *  parser.run(argc, argv);
+ * @endcode
+ *
+ *        Each record is appended with a single write, so that the log can be shared
+ *        by many processes.
+ */
+class invocation_recorder
+{
+public:
+    invocation_recorder() :
+                    fd(-1),
+                    file(NULL)
+    {
+    }
+
+    explicit invocation_recorder(const std::string& path) :
+                    fd(-1),
+                    file(NULL)
+    {
+        open(path);
+    }
+
+    ~invocation_recorder()
+    {
+        close();
+    }
+
+    /**
+     * @brief Opens (or creates) the log.
+     * @return true if successful.
+     */
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef INVOCATION_LOG_USE_POSIX
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        return fd >= 0;
+#else
+        file = fopen(path.c_str(), "ab");
+        return file != NULL;
+#endif
+    }
+
+    void close()
+    {
+#ifdef INVOCATION_LOG_USE_POSIX
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+#endif
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        fd = -1;
+        file = NULL;
+    }
+
+    bool is_open() const
+    {
+        return fd >= 0 || file != NULL;
+    }
+
+    /**
+     * @brief Records the command line together with the fingerprint of the parser's schema
+     *        (it is cached by the parser, so it's not re-computed for each record).
+     * @return true if the record was written.
+     */
+    bool record(cmd_line_parser& parser, int argc, char* const argv[])
+    {
+        return record(argc, argv, parser.schema_fingerprint());
+    }
+
+    /**
+     * @brief Records the command line.
+     * @return true if the record was written.
+     */
+    bool record(int argc, char* const argv[], uint32_t fingerprint)
+    {
+        if (!is_open() || argc < 0 || (argc > 0 && argv == NULL))
+        {
+            return false;
+        }
+
+        invocation_record_header h;
+        h.magic = invocation_record_header::record_magic;
+        h.size = 0;
+        h.fingerprint = fingerprint;
+        h.argc = static_cast<uint32_t>(argc);
+
+        buffer.resize(sizeof(h));
+        for (int i = 0; i < argc; i++)
+        {
+            uint32_t len = static_cast<uint32_t>(strlen(argv[i]));
+            const char* len_bytes = reinterpret_cast<const char*>(&len);
+            buffer.insert(buffer.end(), len_bytes, len_bytes + sizeof(len));
+            buffer.insert(buffer.end(), argv[i], argv[i] + len);
+        }
+        h.size = static_cast<uint32_t>(buffer.size());
+        memcpy(&buffer[0], &h, sizeof(h));
+
+#ifdef INVOCATION_LOG_USE_POSIX
+        if (fd >= 0)
+        {
+            return write(fd, &buffer[0], buffer.size()) == static_cast<ssize_t>(buffer.size());
+        }
+#endif
+        bool written = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+        return fflush(file) == 0 && written;
+    }
+
+private:
+    invocation_recorder(const invocation_recorder&);
+    invocation_recorder& operator=(const invocation_recorder&);
+
+    int fd;
+    FILE* file;
+    std::vector<char> buffer;
+};
+
+/**
+ * @brief Command line read from the log.
+ */
+struct recorded_invocation
+{
+    uint32_t fingerprint;
+    std::vector<std::string> args;
+};
+
+/**
+ * @brief Reads all records from the log. Reading stops at the first record that is not
+ *        complete or not valid (e.g. if the program was writing it while it was killed).
+ * @param path - location of the log.
+ * @param invocations - records are appended to this vector.
+ * @return number of bytes that were not read (i.e. 0 if the whole log was valid).
+ * @throws option_error if the log can't be read.
+ */
+inline size_t read_invocation_log(const std::string& path,
+                                  std::vector<recorded_invocation>& invocations)
+{
+    std::vector<char> data;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+    {
+        std::stringstream err;
+        err << "can't open invocation log: \"" << path << "\"";
+        throw option_error(err.str());
+    }
+    char chunk[64 * 1024];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    size_t at = 0;
+    while (data.size() - at >= sizeof(invocation_record_header))
+    {
+        invocation_record_header h;
+        memcpy(&h, &data[at], sizeof(h));
+        if (h.magic != invocation_record_header::record_magic ||
+            h.size < sizeof(h) || h.size > data.size() - at)
+        {
+            break;
+        }
+
+        recorded_invocation invocation;
+        invocation.fingerprint = h.fingerprint;
+        size_t pos = at + sizeof(h);
+        size_t end = at + h.size;
+        bool valid = true;
+        for (uint32_t i = 0; valid && i < h.argc; i++)
+        {
+            uint32_t len = 0;
+            valid = end - pos >= sizeof(len);
+            if (valid)
+            {
+                memcpy(&len, &data[pos], sizeof(len));
+                pos += sizeof(len);
+                valid = end - pos >= len;
+            }
+            if (valid)
+            {
+                invocation.args.push_back(std::string(data.begin() + pos, data.begin() + pos + len));
+                pos += len;
+            }
+        }
+        if (!valid || pos != end)
+        {
+            break;
+        }
+        invocations.push_back(invocation);
+        at = end;
+    }
+    return data.size() - at;
+}
+
+/**
+ * @brief Results of replaying the log. Latencies are in nanoseconds.
+ */
+struct replay_stats
+{
+    replay_stats() :
+                    invocations(0),
+                    skipped(0),
+                    failed(0),
+                    p50(0),
+                    p90(0),
+                    p99(0),
+                    max(0)
+    {
+    }
+
+    size_t invocations; // replayed
+    size_t skipped;     // recorded for a different schema
+    size_t failed;      // parser returned false (or threw)
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const replay_stats& stats)
+{
+    out << "replayed: " << stats.invocations << " (failed: " << stats.failed;
+    out << ", skipped: " << stats.skipped << ")";
+    out << ", latency [ns]: p50: " << stats.p50 << ", p90: " << stats.p90;
+    out << ", p99: " << stats.p99 << ", max: " << stats.max;
+    return out;
+}
+
+/**
+ * @brief Stream buffer that discards everything (the parser reports errors and help to
+ *        std::cout, which should not be measured while replaying).
+ */
+class null_streambuf: public std::streambuf
+{
+protected:
+    virtual int overflow(int c)
+    {
+        return std::char_traits<char>::not_eof(c);
+    }
+};
+
+/**
+ * @brief Replays recorded command lines through the parser using cmd_line_parser::parse(),
+ *        (i.e. no handlers are executed) and measures latency of each of them.
+ * @param parser - parser with all options set-up (i.e. as the program would run it).
+ * @param path - location of the log.
+ * @param only_same_schema - if true: command lines recorded with a different schema are skipped.
+ * @throws option_error if the log can't be read.
+ */
+inline replay_stats replay_invocations(cmd_line_parser& parser, const std::string& path,
+                                       bool only_same_schema = true)
+{
+    std::vector<recorded_invocation> invocations;
+    read_invocation_log(path, invocations);
+
+    replay_stats stats;
+    uint32_t fingerprint = parser.schema_fingerprint();
+
+    // prepare all argv arrays first: only the parser should be measured
+    std::vector<std::vector<char*> > argvs;
+    for (size_t i = 0; i < invocations.size(); i++)
+    {
+        if (only_same_schema && invocations[i].fingerprint != fingerprint)
+        {
+            stats.skipped++;
+            continue;
+        }
+        std::vector<std::string>& args = invocations[i].args;
+        argvs.push_back(std::vector<char*>());
+        for (size_t a = 0; a < args.size(); a++)
+        {
+            argvs.back().push_back(const_cast<char*>(args[a].c_str()));
+        }
+        argvs.back().push_back(NULL);
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(argvs.size());
+    null_streambuf discard;
+    std::streambuf* prev = std::cout.rdbuf(&discard);
+    for (size_t i = 0; i < argvs.size(); i++)
+    {
+        bool result = false;
+        uint64_t start = cmd_line_time_ns();
+        try
+        {
+            result = parser.parse(static_cast<int>(argvs[i].size() - 1), &argvs[i][0]);
+        }
+        catch (const option_error&)
+        {
+        }
+        catch (...)
+        {
+            std::cout.rdbuf(prev);
+            throw;
+        }
+        latencies.push_back(cmd_line_time_ns() - start);
+        stats.failed += result ? 0 : 1;
+    }
+    std::cout.rdbuf(prev);
+
+    stats.invocations = latencies.size();
+    if (latencies.size())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        stats.p50 = latencies[(latencies.size() - 1) * 50 / 100];
+        stats.p90 = latencies[(latencies.size() - 1) * 90 / 100];
+        stats.p99 = latencies[(latencies.size() - 1) * 99 / 100];
+        stats.max = latencies.back();
+    }
+    return stats;
+}
+
+#endif /* INVOCATION_LOG_H_ */
@@ -0,0 +1,327 @@
+/**
+ * @file   latency_histogram.h
+ * @date   17 Oct 2026
+ * @brief  HDR-style (log-linear) histograms of latencies: recording a value is a few
+ *         instructions and does not allocate memory, percentiles are accurate to ~12%.
+ *         They are used by the parser to keep latencies of parsing and of handlers.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <ostream>
+
+/**
+ * @brief Histogram of values (e.g. latencies in nanoseconds). Values below 8 are counted
+ *        exactly, bigger ones - in buckets: there are 8 of them for each power of two,
+ *        so that the value reported for a bucket is at most 1/8 bigger than values counted
+ *        in it. Values up to 2^36 (i.e. over a minute in ns) are distinguished, bigger ones are
+ *        counted in the last bucket (for which the maximum value is reported).
+ */
+class latency_histogram
+{
+public:
+    enum constants
+    {
+        sub_bucket_bits = 3,
+        sub_buckets = 1 << sub_bucket_bits,
+        max_shift = 32,
+        buckets = sub_buckets + (max_shift + 1) * sub_buckets
+    };
+
+    latency_histogram()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        sum = 0;
+        min_value = 0;
+        max_value = 0;
+    }
+
+    void record(uint64_t value)
+    {
+        counts[bucket_of(value)]++;
+        min_value = (total == 0 || value < min_value) ? value : min_value;
+        max_value = value > max_value ? value : max_value;
+        sum += value;
+        total++;
+    }
+
+    /**
+     * @brief Adds values recorded by the other histogram to this one.
+     */
+    void merge(const latency_histogram& other)
+    {
+        if (other.total == 0)
+        {
+            return;
+        }
+        for (size_t i = 0; i < buckets; i++)
+        {
+            counts[i] += other.counts[i];
+        }
+        min_value = (total == 0 || other.min_value < min_value) ? other.min_value : min_value;
+        max_value = other.max_value > max_value ? other.max_value : max_value;
+        sum += other.sum;
+        total += other.total;
+    }
+
+    uint64_t count() const
+    {
+        return total;
+    }
+
+    uint64_t min() const
+    {
+        return min_value;
+    }
+
+    uint64_t max() const
+    {
+        return max_value;
+    }
+
+    uint64_t mean() const
+    {
+        return total ? sum / total : 0;
+    }
+
+    /**
+     * @brief Returns the value, that (at least) the specified percent of recorded values
+     *        are not bigger than (i.e. the highest value of their bucket), or 0 if nothing
+     *        was recorded.
+     */
+    uint64_t percentile(double percent) const
+    {
+        if (total == 0)
+        {
+            return 0;
+        }
+        double exact = percent * total / 100.0;
+        uint64_t wanted = static_cast<uint64_t>(exact);
+        wanted += (wanted < exact) ? 1 : 0;
+        wanted = wanted < 1 ? 1 : (wanted > total ? total : wanted);
+        uint64_t so_far = 0;
+        for (size_t i = 0; i < buckets; i++)
+        {
+            so_far += counts[i];
+            if (so_far >= wanted && i + 1 < buckets)
+            {
+                uint64_t highest = highest_value_of(i);
+                return highest < max_value ? highest : max_value;
+            }
+        }
+        return max_value;
+    }
+
+    /**
+     * @brief Returns index of the bucket the value is counted in.
+     */
+    static size_t bucket_of(uint64_t value)
+    {
+        if (value < sub_buckets)
+        {
+            return static_cast<size_t>(value);
+        }
+#ifdef __GNUC__
+        size_t msb = 63 - __builtin_clzll(value);
+#else
+        size_t msb = 0;
+        for (uint64_t v = value >> 1; v != 0; v >>= 1)
+        {
+            msb++;
+        }
+#endif
+        size_t shift = msb - sub_bucket_bits;
+        if (shift > max_shift)
+        {
+            return buckets - 1;
+        }
+        size_t sub_bucket = static_cast<size_t>(value >> shift) - sub_buckets;
+        return sub_buckets + shift * sub_buckets + sub_bucket;
+    }
+
+    /**
+     * @brief Returns the highest value counted in the bucket.
+     */
+    static uint64_t highest_value_of(size_t bucket)
+    {
+        if (bucket < sub_buckets)
+        {
+            return bucket;
+        }
+        size_t shift = (bucket - sub_buckets) / sub_buckets;
+        uint64_t sub_bucket = sub_buckets + (bucket - sub_buckets) % sub_buckets;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+private:
+    uint64_t counts[buckets];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t min_value;
+    uint64_t max_value;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const latency_histogram& h)
+{
+    out << "count: " << h.count() << ", p50: " << h.percentile(50);
+    out << ", p90: " << h.percentile(90) << ", p99: " << h.percentile(99);
+    out << ", p99.9: " << h.percentile(99.9) << ", max: " << h.max();
+    return out;
+}
+
+/**
+ * @brief Latencies (in nanoseconds) of parsing command lines and of executing handlers
+ *        of each of options. Histograms of handlers are indexed by ids of their options,
+ *        each of them is created the first time the handler is executed, i.e. there are
+ *        only histograms of handlers that were executed.
+ */
+struct parser_latency
+{
+    parser_latency()
+    {
+    }
+
+    parser_latency(const parser_latency& other) :
+                    parse(other.parse)
+    {
+        merge_handlers(other);
+    }
+
+    parser_latency& operator=(const parser_latency& other)
+    {
+        if (this != &other)
+        {
+            release();
+            parse = other.parse;
+            merge_handlers(other);
+        }
+        return *this;
+    }
+
+    ~parser_latency()
+    {
+        release();
+    }
+
+    /**
+     * @brief Adds latencies recorded by the other parser to these ones. Handlers are
+     *        identified by ids of their options, so both parsers should have the same
+     *        options (e.g. each of threads has its own parser, all of them set-up the same way).
+     */
+    void merge(const parser_latency& other)
+    {
+        parse.merge(other.parse);
+        merge_handlers(other);
+    }
+
+    /**
+     * @brief Forgets recorded values (histograms are kept, so that recording them again
+     *        doesn't allocate memory).
+     */
+    void reset()
+    {
+        parse.reset();
+        for (size_t id = 0; id < handlers.size(); id++)
+        {
+            if (handlers[id] != NULL)
+            {
+                handlers[id]->reset();
+            }
+        }
+    }
+
+    /**
+     * @brief Returns histogram of the handler of the option (of the specified id), it is
+     *        created if there's none yet.
+     */
+    latency_histogram& handler(size_t id)
+    {
+        if (id >= handlers.size())
+        {
+            handlers.resize(id + 1, NULL);
+        }
+        if (handlers[id] == NULL)
+        {
+            handlers[id] = new latency_histogram;
+        }
+        return *handlers[id];
+    }
+
+    /**
+     * @brief Returns histogram of the handler of the option (of the specified id), or NULL
+     *        if the handler was never executed.
+     */
+    const latency_histogram* find_handler(size_t id) const
+    {
+        return id < handlers.size() ? handlers[id] : NULL;
+    }
+
+    /**
+     * @brief Returns number of ids, that histograms of handlers could be found for,
+     *        (i.e. the highest one + 1).
+     */
+    size_t handler_ids() const
+    {
+        return handlers.size();
+    }
+
+    latency_histogram parse;
+
+private:
+    void merge_handlers(const parser_latency& other)
+    {
+        for (size_t id = 0; id < other.handlers.size(); id++)
+        {
+            if (other.handlers[id] != NULL)
+            {
+                handler(id).merge(*other.handlers[id]);
+            }
+        }
+    }
+
+    void release()
+    {
+        for (size_t id = 0; id < handlers.size(); id++)
+        {
+            delete handlers[id];
+        }
+        handlers.clear();
+    }
+
+    std::vector<latency_histogram*> handlers; // (indexed by option::id)
+};
+
+#endif /* LATENCY_HISTOGRAM_H_ */
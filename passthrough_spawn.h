@@ -0,0 +1,100 @@
+/**
+ * @file   passthrough_spawn.h
+ * @date   17 Oct 2026
+ * @brief  Spawning a child process from arguments that followed "--" in the command line
+ *         (see cmd_line_parser::setup_passthrough()). POSIX only.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PASSTHROUGH_SPAWN_H_
+#define PASSTHROUGH_SPAWN_H_
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <errno.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <vector>
+#include "cmd_line_options.h"
+
+extern char** environ;
+
+/**
+ * @brief Spawns a child process using arguments that followed "--" in the last command line
+ *        parsed by the parser: the first of them is the program (looked-up in PATH), the child
+ *        inherits the environment and stdio. Only the array of pointers is copied (argv passed
+ *        to run() doesn't have to be terminated with NULL), arguments themselves are passed
+ *        as they were.
+ * @return pid of the child, or -1 if it couldn't be spawned (errno is set).
+ */
+inline pid_t spawn_passthrough(const cmd_line_parser& parser)
+{
+    int argc = parser.passthrough_argc();
+    char* const* argv = parser.passthrough_argv();
+    if (argc == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    std::vector<char*> spawn_argv(argv, argv + argc);
+    spawn_argv.push_back(NULL);
+
+    pid_t pid = -1;
+    int err = posix_spawnp(&pid, spawn_argv[0], NULL, NULL, &spawn_argv[0], environ);
+    if (err != 0)
+    {
+        errno = err;
+        return -1;
+    }
+    return pid;
+}
+
+/**
+ * @brief Spawns a child process (see spawn_passthrough()) and waits for it to finish.
+ * @return exit status of the child (128 + signal number if it was killed), or -1 if it
+ *         couldn't be spawned.
+ */
+inline int run_passthrough(const cmd_line_parser& parser)
+{
+    pid_t pid = spawn_passthrough(parser);
+    if (pid < 0)
+    {
+        return -1;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+#endif /* __unix__ || __APPLE__ */
+
+#endif /* PASSTHROUGH_SPAWN_H_ */
@@ -0,0 +1,622 @@
+/**
+ * @file   path_glob.h
+ * @date   17 Oct 2026
+ * @brief  Parameter type taking a glob pattern (e.g. "logs/????-*.txt"), that is expanded by the
+ *         program itself (when needed), so that it works the same regardless of the shell.
+ *         Directories are read by multiple threads. POSIX only.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PATH_GLOB_H_
+#define PATH_GLOB_H_
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <set>
+#include <deque>
+#include <new>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cmd_line_options.h"
+
+#if defined(__linux__)
+#define PATH_GLOB_USE_GETDENTS64
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @brief Glob pattern, e.g. "*.cpp" or "data/????/[a-c]*". A component "**" matches any
+ *        number of directories (including none), e.g. "src/" followed by "**" matches all
+ *        files and directories in src and its sub-directories. Patterns are matched as in the shell,
+ *        except that names starting with '.' are only matched explicitly and "**" doesn't
+ *        follow symbolic links. Pattern is only expanded when expand() (or for_each()) is called.
+ *
+ * @code
+ * void add_sources(path_glob sources)
+ * {
+ *     std::vector<std::string> paths;
+ *     sources.expand(paths);
+ *     ...
+ * }
+ * @endcode
+ */
+class path_glob
+{
+public:
+    path_glob() :
+                    globstars(0)
+    {
+    }
+
+    explicit path_glob(const std::string& glob_pattern) :
+                    pattern_str(glob_pattern),
+                    globstars(0)
+    {
+        size_t start = 0;
+        if (pattern_str.size() && pattern_str[0] == '/')
+        {
+            root = "/";
+            start = 1;
+        }
+        while (start <= pattern_str.size())
+        {
+            size_t end = pattern_str.find('/', start);
+            if (end == std::string::npos)
+            {
+                end = pattern_str.size();
+            }
+            std::string component = pattern_str.substr(start, end - start);
+            if (component.size() && !(component == "**" && is_globstar(components.size() - 1)))
+            {
+                components.push_back(component);
+                globstars += (component == "**") ? 1 : 0;
+            }
+            start = end + 1;
+        }
+    }
+
+    const std::string& pattern() const
+    {
+        return pattern_str;
+    }
+
+    /**
+     * @brief Expands the pattern.
+     * @param paths - matching paths (sorted) will be added here.
+     * @param num_threads - number of threads to read directories with (0: one per CPU).
+     * @return number of paths found.
+     */
+    size_t expand(std::vector<std::string>& paths, size_t num_threads = 0) const
+    {
+        size_t before = paths.size();
+        collector c(paths);
+        walk(c, num_threads);
+        std::sort(paths.begin() + before, paths.end());
+        return paths.size() - before;
+    }
+
+    /**
+     * @brief Expands the pattern, passing each of matching paths to the handler as soon as
+     *        it's found, e.g. to start processing it before all directories are read.
+     *        Paths are found in no particular order, but each of them is passed only once.
+     *        The handler is only called by the calling thread (while other threads keep
+     *        reading directories). If it throws, the walk is stopped and the exception is
+     *        re-thrown (once other threads have finished).
+     * @param handler - function (or function object) taking const std::string&.
+     * @param num_threads - number of threads to read directories with (0: one per CPU).
+     * @return number of paths found.
+     * @throws std::bad_alloc if directories couldn't be read, or whatever the handler throws.
+     */
+    template<typename Handler>
+    size_t for_each(Handler handler, size_t num_threads = 0) const
+    {
+        streamer<Handler> s(handler);
+        walk(s, num_threads);
+        return s.count;
+    }
+
+private:
+    /**
+     * @brief Receives matching paths (on the calling thread).
+     */
+    class sink
+    {
+    public:
+        virtual ~sink()
+        {
+        }
+
+        virtual void add(const std::string& path) = 0;
+    };
+
+    class collector: public sink
+    {
+    public:
+        collector(std::vector<std::string>& found_paths) :
+                        found(found_paths)
+        {
+        }
+
+        virtual void add(const std::string& path)
+        {
+            found.push_back(path);
+        }
+
+    private:
+        std::vector<std::string>& found;
+    };
+
+    template<typename Handler>
+    class streamer: public sink
+    {
+    public:
+        streamer(Handler& h) :
+                        count(0),
+                        handler(h)
+        {
+        }
+
+        virtual void add(const std::string& path)
+        {
+            count++;
+            handler(path);
+        }
+
+        size_t count;
+
+    private:
+        Handler& handler;
+    };
+
+    /**
+     * @brief Directory to read, and index of the component of the pattern to match in it.
+     */
+    struct work_item
+    {
+        std::string dir;
+        size_t component;
+    };
+
+    /**
+     * @brief State shared by threads walking directories.
+     */
+    struct walk_state
+    {
+        const path_glob* glob;
+        std::deque<work_item> queue;
+        std::vector<std::string> found; // (not yet passed to the sink)
+        size_t busy; // (number of threads processing an item)
+        bool stop;   // (e.g. if the sink has thrown)
+        bool failed; // (if any of threads couldn't allocate memory)
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+    };
+
+    /**
+     * @brief Walks directories using num_threads threads (the calling one included). Matching
+     *        paths are passed to the output by the calling thread only, without the lock held.
+     */
+    void walk(sink& output, size_t num_threads) const
+    {
+        if (components.empty())
+        {
+            if (root.size())
+            {
+                output.add(root);
+            }
+            return;
+        }
+        if (num_threads == 0)
+        {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            num_threads = cpus > 0 ? static_cast<size_t>(cpus) : 1;
+        }
+
+        walk_state state;
+        state.glob = this;
+        state.busy = 0;
+        state.stop = false;
+        state.failed = false;
+        work_item first;
+        first.dir = root;
+        first.component = 0;
+        state.queue.push_back(first);
+        pthread_mutex_init(&state.lock, NULL);
+        pthread_cond_init(&state.changed, NULL);
+
+        std::vector<pthread_t> threads;
+        for (size_t i = 1; i < num_threads; i++)
+        {
+            pthread_t t;
+            if (pthread_create(&t, NULL, worker, &state) != 0)
+            {
+                break;
+            }
+            threads.push_back(t);
+        }
+
+        // (only patterns with more than one "**" can match the same path more than once)
+        std::set<std::string> seen;
+        std::vector<std::string> found;
+        try
+        {
+            pthread_mutex_lock(&state.lock);
+            for (;;)
+            {
+                while (state.found.empty() && (state.queue.empty() || state.stop) && state.busy > 0)
+                {
+                    pthread_cond_wait(&state.changed, &state.lock);
+                }
+                if (state.found.size())
+                {
+                    found.swap(state.found);
+                    pthread_mutex_unlock(&state.lock);
+                    for (size_t i = 0; i < found.size(); i++)
+                    {
+                        if (globstars < 2 || seen.insert(found[i]).second)
+                        {
+                            output.add(found[i]);
+                        }
+                    }
+                    found.clear();
+                    pthread_mutex_lock(&state.lock);
+                }
+                else if (state.queue.size() && !state.stop)
+                {
+                    process_next(state);
+                }
+                else
+                {
+                    break; // nothing to do, and nobody will add anything
+                }
+            }
+            pthread_mutex_unlock(&state.lock);
+        }
+        catch (...)
+        {
+            // (output has thrown: the lock is not held)
+            pthread_mutex_lock(&state.lock);
+            state.stop = true;
+            pthread_cond_broadcast(&state.changed);
+            pthread_mutex_unlock(&state.lock);
+            finish_walk(state, threads);
+            throw;
+        }
+        finish_walk(state, threads);
+        if (state.failed)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    static void finish_walk(walk_state& state, std::vector<pthread_t>& threads)
+    {
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        pthread_cond_destroy(&state.changed);
+        pthread_mutex_destroy(&state.lock);
+    }
+
+    static void* worker(void* arg)
+    {
+        walk_state& state = *static_cast<walk_state*>(arg);
+        pthread_mutex_lock(&state.lock);
+        for (;;)
+        {
+            while (state.queue.empty() && state.busy > 0 && !state.stop)
+            {
+                pthread_cond_wait(&state.changed, &state.lock);
+            }
+            if (state.queue.empty() || state.stop)
+            {
+                break; // nothing to do, and nobody will add anything
+            }
+            process_next(state);
+        }
+        pthread_mutex_unlock(&state.lock);
+        return NULL;
+    }
+
+    /**
+     * @brief Processes the next item from the queue. It's called with the lock held, which
+     *        is released while the directory is read. Nothing is thrown from here: if memory
+     *        couldn't be allocated, the walk is stopped (and failed is set).
+     */
+    static void process_next(walk_state& state)
+    {
+        work_item item;
+        item.dir.swap(state.queue.front().dir);
+        item.component = state.queue.front().component;
+        state.queue.pop_front();
+        state.busy++;
+        pthread_mutex_unlock(&state.lock);
+
+        std::vector<work_item> next;
+        std::vector<std::string> found;
+        bool ok = true;
+        try
+        {
+            state.glob->process(item, next, found);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ok = false;
+        }
+
+        pthread_mutex_lock(&state.lock);
+        try
+        {
+            if (ok)
+            {
+                state.queue.insert(state.queue.end(), next.begin(), next.end());
+                state.found.insert(state.found.end(), found.begin(), found.end());
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            state.failed = true;
+            state.stop = true;
+        }
+        state.busy--;
+        pthread_cond_broadcast(&state.changed);
+    }
+
+    static std::string join(const std::string& dir, const char* name)
+    {
+        if (dir.empty())
+        {
+            return name;
+        }
+        if (dir[dir.size() - 1] == '/')
+        {
+            return dir + name;
+        }
+        return dir + "/" + name;
+    }
+
+    /**
+     * @brief Returns true if the component of the specified index is "**" (consecutive ones
+     *        are merged into one: they match the same paths).
+     */
+    bool is_globstar(size_t index) const
+    {
+        return index < components.size() && components[index] == "**";
+    }
+
+    static bool has_wildcards(const std::string& component)
+    {
+        return component.find_first_of("*?[\\") != std::string::npos;
+    }
+
+    /**
+     * @brief Matches the component of the pattern in the directory: adds matching paths
+     *        to found, and directories to continue with to next.
+     */
+    void process(const work_item& item, std::vector<work_item>& next,
+                 std::vector<std::string>& found) const
+    {
+        const std::string& component = components[item.component];
+        bool last = (item.component + 1 == components.size());
+        const char* dir = item.dir.empty() ? "." : item.dir.c_str();
+
+        if (component == "**")
+        {
+            // matches no directories..
+            if (last)
+            {
+                if (item.dir.size())
+                {
+                    found.push_back(item.dir);
+                }
+            }
+            else
+            {
+                work_item w = {item.dir, item.component + 1};
+                next.push_back(w);
+            }
+        }
+        else if (!has_wildcards(component))
+        {
+            // no need to read the directory
+            struct stat st;
+            std::string path = join(item.dir, component.c_str());
+            if (fstatat(AT_FDCWD, path.c_str(), &st, 0) == 0)
+            {
+                if (last)
+                {
+                    found.push_back(path);
+                }
+                else if (S_ISDIR(st.st_mode))
+                {
+                    work_item w = {path, item.component + 1};
+                    next.push_back(w);
+                }
+            }
+            return;
+        }
+
+        int fd = openat(AT_FDCWD, dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+        std::vector<std::pair<std::string, unsigned char> > entries;
+        read_entries(fd, entries);
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const std::string& name = entries[i].first;
+            unsigned char type = entries[i].second;
+            if (name == "." || name == "..")
+            {
+                continue;
+            }
+            if (type == DT_UNKNOWN)
+            {
+                struct stat st;
+                if (fstatat(fd, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0)
+                {
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISLNK(st.st_mode) ? DT_LNK : DT_REG);
+                }
+            }
+
+            if (component == "**")
+            {
+                // .. or any number of them (not following links, to avoid cycles)
+                if (name[0] != '.')
+                {
+                    std::string path = join(item.dir, name.c_str());
+                    if (last && type != DT_DIR)
+                    {
+                        found.push_back(path); // (directories are added once they are read)
+                    }
+                    if (type == DT_DIR)
+                    {
+                        work_item w = {path, item.component};
+                        next.push_back(w);
+                    }
+                }
+            }
+            else if (fnmatch(component.c_str(), name.c_str(), FNM_PERIOD) == 0)
+            {
+                std::string path = join(item.dir, name.c_str());
+                if (last)
+                {
+                    found.push_back(path);
+                }
+                else if (type == DT_DIR || (type == DT_LNK && is_directory(fd, name)))
+                {
+                    work_item w = {path, item.component + 1};
+                    next.push_back(w);
+                }
+            }
+        }
+        close(fd);
+    }
+
+    static bool is_directory(int dir_fd, const std::string& name)
+    {
+        struct stat st;
+        return fstatat(dir_fd, name.c_str(), &st, 0) == 0 && S_ISDIR(st.st_mode);
+    }
+
+    /**
+     * @brief Reads names (and types, if known) of all entries of the directory.
+     */
+    static void read_entries(int fd, std::vector<std::pair<std::string, unsigned char> >& entries)
+    {
+#ifdef PATH_GLOB_USE_GETDENTS64
+        // (read in big chunks, without the per-entry overhead of readdir())
+        struct linux_dirent64
+        {
+            uint64_t d_ino;
+            int64_t d_off;
+            unsigned short d_reclen;
+            unsigned char d_type;
+            char d_name[1];
+        };
+        std::vector<char> buffer(64 * 1024);
+        long n;
+        while ((n = syscall(SYS_getdents64, fd, &buffer[0], buffer.size())) > 0)
+        {
+            for (long at = 0; at < n;)
+            {
+                const linux_dirent64* d = reinterpret_cast<const linux_dirent64*>(&buffer[at]);
+                entries.push_back(std::make_pair(std::string(d->d_name), d->d_type));
+                at += d->d_reclen;
+            }
+        }
+#else
+        int dup_fd = dup(fd);
+        DIR* d = dup_fd >= 0 ? fdopendir(dup_fd) : NULL;
+        if (d != NULL)
+        {
+            dirent* e;
+            while ((e = readdir(d)) != NULL)
+            {
+#ifdef _DIRENT_HAVE_D_TYPE
+                entries.push_back(std::make_pair(std::string(e->d_name), e->d_type));
+#else
+                entries.push_back(std::make_pair(std::string(e->d_name), DT_UNKNOWN));
+#endif
+            }
+            closedir(d);
+        }
+#endif
+    }
+
+    std::string pattern_str;
+    std::string root;
+    std::vector<std::string> components;
+    size_t globstars; // (number of "**" components)
+};
+
+/**
+ * @brief Specialisation of param_extractor for "path_glob" type.
+ */
+template<>
+class param_extractor<path_glob>
+{
+public:
+    /**
+     * @brief See generic template for description
+     */
+    static path_glob extract(std::stringstream& from)
+    {
+        std::string s = get_next_token(from);
+        if (s.size() == 0)
+        {
+            std::stringstream err;
+            err << usage() << ", got \"\"";
+            throw option_error(err.str());
+        }
+        return path_glob(s);
+    }
+
+    /**
+     * @brief see generic template for description
+     */
+    static std::string usage()
+    {
+        return std::string("<path pattern>");
+    }
+};
+
+#endif /* __unix__ || __APPLE__ */
+
+#endif /* PATH_GLOB_H_ */
@@ -0,0 +1,782 @@
+/**
+ * @file   schema_image.h
+ * @date   17 Oct 2026
+ * @brief  Flat name index and a relocatable (offset-based) image of the option schema,
+ *         that can be stored in a file and mapped back on following starts.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCHEMA_IMAGE_H_
+#define SCHEMA_IMAGE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SCHEMA_IMAGE_USE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__)
+#include <link.h>
+#endif
+
+/**
+ * @brief FNV-1a hash used for option names (both: in memory and in the stored image).
+ */
+inline uint32_t name_hash(const char* name, size_t size)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+    {
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Slot of the name_index. Name is kept as an offset into the string pool,
+ *        so that the whole table can be stored / mapped without any fix-ups.
+ *        Empty slots have name_size == 0.
+ */
+struct name_index_slot
+{
+    uint32_t hash;
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t id;
+};
+
+/**
+ * @brief Open-addressing hash table, mapping names (and aliases) to ids.
+ *        All names are interned into one string pool. The table either owns
+ *        its storage, or is attached to an external (e.g. mapped) one.
+ */
+class name_index
+{
+public:
+    name_index() :
+        slots(NULL), slot_count(0), pool(NULL), pool_size(0), used(0)
+    {
+    }
+
+    /**
+     * @brief Reserves space for a given number of names and total bytes of these names.
+     */
+    void reserve(size_t number_of_names, size_t pool_bytes)
+    {
+        make_owned();
+        owned_pool.reserve(pool_bytes);
+        size_t required = 16;
+        while (required < number_of_names * 2)
+        {
+            required *= 2;
+        }
+        if (required > slot_count)
+        {
+            rehash(required);
+        }
+        refresh();
+    }
+
+    /**
+     * @brief Adds a new name.
+     * @return false if this name exists already (index is not modified in such case).
+     */
+    bool insert(const char* name, size_t size, uint32_t id)
+    {
+        if (size == 0 || find(name, size) != NULL)
+        {
+            return false;
+        }
+
+        make_owned();
+        if ((used + 1) * 2 > slot_count)
+        {
+            rehash(slot_count ? slot_count * 2 : 16);
+        }
+
+        name_index_slot s;
+        s.hash = name_hash(name, size);
+        s.name_offset = static_cast<uint32_t>(owned_pool.size());
+        s.name_size = static_cast<uint32_t>(size);
+        s.id = id;
+        owned_pool.insert(owned_pool.end(), name, name + size);
+        place(s);
+        used++;
+        refresh();
+        return true;
+    }
+
+    /**
+     * @brief Finds a name.
+     * @return pointer to the slot holding this name or NULL if not found.
+     */
+    const name_index_slot* find(const char* name, size_t size) const
+    {
+        if (slot_count == 0 || size == 0)
+        {
+            return NULL;
+        }
+        uint32_t h = name_hash(name, size);
+        uint32_t mask = slot_count - 1;
+        for (uint32_t i = h & mask; ; i = (i + 1) & mask)
+        {
+            const name_index_slot& s = slots[i];
+            if (s.name_size == 0)
+            {
+                return NULL;
+            }
+            if (s.hash == h && s.name_size == size &&
+                memcmp(pool + s.name_offset, name, size) == 0)
+            {
+                return &s;
+            }
+        }
+    }
+
+    const name_index_slot* find(const std::string& name) const
+    {
+        return find(name.data(), name.size());
+    }
+
+    /**
+     * @brief Uses external storage (e.g. mapped image). The storage must outlive this index
+     *        (or until it is detached, cleared or modified).
+     */
+    void attach(const name_index_slot* external_slots, uint32_t number_of_slots,
+                const char* external_pool, uint32_t external_pool_size)
+    {
+        owned_slots.clear();
+        owned_pool.clear();
+        slots = external_slots;
+        slot_count = number_of_slots;
+        pool = external_pool;
+        pool_size = external_pool_size;
+        used = 0;
+        for (uint32_t i = 0; i < slot_count; i++)
+        {
+            if (slots[i].name_size)
+            {
+                used++;
+            }
+        }
+    }
+
+    bool attached() const
+    {
+        return slots != NULL && (owned_slots.empty() || slots != &owned_slots[0]);
+    }
+
+    /**
+     * @brief Removes all names.
+     */
+    void clear()
+    {
+        std::vector<name_index_slot>().swap(owned_slots);
+        std::vector<char>().swap(owned_pool);
+        used = 0;
+        refresh();
+    }
+
+    size_t size() const
+    {
+        return used;
+    }
+
+    const name_index_slot* slot_data() const
+    {
+        return slots;
+    }
+
+    uint32_t number_of_slots() const
+    {
+        return slot_count;
+    }
+
+    const char* pool_data() const
+    {
+        return pool;
+    }
+
+    uint32_t pool_bytes() const
+    {
+        return pool_size;
+    }
+
+private:
+    name_index(const name_index&);
+    name_index& operator=(const name_index&);
+
+    void make_owned()
+    {
+        if (attached())
+        {
+            std::vector<name_index_slot> s(slots, slots + slot_count);
+            std::vector<char> p(pool, pool + pool_size);
+            owned_slots.swap(s);
+            owned_pool.swap(p);
+            refresh();
+        }
+    }
+
+    void rehash(size_t new_count)
+    {
+        std::vector<name_index_slot> old;
+        old.swap(owned_slots);
+        owned_slots.assign(new_count, name_index_slot());
+        slot_count = static_cast<uint32_t>(new_count);
+        for (size_t i = 0; i < old.size(); i++)
+        {
+            if (old[i].name_size)
+            {
+                place(old[i]);
+            }
+        }
+    }
+
+    void place(const name_index_slot& s)
+    {
+        uint32_t mask = static_cast<uint32_t>(owned_slots.size()) - 1;
+        uint32_t i = s.hash & mask;
+        while (owned_slots[i].name_size)
+        {
+            i = (i + 1) & mask;
+        }
+        owned_slots[i] = s;
+    }
+
+    void refresh()
+    {
+        slot_count = static_cast<uint32_t>(owned_slots.size());
+        slots = slot_count ? &owned_slots[0] : NULL;
+        pool_size = static_cast<uint32_t>(owned_pool.size());
+        pool = pool_size ? &owned_pool[0] : NULL;
+    }
+
+    std::vector<name_index_slot> owned_slots;
+    std::vector<char> owned_pool;
+    const name_index_slot* slots;
+    uint32_t slot_count;
+    const char* pool;
+    uint32_t pool_size;
+    size_t used;
+};
+
+/**
+ * @brief Reference to a string stored in the image (offset into the pool).
+ */
+struct schema_image_string
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+/**
+ * @brief Option, as stored in the image. Ids refer to the order of registration.
+ */
+struct schema_image_option
+{
+    enum flags
+    {
+        f_standalone = 1
+    };
+
+    schema_image_string name;  // as registered, i.e. with all aliases
+    schema_image_string usage; // type signature
+    uint32_t num_params;
+    uint32_t flags;
+    uint32_t required_first;
+    uint32_t required_count;
+    uint32_t not_wanted_first;
+    uint32_t not_wanted_count;
+};
+
+/**
+ * @brief Header of the image. All offsets are relative to the beginning of the image.
+ */
+struct schema_image_header
+{
+    enum constants
+    {
+        current_version = 2,
+        max_key_size = 64
+    };
+
+    char magic[8];
+    uint32_t version;
+    uint32_t image_size;
+    uint32_t key_size;
+    unsigned char key[max_key_size];
+    uint32_t option_count;
+    uint32_t options_offset;
+    uint32_t ids_offset;
+    uint32_t ids_count;
+    uint32_t required_all_first;
+    uint32_t required_all_count;
+    uint32_t any_of_first;
+    uint32_t any_of_count;
+    uint32_t setup_hash; // (of setup calls that were made when the image was created)
+    uint32_t slots_offset;
+    uint32_t slot_count;
+    uint32_t pool_offset;
+    uint32_t pool_size;
+    schema_image_string help;
+};
+
+static const char schema_image_magic[8] = { 'c', 'l', 'o', 's', 'c', 'h', 'm', 'a' };
+
+/**
+ * @brief Returns the build-id of the running executable (or empty string if it
+ *        can not be determined). It is used as a key for stored images, so that
+ *        an image is only ever used by the binary that created it.
+ */
+#if defined(__linux__)
+inline int schema_image_build_id_callback(struct dl_phdr_info* info, size_t, void* data)
+{
+    std::string& id = *static_cast<std::string*>(data);
+    for (int i = 0; i < info->dlpi_phnum && id.empty(); i++)
+    {
+        const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+        if (ph.p_type != PT_NOTE)
+        {
+            continue;
+        }
+
+        const char* note = reinterpret_cast<const char*>(info->dlpi_addr + ph.p_vaddr);
+        const char* end = note + ph.p_memsz;
+        while (note + sizeof(ElfW(Nhdr)) <= end)
+        {
+            const ElfW(Nhdr)* n = reinterpret_cast<const ElfW(Nhdr)*>(note);
+            const char* name = note + sizeof(ElfW(Nhdr));
+            const char* desc = name + ((n->n_namesz + 3) & ~3u);
+            if (n->n_type == NT_GNU_BUILD_ID && n->n_namesz == 4 && memcmp(name, "GNU", 4) == 0)
+            {
+                id.assign(desc, n->n_descsz);
+                break;
+            }
+            note = desc + ((n->n_descsz + 3) & ~3u);
+        }
+    }
+    return 1; // the first object is the executable itself, no need to look further.
+}
+#endif
+
+inline std::string schema_image_build_id()
+{
+    std::string id;
+#if defined(__linux__)
+    dl_iterate_phdr(schema_image_build_id_callback, &id);
+#endif
+    if (id.size() > schema_image_header::max_key_size)
+    {
+        id.resize(schema_image_header::max_key_size);
+    }
+    return id;
+}
+
+/**
+ * @brief Read-only view of a stored image. If possible, the file is mapped (mmap),
+ *        otherwise it is read into memory. Everything is validated when it is loaded,
+ *        so that accessing it later does not require any checks.
+ */
+class schema_image
+{
+public:
+    schema_image() :
+        data(NULL), size(0), mapped(false)
+    {
+    }
+
+    ~schema_image()
+    {
+        release();
+    }
+
+    /**
+     * @brief Loads the image.
+     * @param path - location of the image.
+     * @param key - expected key (build-id). Image stored with a different key is stale.
+     * @return true if the image was loaded and it is valid, false otherwise.
+     */
+    bool load(const std::string& path, const std::string& key)
+    {
+        release();
+        if (key.empty() || !read_file(path))
+        {
+            return false;
+        }
+        if (!validate(key))
+        {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    void release()
+    {
+#ifdef SCHEMA_IMAGE_USE_MMAP
+        if (mapped)
+        {
+            munmap(const_cast<char*>(data), size);
+        }
+#endif
+        std::vector<char>().swap(buffer);
+        data = NULL;
+        size = 0;
+        mapped = false;
+    }
+
+    bool loaded() const
+    {
+        return data != NULL;
+    }
+
+    const schema_image_header& header() const
+    {
+        return *reinterpret_cast<const schema_image_header*>(data);
+    }
+
+    const schema_image_option& option_at(uint32_t id) const
+    {
+        return at<schema_image_option>(header().options_offset)[id];
+    }
+
+    const uint32_t* ids(uint32_t first) const
+    {
+        return at<uint32_t>(header().ids_offset) + first;
+    }
+
+    const name_index_slot* slots() const
+    {
+        return at<name_index_slot>(header().slots_offset);
+    }
+
+    const char* pool() const
+    {
+        return data + header().pool_offset;
+    }
+
+    bool equals(const schema_image_string& s, const std::string& str) const
+    {
+        return s.size == str.size() && memcmp(pool() + s.offset, str.data(), s.size) == 0;
+    }
+
+    std::string text(const schema_image_string& s) const
+    {
+        return std::string(pool() + s.offset, s.size);
+    }
+
+private:
+    schema_image(const schema_image&);
+    schema_image& operator=(const schema_image&);
+
+    template<typename T>
+    const T* at(uint32_t offset) const
+    {
+        return reinterpret_cast<const T*>(data + offset);
+    }
+
+    bool read_file(const std::string& path)
+    {
+#ifdef SCHEMA_IMAGE_USE_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(schema_image_header)))
+        {
+            void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED)
+            {
+                data = static_cast<const char*>(m);
+                size = st.st_size;
+                mapped = true;
+            }
+        }
+        close(fd);
+        return mapped;
+#else
+        FILE* f = fopen(path.c_str(), "rb");
+        if (f == NULL)
+        {
+            return false;
+        }
+        char chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        {
+            buffer.insert(buffer.end(), chunk, chunk + n);
+        }
+        fclose(f);
+        if (buffer.size() >= sizeof(schema_image_header))
+        {
+            data = &buffer[0];
+            size = buffer.size();
+        }
+        return data != NULL;
+#endif
+    }
+
+    bool in_range(uint32_t offset, uint32_t count, size_t item_size) const
+    {
+        return offset <= size && count <= (size - offset) / item_size && offset % 4 == 0;
+    }
+
+    bool in_pool(const schema_image_string& s) const
+    {
+        return s.offset <= header().pool_size && s.size <= header().pool_size - s.offset;
+    }
+
+    bool ids_valid(uint32_t first, uint32_t count) const
+    {
+        const schema_image_header& h = header();
+        if (first > h.ids_count || count > h.ids_count - first)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (ids(first)[i] >= h.option_count)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool validate(const std::string& key) const
+    {
+        const schema_image_header& h = header();
+        if (memcmp(h.magic, schema_image_magic, sizeof(h.magic)) != 0 ||
+            h.version != schema_image_header::current_version ||
+            h.image_size != size ||
+            h.key_size != key.size() ||
+            memcmp(h.key, key.data(), key.size()) != 0)
+        {
+            return false;
+        }
+
+        if (!in_range(h.options_offset, h.option_count, sizeof(schema_image_option)) ||
+            !in_range(h.ids_offset, h.ids_count, sizeof(uint32_t)) ||
+            !in_range(h.slots_offset, h.slot_count, sizeof(name_index_slot)) ||
+            h.pool_offset > size || h.pool_size > size - h.pool_offset ||
+            (h.slot_count & (h.slot_count - 1)) != 0 ||
+            !in_pool(h.help) ||
+            !ids_valid(h.required_all_first, h.required_all_count) ||
+            !ids_valid(h.any_of_first, h.any_of_count))
+        {
+            return false;
+        }
+
+        uint32_t empty_slots = 0;
+        for (uint32_t i = 0; i < h.slot_count; i++)
+        {
+            const name_index_slot& s = slots()[i];
+            schema_image_string name = { s.name_offset, s.name_size };
+            if (s.name_size == 0)
+            {
+                empty_slots++;
+            }
+            else if (!in_pool(name) || s.id >= h.option_count ||
+                     s.hash != name_hash(pool() + s.name_offset, s.name_size))
+            {
+                return false;
+            }
+        }
+        if (h.slot_count && empty_slots == 0)
+        {
+            return false; // lookups of unknown names would never terminate
+        }
+
+        for (uint32_t i = 0; i < h.option_count; i++)
+        {
+            const schema_image_option& o = option_at(i);
+            if (!in_pool(o.name) || !in_pool(o.usage) ||
+                !ids_valid(o.required_first, o.required_count) ||
+                !ids_valid(o.not_wanted_first, o.not_wanted_count))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char* data;
+    size_t size;
+    bool mapped;
+    std::vector<char> buffer;
+};
+
+/**
+ * @brief Helper to build and store the image. The string pool of the name_index
+ *        becomes the beginning of the image pool, so the index is stored as it is.
+ */
+class schema_image_writer
+{
+public:
+    explicit schema_image_writer(const name_index& index) :
+        index_slots(index.slot_data(), index.slot_data() + index.number_of_slots()),
+        pool(index.pool_data(), index.pool_data() + index.pool_bytes())
+    {
+        memset(&header, 0, sizeof(header));
+    }
+
+    schema_image_string add_string(const std::string& s)
+    {
+        schema_image_string result;
+        result.offset = static_cast<uint32_t>(pool.size());
+        result.size = static_cast<uint32_t>(s.size());
+        pool.insert(pool.end(), s.begin(), s.end());
+        return result;
+    }
+
+    /**
+     * @brief Stores a list of ids.
+     * @return position of the first id (to be used as xxx_first in records).
+     */
+    uint32_t add_ids(const std::vector<uint32_t>& list)
+    {
+        uint32_t first = static_cast<uint32_t>(ids.size());
+        ids.insert(ids.end(), list.begin(), list.end());
+        return first;
+    }
+
+    void add_option(const schema_image_option& o)
+    {
+        options.push_back(o);
+    }
+
+    void set_required_all(const std::vector<uint32_t>& list)
+    {
+        header.required_all_count = static_cast<uint32_t>(list.size());
+        header.required_all_first = add_ids(list);
+    }
+
+    void set_any_of(const std::vector<uint32_t>& list)
+    {
+        header.any_of_count = static_cast<uint32_t>(list.size());
+        header.any_of_first = add_ids(list);
+    }
+
+    void set_help(const std::string& help)
+    {
+        header.help = add_string(help);
+    }
+
+    void set_setup_hash(uint32_t hash)
+    {
+        header.setup_hash = hash;
+    }
+
+    /**
+     * @brief Writes the image. It is written to a temporary file first and renamed,
+     *        so that other processes never see a partially written image.
+     * @return true on success.
+     */
+    bool write(const std::string& path, const std::string& key)
+    {
+        if (key.size() > schema_image_header::max_key_size)
+        {
+            return false;
+        }
+
+        memcpy(header.magic, schema_image_magic, sizeof(header.magic));
+        header.version = schema_image_header::current_version;
+        header.key_size = static_cast<uint32_t>(key.size());
+        memcpy(header.key, key.data(), key.size());
+
+        uint32_t offset = sizeof(schema_image_header);
+        header.option_count = static_cast<uint32_t>(options.size());
+        header.options_offset = offset;
+        offset += header.option_count * sizeof(schema_image_option);
+        header.ids_count = static_cast<uint32_t>(ids.size());
+        header.ids_offset = offset;
+        offset += header.ids_count * sizeof(uint32_t);
+        header.slot_count = static_cast<uint32_t>(index_slots.size());
+        header.slots_offset = offset;
+        offset += header.slot_count * sizeof(name_index_slot);
+        header.pool_size = static_cast<uint32_t>(pool.size());
+        header.pool_offset = offset;
+        header.image_size = offset + header.pool_size;
+
+        std::stringstream tmp_name;
+        tmp_name << path << ".tmp";
+#ifdef SCHEMA_IMAGE_USE_MMAP
+        tmp_name << "." << getpid();
+#endif
+        FILE* f = fopen(tmp_name.str().c_str(), "wb");
+        if (f == NULL)
+        {
+            return false;
+        }
+        bool ok = put(f, &header, sizeof(header)) &&
+                  put(f, vector_data(options), options.size() * sizeof(schema_image_option)) &&
+                  put(f, vector_data(ids), ids.size() * sizeof(uint32_t)) &&
+                  put(f, vector_data(index_slots), index_slots.size() * sizeof(name_index_slot)) &&
+                  put(f, vector_data(pool), pool.size());
+        ok = (fclose(f) == 0) && ok;
+        if (ok)
+        {
+            ok = (rename(tmp_name.str().c_str(), path.c_str()) == 0);
+        }
+        if (!ok)
+        {
+            remove(tmp_name.str().c_str());
+        }
+        return ok;
+    }
+
+private:
+    template<typename T>
+    static const T* vector_data(const std::vector<T>& v)
+    {
+        return v.empty() ? NULL : &v[0];
+    }
+
+    static bool put(FILE* f, const void* what, size_t bytes)
+    {
+        return bytes == 0 || fwrite(what, 1, bytes, f) == bytes;
+    }
+
+    schema_image_header header;
+    std::vector<schema_image_option> options;
+    std::vector<uint32_t> ids;
+    std::vector<name_index_slot> index_slots;
+    std::vector<char> pool;
+};
+
+#endif /* SCHEMA_IMAGE_H_ */
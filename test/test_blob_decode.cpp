@@ -0,0 +1,189 @@
+/*
+ * test_blob_decode.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdlib.h>
+#include <cmd_line_options.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+
+static std::string to_hex(const std::vector<uint8_t>& data, bool upper_case)
+{
+    const char* digits = upper_case ? "0123456789ABCDEF" : "0123456789abcdef";
+    std::string res;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        res += digits[data[i] >> 4];
+        res += digits[data[i] & 0xf];
+    }
+    return res;
+}
+
+static std::string to_base64(const std::vector<uint8_t>& data, bool padding)
+{
+    const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string res;
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3)
+    {
+        uint32_t bits = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        for (int shift = 18; shift >= 0; shift -= 6)
+        {
+            res += chars[(bits >> shift) & 0x3f];
+        }
+    }
+    if (i < data.size())
+    {
+        uint32_t bits = data[i] << 16;
+        if (i + 1 < data.size())
+        {
+            bits |= data[i + 1] << 8;
+        }
+        size_t chars_left = data.size() - i + 1;
+        for (size_t c = 0; c < chars_left; c++)
+        {
+            res += chars[(bits >> (18 - 6 * c)) & 0x3f];
+        }
+        if (padding)
+        {
+            res.append(4 - chars_left, '=');
+        }
+    }
+    return res;
+}
+
+template<typename Encoding>
+static size_t decode(const std::string& text, std::vector<uint8_t>& out)
+{
+    out.resize(Encoding::max_decoded_size(text.size()) + 1);
+    size_t decoded = 0;
+    size_t res = Encoding::decode(text.data(), text.size(), &out[0], decoded);
+    out.resize(decoded);
+    return res;
+}
+
+TEST_CASE("hex and base64 decoding", "should decode what was encoded and find invalid characters")
+{
+    srand(1234);
+    std::vector<uint8_t> decoded;
+    for (size_t size = 0; size < 100; size++)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = static_cast<uint8_t>(rand());
+        }
+
+        for (int upper_case = 0; upper_case < 2; upper_case++)
+        {
+            std::string text = to_hex(data, upper_case != 0);
+            REQUIRE(decode<hex_encoding>(text, decoded) == blob_decode_ok);
+            REQUIRE(decoded == data);
+
+            for (size_t at = 0; at < text.size(); at += 7)
+            {
+                std::string invalid = text;
+                invalid[at] = (at % 2) ? 'g' : '\xe0';
+                REQUIRE(decode<hex_encoding>(invalid, decoded) == at);
+            }
+            if (size)
+            {
+                REQUIRE(decode<hex_encoding>(text.substr(1), decoded) == text.size() - 1); // truncated
+            }
+        }
+
+        for (int padding = 0; padding < 2; padding++)
+        {
+            std::string text = to_base64(data, padding != 0);
+            REQUIRE(decode<base64_encoding>(text, decoded) == blob_decode_ok);
+            REQUIRE(decoded == data);
+
+            for (size_t at = 0; at < text.size() && text[at] != '='; at += 5)
+            {
+                std::string invalid = text;
+                invalid[at] = (at % 2) ? '-' : '\x80';
+                REQUIRE(decode<base64_encoding>(invalid, decoded) == at);
+            }
+        }
+    }
+
+    REQUIRE(decode<base64_encoding>("QUJD=", decoded) == 4); // padding only at the end
+    REQUIRE(decode<base64_encoding>("QUJDR", decoded) == 5); // truncated
+}
+
+static std::vector<uint8_t> stored_blob;
+
+void store_hex(hex_blob b)
+{
+    stored_blob = b;
+}
+
+void store_base64(base64_blob b)
+{
+    stored_blob = b;
+}
+
+void store_key(fixed_blob<hex_encoding, 4> key)
+{
+    stored_blob.assign(key.bytes, key.bytes + key.size());
+}
+
+TEST_CASE("test option 1 param: blobs..", "..")
+{
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(store_hex, "hex", "takes hex") );
+    REQUIRE_NOTHROW( parser.add_option(store_base64, "b64", "takes base64") );
+    REQUIRE_NOTHROW( parser.add_option(store_key, "key", "takes 4 bytes") );
+    REQUIRE ((param_extractor<fixed_blob<hex_encoding, 4> >::usage() == "<hex>(4 bytes)"));
+
+    my_argv argv;
+    argv.add_param(program_name);
+    int name_id = argv.add_param("hex");
+    int value_id = argv.add_param("00ff10Ab");
+
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (stored_blob.size() == 4);
+    REQUIRE (stored_blob[1] == 0xff);
+    REQUIRE (stored_blob[3] == 0xab);
+
+    cmd_line_parser parser2; // (run() executes all options found so far again)
+    REQUIRE_NOTHROW( parser2.add_option(store_key, "key", "takes 4 bytes") );
+    REQUIRE_NOTHROW( parser2.add_option(store_base64, "b64", "takes base64") );
+    argv.update_param(name_id, "key");
+    stored_blob.clear();
+    REQUIRE (parser2.run(argv.size(), argv.ptr()));
+    REQUIRE (stored_blob.size() == 4);
+    REQUIRE (stored_blob[2] == 0x10);
+
+    argv.update_param(value_id, "00ff10");
+    REQUIRE_FALSE (parser2.run(argv.size(), argv.ptr())); // too short
+    argv.update_param(value_id, "00ff10Ab00");
+    REQUIRE_FALSE (parser2.run(argv.size(), argv.ptr())); // too long
+
+    cmd_line_parser parser3;
+    REQUIRE_NOTHROW( parser3.add_option(store_base64, "b64", "takes base64") );
+    argv.update_param(name_id, "b64");
+    argv.update_param(value_id, "aGVsbG8=");
+    REQUIRE (parser3.run(argv.size(), argv.ptr()));
+    REQUIRE (std::string(stored_blob.begin(), stored_blob.end()) == "hello");
+
+    std::stringstream s;
+    s << "\"0a1x\"";
+    try
+    {
+        param_extractor<hex_blob>::extract(s);
+        REQUIRE (false);
+    }
+    catch (const option_error& e)
+    {
+        REQUIRE (std::string(e.what()).find("offset 3") != std::string::npos);
+    }
+}
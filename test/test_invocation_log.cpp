@@ -0,0 +1,124 @@
+/*
+ * test_invocation_log.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdio.h>
+#include <cmd_line_options.h>
+#include <invocation_log.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+static const char* log_file = "test_invocation_log.log";
+
+static int executed = 0;
+
+void count_execution(int)
+{
+    executed++;
+}
+
+static void define_options(cmd_line_parser& parser)
+{
+    parser.add_option(count_execution, "n,--number", "option that takes int");
+    parser.add_option(option0, "a", "option a");
+}
+
+TEST_CASE("parse only", "handlers should not be executed")
+{
+    cmd_line_parser parser;
+    define_options(parser);
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("n");
+    argv.add_param("12");
+
+    executed = 0;
+    REQUIRE(parser.parse(argv.size(), argv.ptr()));
+    REQUIRE(parser.check_if_option_specified("n"));
+    REQUIRE(executed == 0);
+
+    argv.update_param(2, "x");
+    REQUIRE_FALSE(parser.parse(argv.size(), argv.ptr()));
+
+    argv.update_param(2, "13");
+    REQUIRE(parser.run(argv.size(), argv.ptr()));
+    REQUIRE(executed == 1);
+}
+
+TEST_CASE("record and replay", "recorded command lines should be replayed")
+{
+    remove(log_file);
+    cmd_line_parser parser;
+    define_options(parser);
+
+    {
+        invocation_recorder recorder(log_file);
+        REQUIRE(recorder.is_open());
+
+        my_argv argv;
+        argv.add_param(program_name);
+        argv.add_param("--number");
+        argv.add_param("12");
+        argv.add_param("a");
+        REQUIRE(recorder.record(parser, argv.size(), argv.ptr()));
+
+        argv.update_param(2, "wrong");
+        REQUIRE(recorder.record(parser, argv.size(), argv.ptr()));
+
+        REQUIRE(recorder.record(argv.size(), argv.ptr(), 0x1234)); // different schema
+    }
+
+    std::vector<recorded_invocation> invocations;
+    REQUIRE(read_invocation_log(log_file, invocations) == 0);
+    REQUIRE(invocations.size() == 3);
+    REQUIRE(invocations[0].args.size() == 4);
+    REQUIRE(invocations[0].args[1] == "--number");
+    REQUIRE(invocations[1].args[2] == "wrong");
+    REQUIRE(invocations[2].fingerprint == 0x1234);
+
+    executed = 0;
+    replay_stats stats = replay_invocations(parser, log_file);
+    std::cout << stats << std::endl;
+    REQUIRE(executed == 0);
+    REQUIRE(stats.invocations == 2);
+    REQUIRE(stats.skipped == 1);
+    REQUIRE(stats.failed == 1);
+    REQUIRE(stats.p50 <= stats.p90);
+    REQUIRE(stats.p90 <= stats.p99);
+    REQUIRE(stats.p99 <= stats.max);
+
+    stats = replay_invocations(parser, log_file, false);
+    REQUIRE(stats.invocations == 3);
+
+    // a different schema has a different fingerprint
+    cmd_line_parser other;
+    other.add_option(count_execution, "n,--number", "option that takes int");
+    REQUIRE(other.schema_fingerprint() != parser.schema_fingerprint());
+    REQUIRE(replay_invocations(other, log_file).skipped == 3);
+
+    // (fingerprint is cached, but not once the schema changes)
+    uint32_t fingerprint = other.schema_fingerprint();
+    REQUIRE(other.schema_fingerprint() == fingerprint);
+    other.add_option(count_execution, "m", "another option");
+    REQUIRE(other.schema_fingerprint() != fingerprint);
+
+    // partially written record is ignored
+    FILE* f = fopen(log_file, "ab");
+    REQUIRE(f != NULL);
+    fwrite("CLIL", 1, 4, f);
+    fclose(f);
+    invocations.clear();
+    REQUIRE(read_invocation_log(log_file, invocations) == 4);
+    REQUIRE(invocations.size() == 3);
+
+    remove(log_file);
+    REQUIRE_THROWS(replay_invocations(parser, log_file));
+}
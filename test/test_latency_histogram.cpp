@@ -0,0 +1,150 @@
+/*
+ * test_latency_histogram.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <cmd_line_options.h>
+#include <latency_histogram.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+
+static bool close_to(uint64_t value, uint64_t expected)
+{
+    // (reported values are the highest of their buckets, i.e. at most 1/8 bigger)
+    return value >= expected && value <= expected + expected / 8;
+}
+
+TEST_CASE("latency histogram", "percentiles should be accurate")
+{
+    latency_histogram h;
+    REQUIRE(h.count() == 0);
+    REQUIRE(h.percentile(99) == 0);
+
+    for (uint64_t i = 1; i <= 100000; i++)
+    {
+        h.record(i);
+    }
+    REQUIRE(h.count() == 100000);
+    REQUIRE(h.min() == 1);
+    REQUIRE(h.max() == 100000);
+    REQUIRE(h.mean() == 50000);
+    REQUIRE(close_to(h.percentile(50), 50000));
+    REQUIRE(close_to(h.percentile(90), 90000));
+    REQUIRE(close_to(h.percentile(99), 99000));
+    REQUIRE(h.percentile(100) == 100000);
+    REQUIRE(h.percentile(0.001) == 1); // (small values are counted exactly)
+
+    for (uint64_t v = 1; v < (1ull << 36); v = v * 3 + 1)
+    {
+        size_t bucket = latency_histogram::bucket_of(v);
+        REQUIRE(bucket < latency_histogram::buckets);
+        REQUIRE(latency_histogram::highest_value_of(bucket) >= v);
+        REQUIRE(close_to(latency_histogram::highest_value_of(bucket), v));
+    }
+    REQUIRE(latency_histogram::bucket_of(~0ull) == latency_histogram::buckets - 1);
+
+    latency_histogram slow; // (values of the last bucket are not distinguished)
+    slow.record(1ull << 40);
+    REQUIRE(slow.percentile(50) == (1ull << 40));
+
+    latency_histogram low;
+    latency_histogram high;
+    for (uint64_t i = 1; i <= 100000; i++)
+    {
+        (i <= 50000 ? low : high).record(i);
+    }
+    low.merge(high);
+    REQUIRE(low.count() == h.count());
+    REQUIRE(low.min() == h.min());
+    REQUIRE(low.max() == h.max());
+    REQUIRE(low.percentile(99) == h.percentile(99));
+}
+
+TEST_CASE("parser latency", "latencies of parsing and handlers should be recorded")
+{
+    cmd_line_parser parser;
+    parser.add_option(option0, "-a,option_a", "option a");
+    parser.add_option(option1<int>, "-i,int", "option that takes int");
+    REQUIRE_THROWS(parser.setup_stats_command("int"));
+    parser.setup_stats_command();
+
+    my_argv argv;
+    argv.add_param(program_name);
+    int param_id = argv.add_param("-a");
+    argv.add_param("-i");
+    argv.add_param("3");
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+    }
+    REQUIRE(parser.parse(argv.size(), argv.ptr()));
+
+    const parser_latency& latency = parser.latency();
+    REQUIRE(latency.parse.count() == 11);
+    REQUIRE(latency.parse.max() > 0);
+    REQUIRE(latency.handler_ids() == 2); // (indexed by ids of options)
+    REQUIRE(latency.find_handler(1)->count() == 10);
+    REQUIRE(latency.find_handler(2) == NULL);
+
+    cmd_line_parser other; // (e.g. used by another thread)
+    other.add_option(option0, "-a,option_a", "option a");
+    REQUIRE(other.run(argv.size() - 2, argv.ptr()));
+
+    parser_latency merged = parser.latency();
+    merged.merge(other.latency());
+    REQUIRE(merged.parse.count() == 12);
+    REQUIRE(merged.find_handler(0)->count() == 11);
+    REQUIRE(merged.find_handler(1)->count() == 10);
+    merged = other.latency();
+    REQUIRE(merged.find_handler(0)->count() == 1);
+    REQUIRE(merged.find_handler(1) == NULL);
+
+    std::stringstream out;
+    std::streambuf* prev = std::cout.rdbuf(out.rdbuf());
+    argv.update_param(param_id, "--parser-stats");
+    parser.run(argv.size(), argv.ptr());
+    std::cout.rdbuf(prev);
+    std::cout << out.str();
+    REQUIRE(out.str().find("handler \"-i,int\" [ns]: count: 10") != std::string::npos);
+    REQUIRE(parser.latency().find_handler(1)->count() == 10); // (not executed)
+
+    parser.reset_latency();
+    REQUIRE(parser.latency().parse.count() == 0);
+    REQUIRE(parser.latency().find_handler(1)->count() == 0);
+
+    parser.setup_stats_command(""); // (disabled)
+    REQUIRE_FALSE(parser.run(argv.size(), argv.ptr()));
+
+    cmd_line_parser with_default;
+    with_default.add_option(option1<int>, "", "default option that takes int");
+    my_argv default_argv;
+    default_argv.add_param(program_name);
+    default_argv.add_param("5");
+    REQUIRE(with_default.run(default_argv.size(), default_argv.ptr()));
+    REQUIRE(with_default.latency().handler_ids() == 1);
+    REQUIRE(with_default.latency().find_handler(0)->count() == 1);
+
+    // histograms are created only for handlers that are executed
+    cmd_line_parser many;
+    for (int i = 0; i < 1000; i++)
+    {
+        std::stringstream name;
+        name << "--opt" << i;
+        many.add_option(option0, name.str(), "option");
+    }
+    my_argv many_argv;
+    many_argv.add_param(program_name);
+    many_argv.add_param("--opt5");
+    REQUIRE(many.run(many_argv.size(), many_argv.ptr()));
+    REQUIRE(many.latency().handler_ids() == 6);
+    REQUIRE(many.latency().find_handler(5)->count() == 1);
+    REQUIRE(many.latency().find_handler(4) == NULL);
+    REQUIRE(many.latency().find_handler(999) == NULL);
+}
@@ -0,0 +1,202 @@
+/*
+ * test_lint.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdlib.h>
+#include <cmd_line_options.h>
+#include <cmd_line_lint.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+
+static const size_t huge = 1024 * 1024;
+static volatile bool allocations_limited = false;
+
+static void* limited_malloc(size_t size)
+{
+    void* p = (allocations_limited && size >= huge) ? NULL : malloc(size ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+#if __cplusplus < 201103L
+void* operator new(size_t size) throw (std::bad_alloc)
+{
+    return limited_malloc(size);
+}
+
+void operator delete(void* p) throw ()
+{
+    free(p);
+}
+#else
+void* operator new(size_t size)
+{
+    return limited_malloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+#endif
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+#endif
+
+static void define_options(cmd_line_parser& parser)
+{
+    parser.add_option(option0, "-a,option_a", "option a");
+    parser.add_option(option1<int>, "int,-i", "option that takes int");
+    parser.add_option(option2<char, int>, "b", "option b that takes 2 params");
+    parser.add_option(option0, "standalone", "option that must be used alone");
+    parser.setup_option_add_required("b", "-a");
+    parser.setup_option_add_not_wanted("int", "b");
+    parser.setup_option_as_standalone("standalone");
+}
+
+static void define_invalid_options(cmd_line_parser& parser)
+{
+    define_options(parser);
+    parser.setup_option_add_required("standalone", "-a");
+}
+
+TEST_CASE("split command line", "should split it as the shell would")
+{
+    std::vector<std::string> args;
+    REQUIRE(split_command_line("  prog -a  'b c' \"d \\\"e\\\"\" f\\ g \"\"", args));
+    REQUIRE(args.size() == 6);
+    REQUIRE(args[0] == "prog");
+    REQUIRE(args[1] == "-a");
+    REQUIRE(args[2] == "b c");
+    REQUIRE(args[3] == "d \"e\"");
+    REQUIRE(args[4] == "f g");
+    REQUIRE(args[5] == "");
+    REQUIRE_FALSE(split_command_line("prog 'a", args));
+}
+
+TEST_CASE("validate", "should return errors instead of printing them")
+{
+    cmd_line_parser parser;
+    define_options(parser);
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("b");
+    argv.add_param("x");
+    argv.add_param("12");
+
+    std::stringstream out;
+    std::streambuf* prev = std::cout.rdbuf(out.rdbuf());
+    std::string error;
+    bool valid = parser.validate(argv.size(), argv.ptr(), error);
+    std::cout.rdbuf(prev);
+    REQUIRE_FALSE(valid);
+    REQUIRE(error.find("-a") != std::string::npos);
+    REQUIRE(out.str().empty());
+
+    argv.add_param("-a");
+    REQUIRE(parser.validate(argv.size(), argv.ptr(), error));
+    REQUIRE(error.empty());
+
+    cmd_line_parser invalid;
+    define_invalid_options(invalid);
+    REQUIRE_THROWS(invalid.validate(argv.size(), argv.ptr(), error));
+}
+
+TEST_CASE("validate command lines", "should find all that are not valid")
+{
+    const char* samples[] = {"prog -a",
+                             "prog b x 12",              // requires -a
+                             "prog b x 12 -a",
+                             "prog int 3 b x 12 -a",     // int can't be used with b
+                             "prog standalone",
+                             "prog standalone -a",       // standalone
+                             "prog -i abc",              // not an int
+                             "prog no_such_option",
+                             "prog"};                    // nothing specified
+    const bool valid[] = {true, false, true, false, true, false, false, false, false};
+    const size_t num_samples = sizeof(samples) / sizeof(samples[0]);
+
+    std::vector<std::vector<std::string> > command_lines;
+    for (size_t i = 0; i < 10000; i++)
+    {
+        command_lines.push_back(std::vector<std::string>());
+        REQUIRE(split_command_line(samples[i % num_samples], command_lines.back()));
+    }
+
+    for (size_t threads = 1; threads <= 4; threads += 3)
+    {
+        command_line_validator validator(define_options, threads);
+        std::vector<validation_failure> failures;
+        size_t expected = 0;
+        for (size_t i = 0; i < command_lines.size(); i++)
+        {
+            expected += valid[i % num_samples] ? 0 : 1;
+        }
+        REQUIRE(validator.validate(command_lines, failures) == expected);
+        REQUIRE(failures.size() == expected);
+        for (size_t i = 0; i < failures.size(); i++)
+        {
+            REQUIRE_FALSE(valid[failures[i].index % num_samples]);
+            REQUIRE(failures[i].error.size() > 0);
+            if (i > 0)
+            {
+                REQUIRE(failures[i - 1].index < failures[i].index);
+            }
+        }
+    }
+
+    REQUIRE_THROWS(command_line_validator(define_invalid_options, 2));
+}
+
+TEST_CASE("validate command lines that throw", "should report other errors for these lines")
+{
+    const char* samples[] = {"prog -a", "prog -i 4", "prog -a -i"};
+    std::vector<std::vector<std::string> > command_lines;
+    for (size_t i = 0; i < 3000; i++)
+    {
+        command_lines.push_back(std::vector<std::string>());
+        REQUIRE(split_command_line(samples[i % 3], command_lines.back()));
+        if (i % 300 == 0)
+        {
+            // (parsing of this one will run out of memory)
+            command_lines.back().push_back(std::string(huge, 'x'));
+        }
+    }
+
+    for (size_t threads = 1; threads <= 4; threads += 3)
+    {
+        command_line_validator validator(define_options, threads);
+        std::vector<validation_failure> failures;
+        failures.reserve(command_lines.size());
+        allocations_limited = true;
+        size_t invalid = validator.validate(command_lines, failures);
+        allocations_limited = false;
+        REQUIRE(invalid == 1010);
+        size_t out_of_memory = 0;
+        for (size_t i = 0; i < failures.size(); i++)
+        {
+            if (failures[i].index % 300 == 0)
+            {
+                REQUIRE(failures[i].error == std::bad_alloc().what());
+                out_of_memory++;
+            }
+        }
+        REQUIRE(out_of_memory == 10);
+    }
+}
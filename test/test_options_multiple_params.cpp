@@ -9,6 +9,7 @@
 
 #include <string.h>
 #include <cmd_line_options.h>
+#include <passthrough_spawn.h>
 #include <sstream>
 #include <iostream>
 
@@ -116,3 +117,504 @@ TEST_CASE("test setup require any of", "should pass")
     std::cout << "cmdline: " << argv << std::endl;
     REQUIRE( parser.run(argv.size(), argv.ptr()) );
 }
+
+TEST_CASE("test setup dependencies", "should follow required options and detect contradictions")
+{
+    std::cout << "test setup of dependencies..\n";
+
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(option0, "a", "option a that takes no params") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "b", "option b that takes no params") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "c", "option c that takes no params") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "d", "option d that takes no params") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "s", "option s that takes no params") );
+    REQUIRE_NOTHROW( parser.setup_option_add_required("a", "b"));
+    REQUIRE_NOTHROW( parser.setup_option_add_required("b", "c"));
+    REQUIRE_NOTHROW( parser.setup_option_add_not_wanted("d", "c"));
+    REQUIRE_NOTHROW( parser.setup_option_as_standalone("s"));
+    REQUIRE_NOTHROW( parser.setup_check_dependencies());
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("a");
+    int param_id = argv.add_param("b");
+
+    std::cout << "cmdline: " << argv << std::endl;
+    REQUIRE_FALSE( parser.run(argv.size(), argv.ptr()) ); // "a" requires also "c" (through "b")
+
+    argv.update_param(param_id, "c");
+    std::cout << "cmdline: " << argv << std::endl;
+    REQUIRE_FALSE( parser.run(argv.size(), argv.ptr()) );
+
+    argv.add_param("b");
+    std::cout << "cmdline: " << argv << std::endl;
+    REQUIRE( parser.run(argv.size(), argv.ptr()) );
+
+    // contradiction: "a" requires "c" (through "b"), that can't be used with "d"
+    REQUIRE_NOTHROW( parser.setup_option_add_required("a", "d"));
+    REQUIRE_THROWS( parser.run(argv.size(), argv.ptr()) );
+    REQUIRE_THROWS( parser.setup_check_dependencies() );
+
+    cmd_line_parser parser2;
+    REQUIRE_NOTHROW( parser2.add_option(option0, "a", "option a that takes no params") );
+    REQUIRE_NOTHROW( parser2.add_option(option0, "b", "option b that takes no params") );
+    REQUIRE_NOTHROW( parser2.add_option(option0, "c", "option c that takes no params") );
+    REQUIRE_NOTHROW( parser2.setup_option_add_required("a", "b"));
+    REQUIRE_NOTHROW( parser2.setup_option_add_not_wanted("b", "a"));
+    REQUIRE_THROWS( parser2.setup_check_dependencies() ); // "b" can't be used with "a"
+
+    cmd_line_parser parser3;
+    REQUIRE_NOTHROW( parser3.add_option(option0, "a", "option a that takes no params") );
+    REQUIRE_NOTHROW( parser3.add_option(option0, "b", "option b that takes no params") );
+    REQUIRE_NOTHROW( parser3.add_option(option0, "c", "option c that takes no params") );
+    REQUIRE_NOTHROW( parser3.setup_option_add_required("a", "b"));
+    REQUIRE_NOTHROW( parser3.setup_option_add_required("b", "c"));
+    REQUIRE_NOTHROW( parser3.setup_check_dependencies());
+    REQUIRE_NOTHROW( parser3.setup_option_add_required("c", "a"));
+    REQUIRE_THROWS( parser3.setup_check_dependencies() ); // cycle
+
+    cmd_line_parser parser4;
+    REQUIRE_NOTHROW( parser4.add_option(option0, "a", "option a that takes no params") );
+    REQUIRE_NOTHROW( parser4.add_option(option0, "s", "option s that takes no params") );
+    REQUIRE_NOTHROW( parser4.setup_option_as_standalone("s"));
+    REQUIRE_NOTHROW( parser4.setup_option_add_required("s", "a"));
+    REQUIRE_THROWS( parser4.setup_check_dependencies() ); // standalone with requirements
+
+    cmd_line_parser parser5;
+    REQUIRE_NOTHROW( parser5.add_option(option0, "a", "option a that takes no params") );
+    REQUIRE_NOTHROW( parser5.add_option(option0, "s", "option s that takes no params") );
+    REQUIRE_NOTHROW( parser5.setup_option_as_standalone("s"));
+    REQUIRE_NOTHROW( parser5.setup_options_require_all("a, s"));
+    REQUIRE_THROWS( parser5.setup_check_dependencies() ); // both required, but "s" is standalone
+}
+
+TEST_CASE("test setup dependencies with handles", "should work as with names of options")
+{
+    cmd_line_parser parser;
+    option_handle a = parser.add_option(option0, "a,-a", "option a that takes no params");
+    option_handle b = parser.add_option(option0, "b", "option b that takes no params");
+    option_handle c = parser.add_option(option0, "c", "option c that takes no params");
+    option_handle d = parser.add_option(option0, "d", "option d that takes no params");
+    REQUIRE_NOTHROW( parser.setup_option_add_required(a, b | c) );
+    REQUIRE_NOTHROW( parser.setup_option_add_not_wanted(d, a) );
+    REQUIRE_NOTHROW( parser.setup_options_require_any_of(a | b | d) );
+    REQUIRE_NOTHROW( parser.setup_check_dependencies() );
+
+    cmd_line_parser other;
+    option_handle other_a = other.add_option(option0, "a", "option a of other parser");
+    REQUIRE_THROWS( parser.setup_option_add_required(a, other_a) );
+    REQUIRE_THROWS( parser.setup_options_require_all(option_handle()) );
+    REQUIRE_NOTHROW( other.setup_options_require_all(other_a) );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    int param_id = argv.add_param("-a");
+    argv.add_param("b");
+    REQUIRE_FALSE( parser.run(argv.size(), argv.ptr()) ); // "a" requires also "c"
+
+    argv.add_param("c");
+    REQUIRE( parser.run(argv.size(), argv.ptr()) );
+
+    argv.update_param(param_id, "d");
+    REQUIRE( parser.parse(2, argv.ptr()) );
+    argv.add_param("-a");
+    REQUIRE_FALSE( parser.parse(argv.size(), argv.ptr()) ); // "d" can't be used with "a"
+    REQUIRE_FALSE( parser.parse(1, argv.ptr()) ); // one of a, b or d is required
+    argv.update_param(param_id, "c");
+    REQUIRE_FALSE( parser.parse(2, argv.ptr()) );
+
+    REQUIRE_FALSE( other.parse(1, argv.ptr()) );
+}
+
+TEST_CASE("test passthrough", "arguments following -- should not be parsed")
+{
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(option1<int>, "a", "option a") );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("a");
+    argv.add_param("12");
+    argv.add_param("--");
+    argv.add_param("sh");
+    argv.add_param("-c");
+    argv.add_param("exit 3");
+
+    REQUIRE_FALSE( parser.run(argv.size(), argv.ptr()) ); // "--" is not an option
+    REQUIRE( parser.passthrough_argv() == NULL );
+
+    parser.setup_passthrough();
+    REQUIRE( parser.run(argv.size(), argv.ptr()) );
+    REQUIRE( status_manager::get_stored_value<int>(1) == 12 );
+    REQUIRE( parser.passthrough_argc() == 3 );
+    REQUIRE( parser.passthrough_argv() == argv.ptr() + 4 );
+    REQUIRE( std::string(parser.passthrough_argv()[2]) == "exit 3" );
+#ifdef PASSTHROUGH_SPAWN_H_
+    REQUIRE( run_passthrough(parser) == 3 );
+#endif
+
+    argv.update_param(5, "--"); // only the first one ends the command line
+    REQUIRE( parser.run(argv.size(), argv.ptr()) );
+    REQUIRE( parser.passthrough_argc() == 3 );
+
+    argv.update_param(3, "a");
+    argv.update_param(4, "7");
+    REQUIRE( parser.run(argv.size() - 1, argv.ptr()) );
+    REQUIRE( parser.passthrough_argc() == 0 );
+    REQUIRE( parser.passthrough_argv() == NULL );
+#ifdef PASSTHROUGH_SPAWN_H_
+    REQUIRE( run_passthrough(parser) == -1 );
+#endif
+}
+
+static int load_calls = 0;
+static std::string loaded_index;
+static int loaded_level = 0;
+
+void load_index(std::string name, int level)
+{
+    load_calls++;
+    loaded_index = name;
+    loaded_level = level;
+}
+
+TEST_CASE("test idempotent options", "handler should be executed once")
+{
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--load-index");
+    argv.add_param("x");
+    argv.add_param("1");
+    argv.add_param("-a");
+    argv.add_param("--load-index");
+    argv.add_param("y");
+    argv.add_param("2");
+    argv.add_param("--load-index");
+    int last_level = argv.add_param("y") + 1;
+    argv.add_param("3");
+
+    {
+        cmd_line_parser parser;
+        REQUIRE_NOTHROW( parser.add_option(load_index, "--load-index", "loads the index") );
+        REQUIRE_NOTHROW( parser.add_option(option0, "-a", "option a") );
+        load_calls = 0;
+        REQUIRE( parser.run(argv.size(), argv.ptr()) );
+        REQUIRE( load_calls == 3 ); // by default: for each occurrence
+    }
+
+    {
+        cmd_line_parser parser;
+        REQUIRE_NOTHROW( parser.add_option(load_index, "--load-index", "loads the index") );
+        REQUIRE_NOTHROW( parser.add_option(option0, "-a", "option a") );
+        REQUIRE_THROWS( parser.setup_option_as_idempotent("--no-such-option") );
+        REQUIRE_NOTHROW( parser.setup_option_as_idempotent("--load-index") );
+        load_calls = 0;
+        REQUIRE( parser.run(argv.size(), argv.ptr()) );
+        REQUIRE( load_calls == 1 );
+        REQUIRE( loaded_index == "y" );
+        REQUIRE( loaded_level == 3 );
+
+        // all occurrences are still checked
+        argv.update_param(last_level, "abc");
+        REQUIRE_FALSE( parser.parse(argv.size(), argv.ptr()) );
+        argv.update_param(last_level, "3");
+    }
+
+    {
+        cmd_line_parser parser;
+        REQUIRE_NOTHROW( parser.add_option(load_index, "--load-index", "loads the index") );
+        REQUIRE_NOTHROW( parser.add_option(option0, "-a", "option a") );
+        REQUIRE_NOTHROW( parser.setup_option_as_idempotent("--load-index", option::first_wins) );
+        load_calls = 0;
+        REQUIRE( parser.run(argv.size(), argv.ptr()) );
+        REQUIRE( load_calls == 1 );
+        REQUIRE( loaded_index == "x" );
+        REQUIRE( loaded_level == 1 );
+    }
+}
+
+static int points_calls = 0;
+static std::vector<int> points_x;
+static std::vector<double> points_y;
+
+void add_points(const std::vector<int>& x, const std::vector<double>& y)
+{
+    points_calls++;
+    points_x = x;
+    points_y = y;
+}
+
+TEST_CASE("test aggregated options", "handler should be executed once with all values")
+{
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_aggregated_option(add_points, "-p", "adds a point @param x x @param y y") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "-a", "option a") );
+    REQUIRE_THROWS( parser.setup_option_as_idempotent("-p") ); // (it's aggregated)
+    REQUIRE_THROWS( parser.setup_option_as_idempotent("-p", option::first_wins) );
+    REQUIRE_THROWS( parser.setup_option_as_idempotent("-a", option::all_at_once) );
+
+    std::vector<std::string> args;
+    std::vector<char*> argv;
+    args.push_back(program_name);
+    for (int i = 0; i < 1000; i++)
+    {
+        std::stringstream x, y;
+        x << i;
+        y << i * 0.5;
+        args.push_back("-p");
+        args.push_back(x.str());
+        args.push_back(y.str());
+        if (i == 500)
+        {
+            args.push_back("-a");
+        }
+    }
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+    }
+
+    REQUIRE( parser.run(argv.size(), &argv[0]) );
+    REQUIRE( points_calls == 1 );
+    REQUIRE( points_x.size() == 1000 );
+    REQUIRE( points_y.size() == 1000 );
+    REQUIRE( points_x[999] == 999 );
+    REQUIRE( points_y[10] == 5.0 );
+
+    // values of the previous command line are forgotten
+    REQUIRE( parser.parse(4, &argv[0]) );
+    REQUIRE( parser.run(4, &argv[0]) );
+    REQUIRE( points_x.size() == 1 );
+    REQUIRE( points_y[0] == 0.0 );
+
+    args[2] = "x";
+    argv[2] = const_cast<char*>(args[2].c_str());
+    REQUIRE_FALSE( parser.parse(argv.size(), &argv[0]) );
+}
+
+static std::vector<std::string> chain_calls;
+
+void app_option(char c, int i)
+{
+    std::stringstream s;
+    s << "app " << c << " " << i;
+    chain_calls.push_back(s.str());
+}
+
+void lib_log_level(int level)
+{
+    std::stringstream s;
+    s << "log " << level;
+    chain_calls.push_back(s.str());
+}
+
+void lib_threads(int count)
+{
+    std::stringstream s;
+    s << "threads " << count;
+    chain_calls.push_back(s.str());
+}
+
+void chain_other_args(std::vector<std::string>& other_args)
+{
+    for (size_t i = 0; i < other_args.size(); i++)
+    {
+        chain_calls.push_back("other " + other_args[i]);
+    }
+}
+
+void chain_files(rest_of_args files)
+{
+    std::string call("files");
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        call += std::string(" ") + files[i];
+    }
+    chain_calls.push_back(call);
+}
+
+TEST_CASE("test chained parsers", "parsers should share one command line")
+{
+    cmd_line_parser app;
+    cmd_line_parser lib;
+    REQUIRE_NOTHROW( app.add_option(app_option, "b", "app option") );
+    REQUIRE_NOTHROW( app.add_option(option0, "-a", "option a") );
+    REQUIRE_NOTHROW( app.setup_option_add_required("b", "-a") );
+    REQUIRE_NOTHROW( lib.add_option(lib_log_level, "--log-level", "library option") );
+    REQUIRE_NOTHROW( lib.add_option(lib_threads, "--threads", "library option") );
+    REQUIRE_NOTHROW( app.add_chained_parser(lib) );
+    REQUIRE_THROWS( app.add_chained_parser(lib) );
+    REQUIRE_THROWS( lib.add_chained_parser(app) );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    int param_id = argv.add_param("--log-level");
+    argv.add_param("3");
+    argv.add_param("b");
+    argv.add_param("x");
+    argv.add_param("12");
+    argv.add_param("--threads");
+    argv.add_param("8");
+    argv.add_param("-a");
+
+    chain_calls.clear();
+    REQUIRE( app.run(argv.size(), argv.ptr()) );
+    REQUIRE( chain_calls.size() == 3 );
+    REQUIRE( chain_calls[0] == "app x 12" );
+    REQUIRE( chain_calls[1] == "log 3" );
+    REQUIRE( chain_calls[2] == "threads 8" );
+    REQUIRE( app.check_if_option_specified("-a") );
+    REQUIRE( lib.check_if_option_specified("--threads") );
+
+    // not valid for one of them: none of handlers is executed
+    argv.update_param(param_id + 1, "three");
+    chain_calls.clear();
+    REQUIRE_FALSE( app.run(argv.size(), argv.ptr()) );
+    REQUIRE( chain_calls.empty() );
+
+    argv.update_param(param_id + 1, "3");
+    argv.update_param(argv.size() - 1, "--other");
+    chain_calls.clear();
+    REQUIRE_FALSE( app.run(argv.size(), argv.ptr()) ); // not recognised by any of them
+    REQUIRE_FALSE( app.run(argv.size() - 1, argv.ptr()) ); // b requires -a
+    REQUIRE( chain_calls.empty() );
+
+    // parameters of an option can't be taken from arguments of the previous parser
+    my_argv split;
+    split.add_param(program_name);
+    split.add_param("--threads");
+    split.add_param("-a");
+    split.add_param("8");
+    REQUIRE_FALSE( app.parse(split.size(), split.ptr()) );
+
+    // the last parser in chain gets what's left
+    cmd_line_parser rest;
+    rest.add_handler_for_other_arguments(chain_other_args);
+    REQUIRE_NOTHROW( app.add_chained_parser(rest) );
+    REQUIRE( app.run(argv.size(), argv.ptr()) == false ); // still requires -a
+    argv.add_param("-a");
+    chain_calls.clear();
+    REQUIRE( app.run(argv.size(), argv.ptr()) );
+    REQUIRE( chain_calls.size() == 4 );
+    REQUIRE( chain_calls[3] == "other --other" );
+
+    std::string error;
+    REQUIRE( app.validate(argv.size(), argv.ptr(), error) );
+    argv.update_param(param_id + 4, "twelve");
+    REQUIRE_FALSE( app.validate(argv.size(), argv.ptr(), error) );
+    REQUIRE_FALSE( error.empty() );
+}
+
+TEST_CASE("test chained parsers with rest of args", "options of other parsers should end them")
+{
+    cmd_line_parser app;
+    cmd_line_parser lib;
+    REQUIRE_NOTHROW( app.add_option(chain_files, "--files", "app option") );
+    REQUIRE_NOTHROW( app.add_option(option0, "-a", "option a") );
+    REQUIRE_NOTHROW( lib.add_option(lib_threads, "--threads", "library option") );
+    REQUIRE_NOTHROW( lib.add_option(chain_files, "--lib-files", "library option") );
+    REQUIRE_NOTHROW( app.add_chained_parser(lib) );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--files");
+    argv.add_param("x");
+    argv.add_param("--threads");
+    argv.add_param("4");
+    argv.add_param("--lib-files");
+    argv.add_param("y");
+    argv.add_param("z");
+    argv.add_param("-a");
+
+    chain_calls.clear();
+    REQUIRE( app.run(argv.size(), argv.ptr()) );
+    REQUIRE( chain_calls.size() == 3 );
+    REQUIRE( chain_calls[0] == "files x" );
+    REQUIRE( chain_calls[1] == "threads 4" );
+    REQUIRE( chain_calls[2] == "files y z" );
+    REQUIRE( app.check_if_option_specified("-a") );
+}
+
+TEST_CASE("test run and strip", "parsed arguments should be removed from argv")
+{
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(app_option, "b", "app option") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "-a", "option a") );
+    parser.setup_passthrough();
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--gtest_filter=abc");
+    argv.add_param("b");
+    argv.add_param("x");
+    argv.add_param("12");
+    argv.add_param("other");
+    argv.add_param("-a");
+    argv.add_param("--");
+    argv.add_param("-a");
+
+    char** args = argv.ptr();
+    char* all[9];
+    std::copy(args, args + 9, all);
+    int argc = argv.size();
+    chain_calls.clear();
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::stripped );
+    REQUIRE( chain_calls.size() == 1 );
+    REQUIRE( argc == 5 );
+    REQUIRE( args[0] == all[0] );
+    REQUIRE( std::string(args[1]) == "--gtest_filter=abc" );
+    REQUIRE( std::string(args[2]) == "other" );
+    REQUIRE( std::string(args[3]) == "--" );
+    REQUIRE( std::string(args[4]) == "-a" );
+    REQUIRE( parser.passthrough_argc() == 1 );
+    REQUIRE( parser.passthrough_argv() == args + 4 );
+
+    // the rest of argv is permuted
+    std::sort(all, all + 9);
+    std::sort(args, args + 9);
+    REQUIRE( std::equal(all, all + 9, args) );
+
+    // nothing to parse: argv is not changed
+    argc = 2;
+    args = argv.ptr();
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::nothing_stripped );
+    REQUIRE( argc == 2 );
+    argc = 1;
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::nothing_stripped );
+    REQUIRE( argc == 1 );
+
+    // not valid
+    argv.update_param(4, "twelve");
+    argc = argv.size();
+    args = argv.ptr();
+    chain_calls.clear();
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::not_valid );
+    REQUIRE( argc == static_cast<int>(argv.size()) );
+    REQUIRE( std::string(args[2]) == "b" );
+    REQUIRE( chain_calls.empty() );
+
+    // chained parsers leave what none of them recognised
+    cmd_line_parser lib;
+    REQUIRE_NOTHROW( lib.add_option(lib_threads, "--threads", "library option") );
+    parser.add_chained_parser(lib);
+    argv.update_param(4, "12");
+    argv.update_param(5, "--threads");
+    argv.update_param(6, "4");
+    argc = argv.size();
+    args = argv.ptr();
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::stripped );
+    REQUIRE( argc == 4 );
+    REQUIRE( std::string(args[1]) == "--gtest_filter=abc" );
+    REQUIRE( std::string(args[2]) == "--" );
+
+    // none of chained parsers got an option, or one of them got a wrong one
+    argc = 2;
+    args = argv.ptr();
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::nothing_stripped );
+    REQUIRE( argc == 2 );
+    argv.update_param(6, "four");
+    argc = argv.size();
+    args = argv.ptr();
+    REQUIRE( parser.run_and_strip(argc, args) == cmd_line_parser::not_valid );
+    REQUIRE( argc == static_cast<int>(argv.size()) );
+}
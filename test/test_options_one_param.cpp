@@ -40,6 +40,42 @@ TEST_CASE("version and description", "should not throw")
     REQUIRE_NOTHROW( parser.set_version("1.2.43") );
 }
 
+TEST_CASE("doxygen tags in description", "should be extracted")
+{
+    doxy_dictionary d;
+    REQUIRE_FALSE( d.setup("no tags here") );
+    REQUIRE_FALSE( d.found_tokens("brief") );
+    REQUIRE_THROWS( d.get_occurences("brief") );
+
+    REQUIRE( d.setup("option that takes int. @param num: some number. @param  x:other\n"
+                     "@author someone. @return nothing") );
+    REQUIRE( d.text_of(d.get_occurences("brief").front().value) == "option that takes int. " );
+    const doxy_dictionary::occurrences& params = d.get_occurences("param");
+    REQUIRE( params.size() == 2 );
+    REQUIRE( d.text_of(params[0].name) == "num" );
+    REQUIRE( d.text_of(params[0].value) == "some number. " );
+    REQUIRE( d.text_of(params[1].name) == "x" );
+    REQUIRE( d.text_of(params[1].value) == "other\n" );
+    REQUIRE( d.text_of(d.get_occurences("author").front().value) == "someone" );
+    REQUIRE( d.text_of(d.get_occurences("return").front().value) == "nothing" );
+
+    REQUIRE( d.setup("@brief explicit @param n") );
+    REQUIRE( d.text_of(d.get_occurences("brief").front().value) == "explicit " );
+    REQUIRE( d.text_of(d.get_occurences("param").front().name) == "n" );
+    REQUIRE( d.text_of(d.get_occurences("param").front().value) == "" );
+    REQUIRE_FALSE( d.found_tokens("author") );
+
+    // long descriptions
+    std::string description("brief");
+    for (int i = 0; i < 20000; i++)
+    {
+        description += " @param p some description of the parameter";
+    }
+    REQUIRE( d.setup(description) );
+    REQUIRE( d.get_occurences("param").size() == 20000 );
+    REQUIRE( d.text_of(d.get_occurences("param").back().value) == "some description of the parameter" );
+}
+
 TEST_CASE("adding options stuff..", "should not throw")
 {
     std::cout << "adding options stuff...\n";
@@ -216,3 +252,342 @@ TEST_CASE("test option 1 param: double..", "..")
     std::cout << "cmdline: " << argv << std::endl;
     REQUIRE_FALSE (parser.run(argv.size(), argv.ptr()));
 }
+
+struct test_mode
+{
+    enum type
+    {
+        fast, safe, paranoid
+    };
+
+    static const choice_item<type>* items(size_t& count)
+    {
+        static const choice_item<type> table[] = { {"fast", fast},
+                                                   {"safe", safe},
+                                                   {"paranoid", paranoid} };
+        count = sizeof(table) / sizeof(table[0]);
+        return table;
+    }
+};
+
+static test_mode::type selected_mode = test_mode::fast;
+
+void set_mode(choice<test_mode> mode)
+{
+    selected_mode = mode;
+}
+
+TEST_CASE("test option 1 param: choice..", "..")
+{
+    std::cout << "test option 1 param: choice..\n";
+    REQUIRE (param_extractor<choice<test_mode> >::usage() == "<fast|safe|paranoid>");
+
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(set_mode, "--mode", "that takes a mode") );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--mode");
+    int value_id = argv.add_param("paranoid");
+
+    std::cout << "cmdline: " << argv << std::endl;
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (selected_mode == test_mode::paranoid);
+
+    argv.update_param(value_id, "safe");
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (selected_mode == test_mode::safe);
+
+    argv.update_param(value_id, "fast");
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (selected_mode == test_mode::fast);
+
+    // bad values..
+    std::stringstream s;
+    s << "Safe";
+    REQUIRE_THROWS (param_extractor<choice<test_mode> >::extract(s));
+
+    argv.update_param(value_id, "paranoi");
+    REQUIRE_FALSE (parser.run(argv.size(), argv.ptr()));
+
+    argv.update_param(value_id, "");
+    REQUIRE_FALSE (parser.run(argv.size(), argv.ptr()));
+}
+
+struct colliding_choices
+{
+    typedef int type;
+
+    static const choice_item<type>* items(size_t& count)
+    {
+        // (names with the same name_hash())
+        static const choice_item<type> table[] = { {"costarring", 1},
+                                                   {"liquid", 2} };
+        count = sizeof(table) / sizeof(table[0]);
+        return table;
+    }
+};
+
+struct duplicate_choices
+{
+    typedef int type;
+
+    static const choice_item<type>* items(size_t& count)
+    {
+        static const choice_item<type> table[] = { {"fast", 1},
+                                                   {"safe", 2},
+                                                   {"fast", 3} };
+        count = sizeof(table) / sizeof(table[0]);
+        return table;
+    }
+};
+
+TEST_CASE("test option 1 param: choices with the same hash..", "..")
+{
+    std::cout << "test option 1 param: choices with the same hash..\n";
+    REQUIRE (param_extractor<choice<colliding_choices> >::usage() == "<costarring|liquid>");
+    std::stringstream s1;
+    s1 << "costarring";
+    REQUIRE (param_extractor<choice<colliding_choices> >::extract(s1).get_value() == 1);
+    std::stringstream s2;
+    s2 << "liquid";
+    REQUIRE (param_extractor<choice<colliding_choices> >::extract(s2).get_value() == 2);
+    REQUIRE_THROWS (param_extractor<choice<duplicate_choices> >::usage());
+}
+
+struct many_choices
+{
+    typedef int type;
+
+    static const choice_item<type>* items(size_t& count)
+    {
+        static std::vector<std::string> names;
+        static std::vector<choice_item<type> > table;
+        if (table.empty())
+        {
+            for (int i = 0; i < 20000; i++)
+            {
+                std::stringstream s;
+                s << "value" << i;
+                names.push_back(s.str());
+            }
+            for (int i = 0; i < 20000; i++)
+            {
+                choice_item<type> item = {names[i].c_str(), i};
+                table.push_back(item);
+            }
+        }
+        count = table.size();
+        return &table[0];
+    }
+};
+
+TEST_CASE("test option 1 param: many choices..", "..")
+{
+    std::cout << "test option 1 param: many choices..\n";
+    for (int i = 0; i < 20000; i++)
+    {
+        std::stringstream s;
+        s << "value" << i;
+        if (param_extractor<choice<many_choices> >::extract(s).get_value() != i)
+        {
+            FAIL("value" << i << " was not found");
+        }
+    }
+
+    std::stringstream s;
+    s << "value20000";
+    REQUIRE_THROWS (param_extractor<choice<many_choices> >::extract(s));
+}
+
+static std::vector<std::string> captured_files;
+static bool verbose = false;
+
+void set_files(rest_of_args files)
+{
+    captured_files.assign(files.begin(), files.end());
+}
+
+void set_verbose()
+{
+    verbose = true;
+}
+
+TEST_CASE("test option 1 param: rest of args..", "..")
+{
+    std::cout << "test option 1 param: rest of args..\n";
+    REQUIRE (param_extractor<rest_of_args>::usage() == "[<arg> ...]");
+
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(set_files, "--files", "that takes any number of files") );
+    REQUIRE_NOTHROW( parser.add_option(set_verbose, "-v", "verbose") );
+    REQUIRE_NOTHROW( parser.add_option(option1<int>, "-n", "that takes a number") );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--files");
+    argv.add_param("a");
+    argv.add_param("b c");
+    argv.add_param("d");
+    argv.add_param("-v");
+    argv.add_param("-n");
+    argv.add_param("12");
+
+    std::cout << "cmdline: " << argv << std::endl;
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (captured_files.size() == 3);
+    REQUIRE (captured_files[0] == "a");
+    REQUIRE (captured_files[1] == "b c");
+    REQUIRE (captured_files[2] == "d");
+    REQUIRE (verbose);
+    REQUIRE (status_manager::get_stored_value<int>(1) == 12);
+
+    // up to the end of the command line
+    cmd_line_parser parser2;
+    REQUIRE_NOTHROW( parser2.add_option(set_files, "--files", "that takes any number of files") );
+    REQUIRE_NOTHROW( parser2.add_option(option1<int>, "-n", "that takes a number") );
+    my_argv argv2;
+    argv2.add_param(program_name);
+    argv2.add_param("-n");
+    argv2.add_param("3");
+    argv2.add_param("--files");
+    argv2.add_param("x");
+    argv2.add_param("y");
+    REQUIRE (parser2.run(argv2.size(), argv2.ptr()));
+    REQUIRE (captured_files.size() == 2);
+    REQUIRE (captured_files[1] == "y");
+    REQUIRE (status_manager::get_stored_value<int>(1) == 3);
+
+    // no arguments at all
+    cmd_line_parser parser3;
+    REQUIRE_NOTHROW( parser3.add_option(set_files, "--files", "that takes any number of files") );
+    REQUIRE_NOTHROW( parser3.add_option(set_verbose, "-v", "verbose") );
+    my_argv argv3;
+    argv3.add_param(program_name);
+    argv3.add_param("--files");
+    argv3.add_param("-v");
+    verbose = false;
+    REQUIRE (parser3.run(argv3.size(), argv3.ptr()));
+    REQUIRE (captured_files.empty());
+    REQUIRE (verbose);
+
+    // help and the stats command are not taken as arguments
+    parser3.setup_stats_command();
+    argv3.update_param(2, "a");
+    int last_id = argv3.add_param("--HELP");
+    REQUIRE_FALSE (parser3.run(argv3.size(), argv3.ptr()));
+    REQUIRE (captured_files.empty()); // (handlers are not executed if help is displayed)
+    argv3.update_param(last_id, "--parser-stats");
+    REQUIRE_FALSE (parser3.run(argv3.size(), argv3.ptr()));
+    REQUIRE (captured_files.empty());
+    REQUIRE (parser3.parse(argv3.size() - 1, argv3.ptr()));
+
+    std::stringstream s;
+    s << "a";
+    REQUIRE_THROWS (param_extractor<rest_of_args>::extract(s));
+}
+
+static index_range stored_range;
+
+void set_range(index_range range)
+{
+    stored_range = range;
+}
+
+TEST_CASE("test option 1 param: index range..", "..")
+{
+    std::cout << "test option 1 param: index range..\n";
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW( parser.add_option(set_range, "--shards", "that takes a range") );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--shards");
+    int value_id = argv.add_param("0-1048575:8");
+
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (stored_range.size() == 131072);
+    REQUIRE (stored_range.segments().size() == 1);
+    REQUIRE (stored_range[0] == 0);
+    REQUIRE (stored_range[131071] == 1048568);
+    REQUIRE (stored_range.contains(1048568));
+    REQUIRE_FALSE (stored_range.contains(1048569));
+    REQUIRE_FALSE (stored_range.contains(1048576));
+
+    argv.update_param(value_id, "1,5-9,100-200:10,7");
+    REQUIRE (parser.run(argv.size(), argv.ptr()));
+    REQUIRE (stored_range.size() == 18);
+    std::vector<index_range::value_type> values(stored_range.begin(), stored_range.end());
+    REQUIRE (values.size() == 18);
+    REQUIRE (values[0] == 1);
+    REQUIRE (values[1] == 5);
+    REQUIRE (values[6] == 100);
+    REQUIRE (values[16] == 200);
+    REQUIRE (values[17] == 7);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        REQUIRE (stored_range[i] == values[i]);
+        REQUIRE (stored_range.contains(values[i]));
+    }
+    REQUIRE_FALSE (stored_range.contains(105));
+
+    // parts cover the whole range, in order
+    std::vector<index_range::value_type> from_parts;
+    for (size_t part = 0; part < 4; part++)
+    {
+        index_range p = stored_range.part(part, 4);
+        REQUIRE (p.size() >= 4);
+        REQUIRE (p.size() <= 5);
+        from_parts.insert(from_parts.end(), p.begin(), p.end());
+    }
+    REQUIRE (from_parts == values);
+    REQUIRE_THROWS (stored_range.part(0, 0));
+    REQUIRE_THROWS (stored_range.part(4, 4));
+
+    const char* invalid[] = {"", "a", "1-", "5-1", "1-5:0", "1-5:", "1,", ",1", "1-5x",
+                             "99999999999999999999999",
+                             "0-18446744073709551614,0-5"}; // (too many numbers)
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        argv.update_param(value_id, invalid[i]);
+        REQUIRE_FALSE (parser.run(argv.size(), argv.ptr()));
+    }
+}
+
+TEST_CASE("test compact", "parser should still parse once descriptions are released")
+{
+    cmd_line_parser parser;
+    parser.add_group("First group", "with description");
+    REQUIRE_NOTHROW( parser.add_option(option1<int>, "int,-i",
+                                       "@brief option that takes int. @param num some number.") );
+    REQUIRE_NOTHROW( parser.add_option(option0, "-a", "option a") );
+    parser.setup_option_add_required("int", "-a");
+    uint32_t fingerprint = parser.schema_fingerprint();
+
+    REQUIRE_NOTHROW( parser.compact() );
+    REQUIRE( parser.schema_fingerprint() == fingerprint );
+    REQUIRE_THROWS( parser.add_option(option0, "-b", "option b") );
+    REQUIRE_THROWS( parser.setup_option_add_required("-a", "int") );
+
+    my_argv argv;
+    argv.add_param(program_name);
+    int param_id = argv.add_param("-i");
+    argv.add_param("12");
+    argv.add_param("-a");
+    REQUIRE( parser.run(argv.size(), argv.ptr()) );
+    REQUIRE( status_manager::get_stored_value<int>(1) == 12 );
+    REQUIRE( parser.check_if_option_specified("-a") );
+
+    std::string error;
+    argv.update_param(param_id + 1, "x");
+    REQUIRE_FALSE( parser.validate(argv.size(), argv.ptr(), error) );
+    REQUIRE( error.find("-i") != std::string::npos );
+    REQUIRE_FALSE( parser.validate(argv.size() - 2, argv.ptr(), error) ); // requires -a
+
+    argv.update_param(param_id, "--help");
+    std::stringstream out;
+    std::streambuf* prev = std::cout.rdbuf(out.rdbuf());
+    parser.run(2, argv.ptr());
+    std::cout.rdbuf(prev);
+    REQUIRE( out.str().find("help is not available") != std::string::npos );
+}
@@ -0,0 +1,153 @@
+/*
+ * test_path_glob.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdio.h>
+#include <cmd_line_options.h>
+#include <path_glob.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+static const char* program_name = "some/path/program/name";
+
+static std::vector<std::string> created;
+
+static void create(const std::string& path, bool is_dir = false)
+{
+    if (is_dir)
+    {
+        REQUIRE(mkdir(path.c_str(), 0755) == 0);
+    }
+    else
+    {
+        FILE* f = fopen(path.c_str(), "w");
+        REQUIRE(f != NULL);
+        fclose(f);
+    }
+    created.push_back(path);
+}
+
+static void remove_created()
+{
+    for (size_t i = created.size(); i > 0; i--)
+    {
+        remove(created[i - 1].c_str());
+    }
+    created.clear();
+}
+
+static std::string expanded(const std::string& pattern, size_t num_threads)
+{
+    std::vector<std::string> paths;
+    path_glob(pattern).expand(paths, num_threads);
+    std::string res;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        res += (i ? " " : "") + paths[i];
+    }
+    return res;
+}
+
+static std::vector<std::string> streamed;
+
+void add_streamed(const std::string& path)
+{
+    streamed.push_back(path);
+}
+
+static size_t thrown_after = 0;
+
+void throw_on_second(const std::string&)
+{
+    if (++thrown_after % 2 == 0)
+    {
+        throw std::runtime_error("second path");
+    }
+}
+
+static path_glob stored_glob;
+
+void set_glob(path_glob g)
+{
+    stored_glob = g;
+}
+
+TEST_CASE("path glob", "should expand patterns the same way for any number of threads")
+{
+    const std::string t = "test_path_glob.tmp";
+    remove_created();
+    create(t, true);
+    create(t + "/a.cpp");
+    create(t + "/b.cpp");
+    create(t + "/b.h");
+    create(t + "/.hidden.cpp");
+    create(t + "/src", true);
+    create(t + "/src/x.cpp");
+    create(t + "/src/x.h");
+    create(t + "/src/sub", true);
+    create(t + "/src/sub/y.cpp");
+    create(t + "/src/sub/deeper", true);
+    create(t + "/src/sub/deeper/z.cpp");
+    create(t + "/src/.git", true);
+    create(t + "/src/.git/w.cpp");
+
+    for (size_t threads = 1; threads <= 4; threads += 3)
+    {
+        REQUIRE(expanded(t + "/*.cpp", threads) == t + "/a.cpp " + t + "/b.cpp");
+        REQUIRE(expanded(t + "/?.h", threads) == t + "/b.h");
+        REQUIRE(expanded(t + "/[a]*", threads) == t + "/a.cpp");
+        REQUIRE(expanded(t + "/.h*", threads) == t + "/.hidden.cpp");
+        REQUIRE(expanded(t + "/*/x.*", threads) == t + "/src/x.cpp " + t + "/src/x.h");
+        REQUIRE(expanded(t + "/src/sub/y.cpp", threads) == t + "/src/sub/y.cpp");
+        REQUIRE(expanded(t + "/src/none.cpp", threads) == "");
+        REQUIRE(expanded(t + "/**/*.cpp", threads) ==
+                t + "/a.cpp " + t + "/b.cpp " + t + "/src/sub/deeper/z.cpp " +
+                t + "/src/sub/y.cpp " + t + "/src/x.cpp");
+        REQUIRE(expanded(t + "/src/**", threads) ==
+                t + "/src " + t + "/src/sub " + t + "/src/sub/deeper " + t + "/src/sub/deeper/z.cpp " +
+                t + "/src/sub/y.cpp " + t + "/src/x.cpp " + t + "/src/x.h");
+        REQUIRE(expanded(t + "/**/**/z.cpp", threads) == t + "/src/sub/deeper/z.cpp"); // only once
+    }
+
+    streamed.clear();
+    REQUIRE(path_glob(t + "/**/*.h").for_each(add_streamed, 4) == 2);
+    REQUIRE(streamed.size() == 2);
+
+    for (size_t threads = 1; threads <= 4; threads += 3)
+    {
+        // handler that throws: the walk is stopped and the exception reaches the caller
+        std::string caught;
+        thrown_after = 0;
+        try
+        {
+            path_glob(t + "/**").for_each(throw_on_second, threads);
+        }
+        catch (const std::runtime_error& e)
+        {
+            caught = e.what();
+        }
+        REQUIRE(caught == "second path");
+    }
+
+    cmd_line_parser parser;
+    REQUIRE_NOTHROW(parser.add_option(set_glob, "--sources", "takes a pattern"));
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--sources");
+    argv.add_param(t + "/src/*.h");
+    REQUIRE(parser.run(argv.size(), argv.ptr()));
+    REQUIRE(stored_glob.pattern() == t + "/src/*.h"); // not expanded yet
+    REQUIRE(expanded(stored_glob.pattern(), 0) == t + "/src/x.h");
+
+    remove_created();
+}
+
+#endif
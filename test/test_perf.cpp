@@ -0,0 +1,333 @@
+/*
+ * test_perf.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  @brief: Performance tests: they run representative workloads and compare number of
+ *  allocations (and allocated bytes) against the baseline (test_perf_baseline.h).
+ *  They also check, that the cost per item doesn't grow with the size of the workload,
+ *  so that accidental O(n^2) behaviour is reported as any other failure.
+ */
+
+#include "test_generic.h"
+
+#include <new>
+#include <stdlib.h>
+#include <cmd_line_options.h>
+#include <alias_map.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+#include "test_perf_baseline.h"
+
+static size_t allocations = 0;
+static size_t allocated_bytes = 0;
+
+static void* counted_malloc(size_t size)
+{
+    allocations++;
+    allocated_bytes += size;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+#if __cplusplus < 201103L
+void* operator new(size_t size) throw (std::bad_alloc)
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size) throw (std::bad_alloc)
+{
+    return counted_malloc(size);
+}
+
+void operator delete(void* p) throw ()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw ()
+{
+    free(p);
+}
+#else
+void* operator new(size_t size)
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size)
+{
+    return counted_malloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+#endif
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+#endif
+
+/**
+ * @brief Number of allocations / bytes allocated since it was created.
+ */
+class allocation_counter
+{
+public:
+    allocation_counter() :
+        start_allocations(allocations),
+        start_bytes(allocated_bytes)
+    {
+    }
+
+    double allocations_per(size_t items)
+    {
+        return static_cast<double>(allocations - start_allocations) / items;
+    }
+
+    double bytes_per(size_t items)
+    {
+        return static_cast<double>(allocated_bytes - start_bytes) / items;
+    }
+
+    size_t start_allocations;
+    size_t start_bytes;
+};
+
+static const char* program_name = "some/path/program/name";
+
+static std::string name_of(size_t i)
+{
+    std::stringstream s;
+    s << "opt_" << i << ",-o" << i;
+    return s.str();
+}
+
+static void add_options(cmd_line_parser& parser, size_t num_of_options)
+{
+    for (size_t i = 0; i < num_of_options; i++)
+    {
+        switch (i % 4)
+        {
+        case 0:
+            parser.add_option(option0, name_of(i), "option that takes no params");
+            break;
+        case 1:
+            parser.add_option(option1<int>, name_of(i),
+                              "@brief option that takes int. @param num some number.");
+            break;
+        case 2:
+            parser.add_option(option2<char, int>, name_of(i),
+                              "@brief option that takes two. @param c a char. @param num a number.");
+            break;
+        default:
+            parser.add_option(option1<std::string>, name_of(i), "option that takes a string");
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Command line, where options (with their parameters) are specified num_of_args times.
+ */
+class long_cmd_line
+{
+public:
+    long_cmd_line(size_t num_of_args)
+    {
+        params.push_back(program_name);
+        for (size_t i = 0; i < num_of_args; i++)
+        {
+            std::stringstream s;
+            s << "opt_" << i % 4;
+            params.push_back(s.str());
+            switch (i % 4)
+            {
+            case 1:
+                params.push_back("12");
+                break;
+            case 2:
+                params.push_back("x");
+                params.push_back("-3");
+                break;
+            case 3:
+                params.push_back("abc");
+                break;
+            }
+        }
+        for (size_t i = 0; i < params.size(); i++)
+        {
+            argv.push_back(const_cast<char*>(params[i].c_str()));
+        }
+    }
+
+    std::vector<std::string> params;
+    std::vector<char*> argv;
+};
+
+TEST_CASE("perf: adding options", "cost per option should be constant and within the baseline")
+{
+    const size_t small = 500;
+    const size_t big = 4000;
+    double allocs[2];
+    double bytes[2];
+    for (int i = 0; i < 2; i++)
+    {
+        size_t n = i ? big : small;
+        allocation_counter counter;
+        {
+            cmd_line_parser parser;
+            add_options(parser, n);
+        }
+        allocs[i] = counter.allocations_per(n);
+        bytes[i] = counter.bytes_per(n);
+    }
+    std::cout << "adding options: allocations per option: " << allocs[1];
+    std::cout << ", bytes per option: " << bytes[1] << std::endl;
+
+    REQUIRE(allocs[1] <= PERF_ADD_OPTION_ALLOCATIONS * (1 + PERF_TOLERANCE));
+    REQUIRE(bytes[1] <= PERF_ADD_OPTION_BYTES * (1 + PERF_TOLERANCE));
+    REQUIRE(allocs[1] <= allocs[0] * (1 + PERF_TOLERANCE));
+    REQUIRE(bytes[1] <= bytes[0] * (1 + PERF_TOLERANCE) * 1.5); // (tables are growing in steps)
+}
+
+TEST_CASE("perf: parsing", "cost per argument should be constant and within the baseline")
+{
+    const size_t small = 100;
+    const size_t big = 2000;
+    double allocs[2];
+    double bytes[2];
+    for (int i = 0; i < 2; i++)
+    {
+        size_t n = i ? big : small;
+        cmd_line_parser parser;
+        add_options(parser, 8);
+        long_cmd_line cmd_line(n);
+
+        allocation_counter counter;
+        REQUIRE(parser.run(cmd_line.argv.size(), &cmd_line.argv[0]));
+        allocs[i] = counter.allocations_per(n);
+        bytes[i] = counter.bytes_per(n);
+    }
+    std::cout << "parsing: allocations per argument: " << allocs[1];
+    std::cout << ", bytes per argument: " << bytes[1] << std::endl;
+
+    REQUIRE(allocs[1] <= PERF_PARSE_ARG_ALLOCATIONS * (1 + PERF_TOLERANCE));
+    REQUIRE(bytes[1] <= PERF_PARSE_ARG_BYTES * (1 + PERF_TOLERANCE));
+    REQUIRE(allocs[1] <= allocs[0] * (1 + PERF_TOLERANCE));
+    REQUIRE(bytes[1] <= bytes[0] * (1 + PERF_TOLERANCE) * 1.5);
+}
+
+TEST_CASE("perf: parsing repeatedly", "once buffers have grown, parsing should not allocate")
+{
+    cmd_line_parser parser;
+    add_options(parser, 8);
+    long_cmd_line cmd_line(200);
+    long_cmd_line other_cmd_line(50);
+    for (int i = 0; i < 2; i++) // (buffers grow here)
+    {
+        REQUIRE(parser.parse(other_cmd_line.argv.size(), &other_cmd_line.argv[0]));
+        REQUIRE(parser.run(cmd_line.argv.size(), &cmd_line.argv[0]));
+    }
+
+    const size_t repeats = 100;
+    bool all_valid = true;
+    allocation_counter counter; // (note, that REQUIRE() allocates itself)
+    for (size_t i = 0; i < repeats; i++)
+    {
+        all_valid &= parser.parse(other_cmd_line.argv.size(), &other_cmd_line.argv[0]);
+        all_valid &= parser.run(cmd_line.argv.size(), &cmd_line.argv[0]);
+    }
+    double allocs = counter.allocations_per(repeats);
+    double bytes = counter.bytes_per(repeats);
+    std::cout << "parsing repeatedly: allocations per run: " << allocs;
+    std::cout << ", bytes per run: " << bytes << std::endl;
+
+    REQUIRE(all_valid);
+    REQUIRE(allocs == 0);
+    REQUIRE(parser.all_specified_option_names().size() == 200); // (i.e. not accumulated)
+}
+
+/**
+ * @brief Key, that counts how many times keys were compared.
+ */
+struct counted_key
+{
+    counted_key(const std::string& k) :
+        key(k)
+    {
+    }
+
+    bool operator<(const counted_key& other) const
+    {
+        comparisons++;
+        return key < other.key;
+    }
+
+    std::string key;
+    static size_t comparisons;
+};
+
+size_t counted_key::comparisons = 0;
+
+std::ostream& operator<<(std::ostream& out, const counted_key& k)
+{
+    return out << k.key;
+}
+
+TEST_CASE("perf: alias_map find", "comparisons per look-up should not grow (much) with the size")
+{
+    const size_t small = 1000;
+    const size_t big = 16000;
+    double per_find[2];
+    for (int i = 0; i < 2; i++)
+    {
+        size_t n = i ? big : small;
+        alias_map<counted_key, int> m;
+        std::vector<counted_key> keys;
+        for (size_t k = 0; k < n; k++)
+        {
+            std::stringstream s;
+            s << "key_" << k;
+            m.add_object(s.str(), static_cast<int>(k));
+            m.add_alias(s.str(), s.str() + "_alias");
+            keys.push_back(s.str() + "_alias");
+        }
+
+        bool all_found = true;
+        counted_key::comparisons = 0;
+        for (size_t k = 0; k < keys.size(); k++)
+        {
+            all_found &= m.find(keys[k]) != m.end();
+        }
+        REQUIRE(all_found);
+        per_find[i] = static_cast<double>(counted_key::comparisons) / n;
+    }
+    std::cout << "alias_map: find with " << big << " items takes " << per_find[1];
+    std::cout << " comparisons, with " << small << ": " << per_find[0] << std::endl;
+
+    // logarithmic growth is expected (i.e. ~1.4 times more here), linear would be 16..
+    REQUIRE(per_find[1] <= per_find[0] * 2);
+}
@@ -0,0 +1,26 @@
+/*
+ * test_perf_baseline.h
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  @brief: Baseline for performance tests (test_perf.cpp): number of allocations and
+ *  allocated bytes measured for each of the workloads. Tests fail if measured values
+ *  exceed these by more than PERF_TOLERANCE. If a change makes things better (or it is
+ *  expected to make them worse) - update values below with the ones printed by test_perf.
+ */
+
+#ifndef TEST_PERF_BASELINE_H_
+#define TEST_PERF_BASELINE_H_
+
+#define PERF_TOLERANCE                      0.10
+
+// adding options (mixed number of parameters, aliases and doxygen descriptions)
+#define PERF_ADD_OPTION_ALLOCATIONS         14.27
+#define PERF_ADD_OPTION_BYTES               1091
+
+// parsing the command line (per argument), including latency histograms created for
+// handlers the first time they are executed
+#define PERF_PARSE_ARG_ALLOCATIONS          0.028
+#define PERF_PARSE_ARG_BYTES                174
+
+#endif /* TEST_PERF_BASELINE_H_ */
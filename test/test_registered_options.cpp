@@ -0,0 +1,145 @@
+/*
+ * test_registered_options.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <cmd_line_options.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+
+#ifdef CMD_LINE_OPTIONS_STATIC_REGISTRATION
+
+static int level = 0;
+static std::string output;
+
+void set_level(int new_level)
+{
+    level = new_level;
+}
+
+void set_output(std::string name, int size)
+{
+    std::stringstream s;
+    s << name << ":" << size;
+    output = s.str();
+}
+
+CMD_LINE_OPTION(set_level, "l,--level", "sets the level @param level new level");
+CMD_LINE_OPTION(set_output, "o,--output", "sets output");
+CMD_LINE_OPTION((option2<char, int>), "b", "option b that takes 2 params");
+CMD_LINE_OPTION(option0, "x", "option x"); CMD_LINE_OPTION(option0, "y", "option y (in the same line)");
+
+TEST_CASE("registered options", "options declared with CMD_LINE_OPTION should be added")
+{
+    cmd_line_parser parser;
+    REQUIRE(parser.add_registered_options() == 5);
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--level");
+    argv.add_param("3");
+    argv.add_param("o");
+    argv.add_param("file");
+    argv.add_param("12");
+    argv.add_param("b");
+    argv.add_param("x");
+    argv.add_param("5");
+    REQUIRE(parser.run(argv.size(), argv.ptr()));
+    REQUIRE(level == 3);
+    REQUIRE(output == "file:12");
+    REQUIRE(status_manager::get_stored_value<char>(1) == 'x');
+    REQUIRE(status_manager::get_stored_value<int>(2) == 5);
+
+    REQUIRE_THROWS(parser.add_registered_options()); // already added..
+
+    cmd_line_parser parser2;
+    parser2.add_option(option0, "l", "conflicting option");
+    REQUIRE_THROWS(parser2.add_registered_options());
+}
+
+#endif /* CMD_LINE_OPTIONS_STATIC_REGISTRATION */
+
+static std::vector<int> table_calls;
+
+void table_option(int value)
+{
+    table_calls.push_back(value);
+}
+
+void table_flag()
+{
+    table_calls.push_back(-1);
+}
+
+static const cmd_line_option_entry table[] = {
+    {"-n,--number", "@brief takes a number @param n number", cmd_line_option_adder<void (*)(int), table_option>,
+     "Numbers", NULL, NULL},
+    {"-f,--flag", "a flag", cmd_line_option_adder<void (*)(), table_flag>, NULL, "-n", NULL},
+    {"-g", "another flag", cmd_line_option_adder<void (*)(), table_flag>, "Flags", NULL, "-f"},
+    {"b", "option b that takes 2 params", cmd_line_option_adder<void (*)(char, int), option2<char, int> >,
+     NULL, NULL, NULL},
+};
+
+TEST_CASE("table of options", "all options from the table should be added at once")
+{
+    cmd_line_parser parser;
+    option_handle a = parser.add_option(option0, "-a", "option added before");
+    REQUIRE(parser.add_options(table) == 4);
+    REQUIRE_NOTHROW(parser.setup_option_add_required(a, parser.add_option(option0, "-c", "option added after")));
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--flag");
+    int param_id = argv.add_param("-n");
+    argv.add_param("3");
+    table_calls.clear();
+    REQUIRE(parser.run(argv.size(), argv.ptr()));
+    REQUIRE(table_calls.size() == 2);
+    REQUIRE(table_calls[0] == -1);
+    REQUIRE(table_calls[1] == 3);
+
+    REQUIRE_FALSE(parser.parse(2, argv.ptr())); // -f requires -n
+    argv.update_param(param_id, "-g");
+    REQUIRE_FALSE(parser.parse(3, argv.ptr())); // -g can't be used with -f
+
+    std::stringstream out;
+    std::streambuf* prev = std::cout.rdbuf(out.rdbuf());
+    argv.update_param(param_id, "--help");
+    parser.run(3, argv.ptr());
+    std::cout.rdbuf(prev);
+    REQUIRE(out.str().find("Numbers") < out.str().find("--number"));
+    REQUIRE(out.str().find("Flags") < out.str().find("-g"));
+
+    // names are not unique: none of options is added
+    cmd_line_parser parser2;
+    parser2.add_option(option0, "--flag", "conflicting option");
+    REQUIRE_THROWS(parser2.add_options(table));
+    REQUIRE_NOTHROW(parser2.add_option(option0, "-n", "option that is not conflicting now"));
+
+    static const cmd_line_option_entry duplicates[] = {
+        {"x,y", "x", cmd_line_option_adder<void (*)(), table_flag>, NULL, NULL, NULL},
+        {"z,x", "z", cmd_line_option_adder<void (*)(), table_flag>, NULL, NULL, NULL},
+    };
+    cmd_line_parser parser3;
+    REQUIRE_THROWS(parser3.add_options(duplicates));
+    REQUIRE(parser3.add_options(duplicates, 1) == 1);
+
+    // dependencies are not valid: none of options is added
+    static const cmd_line_option_entry typos[] = {
+        {"x", "x", cmd_line_option_adder<void (*)(), table_flag>, NULL, "y", NULL},
+        {"y", "y", cmd_line_option_adder<void (*)(), table_flag>, NULL, NULL, "-a, -typo"},
+    };
+    cmd_line_parser parser4;
+    parser4.add_option(option0, "-a", "option added before");
+    REQUIRE_THROWS(parser4.add_options(typos));
+    REQUIRE_NOTHROW(parser4.add_option(option0, "x", "option that is not conflicting now"));
+    REQUIRE_NOTHROW(parser4.add_option(option0, "y", "option that is not conflicting now"));
+    REQUIRE_NOTHROW(parser4.setup_check_dependencies());
+}
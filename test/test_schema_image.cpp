@@ -0,0 +1,259 @@
+/*
+ * test_schema_image.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdio.h>
+#include <cmd_line_options.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+static const char* cache_file = "test_schema_image.cache";
+
+static void define_options(cmd_line_parser& parser, bool with_extra_option = false)
+{
+    parser.add_group("First group", "with description");
+    parser.add_option(option0, "-a,option_a", "option a");
+    parser.add_option(option1<int>, "int,-i",
+                      "@brief option that takes int. @param num some number.");
+    parser.add_group("Second group");
+    parser.add_option(option2<char, int>, "b", "option b that takes 2 params");
+    parser.add_option(option0, "standalone", "option that must be used alone");
+    if (with_extra_option)
+    {
+        parser.add_option(option1<std::string>, "extra", "option added later");
+    }
+    parser.setup_option_add_required("b", "-a");
+    parser.setup_option_add_not_wanted("int", "b");
+    parser.setup_option_as_standalone("standalone");
+}
+
+static std::string help_of(cmd_line_parser& parser)
+{
+    std::stringstream out;
+    std::streambuf* prev = std::cout.rdbuf(out.rdbuf());
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("--help");
+    parser.run(argv.size(), argv.ptr());
+    std::cout.rdbuf(prev);
+    return out.str();
+}
+
+TEST_CASE("name index", "should find all names it holds")
+{
+    name_index index;
+    REQUIRE(index.find("abc") == NULL);
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; i++)
+    {
+        std::stringstream s;
+        s << "name_" << i;
+        names.push_back(s.str());
+        REQUIRE(index.insert(s.str().data(), s.str().size(), i));
+    }
+    REQUIRE_FALSE(index.insert("name_10", 7, 1234)); // exists already
+    REQUIRE(index.size() == 1000);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        const name_index_slot* slot = index.find(names[i]);
+        REQUIRE(slot != NULL);
+        REQUIRE(slot->id == static_cast<uint32_t>(i));
+    }
+    REQUIRE(index.find("name_1000") == NULL);
+    REQUIRE(index.find("name_") == NULL);
+}
+
+TEST_CASE("schema cache", "image is created on first run and used afterwards")
+{
+    if (schema_image_build_id().empty())
+    {
+        WARN("no build-id for this binary, schema cache can't be used");
+        return;
+    }
+    remove(cache_file);
+
+    my_argv argv;
+    argv.add_param(program_name);
+    argv.add_param("b");
+    argv.add_param("x");
+    argv.add_param("12");
+    argv.add_param("-a");
+
+    std::string help_without_cache;
+    {
+        cmd_line_parser parser;
+        define_options(parser);
+        help_without_cache = help_of(parser);
+    }
+
+    {
+        cmd_line_parser parser;
+        REQUIRE_FALSE(parser.use_schema_cache(cache_file));
+        define_options(parser);
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+    }
+
+    {
+        cmd_line_parser parser;
+        REQUIRE(parser.use_schema_cache(cache_file));
+        define_options(parser);
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+        REQUIRE(status_manager::get_stored_value<char>(1) == 'x');
+        REQUIRE(status_manager::get_stored_value<int>(2) == 12);
+        REQUIRE(help_of(parser) == help_without_cache);
+    }
+
+    {
+        // dependencies are restored from the image
+        cmd_line_parser parser;
+        REQUIRE(parser.use_schema_cache(cache_file));
+        define_options(parser);
+
+        my_argv other;
+        other.add_param(program_name);
+        int param_id = other.add_param("b");
+        other.add_param("y");
+        other.add_param("3");
+        REQUIRE_FALSE(parser.run(other.size(), other.ptr())); // requires -a
+
+        other.update_param(param_id, "standalone");
+        other.update_param(param_id + 1, "-i");
+        REQUIRE_FALSE(parser.run(other.size(), other.ptr())); // standalone
+
+        other.update_param(param_id, "-a");
+        other.update_param(param_id + 1, "int");
+        REQUIRE(parser.run(other.size(), other.ptr()));
+    }
+
+    {
+        // same options, but set-up differently: image is not used
+        cmd_line_parser parser;
+        REQUIRE(parser.use_schema_cache(cache_file));
+        define_options(parser);
+        parser.setup_option_add_not_wanted("-a", "int");
+
+        my_argv other;
+        other.add_param(program_name);
+        other.add_param("-a");
+        REQUIRE(parser.run(other.size(), other.ptr()));
+        other.add_param("int");
+        other.add_param("3");
+        REQUIRE_FALSE(parser.run(other.size(), other.ptr())); // (-a and int)
+    }
+
+    {
+        // different schema: image is stale, it is dropped and re-created.
+        cmd_line_parser parser;
+        REQUIRE(parser.use_schema_cache(cache_file));
+        define_options(parser, true);
+
+        my_argv other;
+        other.add_param(program_name);
+        other.add_param("extra");
+        other.add_param("abc");
+        REQUIRE(parser.run(other.size(), other.ptr()));
+        REQUIRE(status_manager::get_stored_value<std::string>(1) == "abc");
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+    }
+
+    {
+        cmd_line_parser parser;
+        REQUIRE(parser.use_schema_cache(cache_file));
+        define_options(parser); // .. and it is stale again
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+        REQUIRE(help_of(parser) == help_without_cache);
+    }
+
+    {
+        FILE* f = fopen(cache_file, "r+b");
+        REQUIRE(f != NULL);
+        fseek(f, sizeof(schema_image_header) + 3, SEEK_SET);
+        fputc(0xff, f);
+        fclose(f);
+
+        cmd_line_parser parser;
+        REQUIRE_FALSE(parser.use_schema_cache(cache_file)); // corrupted
+        define_options(parser);
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+    }
+
+    {
+        cmd_line_parser parser;
+        define_options(parser);
+        REQUIRE_THROWS(parser.use_schema_cache(cache_file)); // options were added already
+    }
+    remove(cache_file);
+}
+
+static std::vector<std::string> table_calls;
+
+void table_t0()
+{
+    table_calls.push_back("--t0");
+}
+
+void table_t1()
+{
+    table_calls.push_back("--t1");
+}
+
+void table_new()
+{
+    table_calls.push_back("--new");
+}
+
+TEST_CASE("schema cache and a table of options", "options that can't be added should be forgotten")
+{
+    if (schema_image_build_id().empty())
+    {
+        WARN("no build-id for this binary, schema cache can't be used");
+        return;
+    }
+    remove(cache_file);
+
+    static const cmd_line_option_entry cached[] = {
+        {"--t0", "t0", cmd_line_option_adder<void (*)(), table_t0>, NULL, NULL, NULL},
+        {"--t1", "t1", cmd_line_option_adder<void (*)(), table_t1>, NULL, NULL, NULL},
+    };
+    static const cmd_line_option_entry duplicates[] = {
+        {"--t0", "t0", cmd_line_option_adder<void (*)(), table_t0>, NULL, NULL, NULL},
+        {"--zz", "zz", cmd_line_option_adder<void (*)(), table_t1>, NULL, NULL, NULL},
+        {"--zz", "zz", cmd_line_option_adder<void (*)(), table_t1>, NULL, NULL, NULL},
+    };
+
+    my_argv argv;
+    argv.add_param(program_name);
+    int param_id = argv.add_param("--t0");
+    {
+        cmd_line_parser parser;
+        REQUIRE_FALSE(parser.use_schema_cache(cache_file));
+        REQUIRE(parser.add_options(cached) == 2);
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+    }
+
+    {
+        // options are added one by one (i.e. names are indexed), until one isn't in the image
+        cmd_line_parser parser;
+        REQUIRE(parser.use_schema_cache(cache_file));
+        REQUIRE_THROWS(parser.add_options(duplicates));
+        REQUIRE_NOTHROW(parser.add_option(table_new, "--new", "option added after"));
+
+        table_calls.clear();
+        REQUIRE_FALSE(parser.run(argv.size(), argv.ptr())); // (--t0 was not added)
+        REQUIRE(table_calls.empty());
+        argv.update_param(param_id, "--new");
+        REQUIRE(parser.run(argv.size(), argv.ptr()));
+        REQUIRE(table_calls.size() == 1);
+        REQUIRE(table_calls[0] == "--new");
+    }
+    remove(cache_file);
+}
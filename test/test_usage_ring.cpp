@@ -0,0 +1,169 @@
+/*
+ * test_usage_ring.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cmd_line_options.h>
+#include <usage_ring.h>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+static const char* program_name = "some/path/program/name";
+static const char* ring_file = "test_usage_ring.ring";
+
+static void define_options(cmd_line_parser& parser)
+{
+    parser.add_option(option0, "-a,option_a", "option a");
+    parser.add_option(option1<int>, "-i,int", "option that takes int");
+    parser.add_option(option0, "b", "option b");
+    parser.setup_option_add_required("b", "-a");
+}
+
+TEST_CASE("usage ring", "runs should be recorded and summarized")
+{
+    remove(ring_file);
+    cmd_line_parser parser;
+    define_options(parser);
+    {
+        usage_ring ring;
+        REQUIRE(ring.open(ring_file, 16));
+
+        my_argv argv;
+        argv.add_param(program_name);
+        int param_id = argv.add_param("-a");
+        argv.add_param("int");
+        argv.add_param("1");
+        argv.add_param("-i");
+        argv.add_param("2");
+        REQUIRE(ring.record(parser, parser.run(argv.size(), argv.ptr())));
+        REQUIRE(parser.last_parse_duration_ns() > 0);
+
+        std::vector<uint32_t> ids;
+        parser.specified_option_ids(ids);
+        REQUIRE(ids.size() == 3);
+        REQUIRE(parser.option_name(ids[0]) == "-a,option_a");
+        REQUIRE(parser.option_name(ids[1]) == "-i,int");
+        REQUIRE(parser.option_name(1234) == "");
+
+        argv.update_param(param_id, "b"); // (requires -a)
+        REQUIRE(ring.record(parser, parser.run(argv.size(), argv.ptr())));
+    }
+
+    usage_ring ring;
+    REQUIRE(ring.open(ring_file, 0));
+    std::vector<usage_record> records;
+    REQUIRE(ring.read(records) == 0);
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].sequence == 1);
+    REQUIRE(records[0].valid == 1);
+    REQUIRE(records[0].options == 2);
+    REQUIRE(records[0].counts[1] == 2); // int
+    REQUIRE(records[1].valid == 0);
+    REQUIRE(records[1].options == 0);
+
+    std::vector<usage_summary> summaries;
+    summarize_usage(records, summaries);
+    REQUIRE(summaries.size() == 1);
+    REQUIRE(summaries[0].fingerprint == parser.schema_fingerprint());
+    REQUIRE(summaries[0].runs == 2);
+    REQUIRE(summaries[0].failed == 1);
+    REQUIRE(summaries[0].options.size() == 2);
+    REQUIRE(summaries[0].options[1].occurrences == 2);
+    REQUIRE(summaries[0].patterns.size() == 2);
+
+    std::stringstream out;
+    print_usage_summary(out, summaries[0], &parser);
+    std::cout << out.str();
+    REQUIRE(out.str().find("[-a,option_a -i,int]: 1") != std::string::npos);
+    remove(ring_file);
+}
+
+TEST_CASE("usage ring wraps", "oldest records should be overwritten")
+{
+    remove(ring_file);
+    usage_ring ring;
+    REQUIRE_FALSE(ring.open(ring_file, 0)); // (it doesn't exist)
+    REQUIRE(ring.open(ring_file, 8));
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        usage_record r;
+        memset(&r, 0, sizeof(r));
+        r.fingerprint = i;
+        REQUIRE(ring.append(r));
+    }
+
+    usage_ring other;
+    REQUIRE(other.open(ring_file)); // (existing one is used, capacity is not changed)
+    std::vector<usage_record> records;
+    REQUIRE(other.read(records) == 0);
+    REQUIRE(records.size() == 8);
+    REQUIRE(records[0].sequence == 13);
+    REQUIRE(records[0].fingerprint == 12);
+    REQUIRE(records[7].fingerprint == 19);
+
+    FILE* f = fopen(ring_file, "r+b");
+    REQUIRE(f != NULL);
+    fputc('x', f);
+    fclose(f);
+    REQUIRE_FALSE(other.open(ring_file)); // not a ring
+    remove(ring_file);
+}
+
+TEST_CASE("usage ring shared by processes", "concurrent appends should not be lost")
+{
+    remove(ring_file);
+    const int processes = 4;
+    const uint32_t per_process = 500;
+    usage_ring ring;
+    REQUIRE(ring.open(ring_file, processes * per_process));
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < processes; p++)
+    {
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0)
+        {
+            usage_ring own;
+            bool ok = own.open(ring_file);
+            for (uint32_t i = 0; ok && i < per_process; i++)
+            {
+                usage_record r;
+                memset(&r, 0, sizeof(r));
+                r.fingerprint = p;
+                r.parse_ns = i;
+                ok = own.append(r);
+            }
+            _exit(ok ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        int status = 0;
+        REQUIRE(waitpid(children[i], &status, 0) == children[i]);
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(WEXITSTATUS(status) == 0);
+    }
+
+    std::vector<usage_record> records;
+    REQUIRE(ring.read(records) == 0);
+    REQUIRE(records.size() == processes * per_process);
+    std::vector<uint32_t> next(processes, 0);
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        REQUIRE(records[i].sequence == i + 1);
+        uint32_t p = records[i].fingerprint;
+        REQUIRE(p < static_cast<uint32_t>(processes));
+        REQUIRE(records[i].parse_ns == next[p]++); // (in order for each of processes)
+    }
+    remove(ring_file);
+}
@@ -0,0 +1,168 @@
+/*
+ * test_zygote.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "test_generic.h"
+
+#include <stdio.h>
+#include <cmd_line_options.h>
+#include <zygote.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "test_options_definitions.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+static const char* socket_path = "test_zygote.sock";
+static const char* output_file = "test_zygote.out";
+
+static void print_value(int value)
+{
+    std::cout << "value: " << value << std::endl;
+}
+
+static void exit_with(int code)
+{
+    std::cout.flush();
+    exit(code);
+}
+
+static void sleep_ms(int milliseconds)
+{
+    usleep(milliseconds * 1000);
+}
+
+static std::string run_in_zygote(my_argv& argv, int& status)
+{
+    int out = open(output_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(out >= 0);
+    int stdio[3] = {0, out, out};
+    status = cmd_line_zygote_call(socket_path, argv.size(), argv.ptr(), stdio);
+    close(out);
+
+    std::ifstream f(output_file);
+    std::stringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+/**
+ * @brief Forks the zygote, that serves given number of requests and exits.
+ */
+static pid_t start_zygote(size_t requests)
+{
+    remove(socket_path);
+    std::cout.flush();
+    pid_t zygote_pid = fork();
+    REQUIRE(zygote_pid >= 0);
+    if (zygote_pid == 0)
+    {
+        alarm(30); // (don't outlive the test, if it fails before all requests are sent)
+        cmd_line_parser parser;
+        parser.add_option(print_value, "value", "prints the value");
+        parser.add_option(exit_with, "exit", "exits with given code");
+        parser.add_option(sleep_ms, "sleep", "sleeps for given time (in ms)");
+        cmd_line_zygote zygote(parser);
+        zygote.set_request_timeout(200);
+        bool ok = zygote.listen(socket_path) && zygote.serve(requests);
+        zygote.close();
+        _exit(ok ? 0 : 1);
+    }
+
+    for (int i = 0; i < 500 && access(socket_path, F_OK) != 0; i++)
+    {
+        usleep(10000);
+    }
+    return zygote_pid;
+}
+
+static void require_exited(pid_t zygote_pid)
+{
+    int zygote_status = -1;
+    REQUIRE(waitpid(zygote_pid, &zygote_status, 0) == zygote_pid);
+    REQUIRE(WIFEXITED(zygote_status));
+    REQUIRE(WEXITSTATUS(zygote_status) == 0);
+    REQUIRE(access(socket_path, F_OK) != 0);
+}
+
+TEST_CASE("zygote", "command lines forwarded to the zygote are run in its children")
+{
+    my_argv argv;
+    argv.add_param("program");
+    int param_id = argv.add_param("value");
+    argv.add_param("12");
+
+    int status = 0;
+    remove(socket_path);
+    REQUIRE(cmd_line_zygote_call(socket_path, argv.size(), argv.ptr()) == -1); // no zygote yet
+
+    pid_t zygote_pid = start_zygote(4);
+    REQUIRE(run_in_zygote(argv, status) == "value: 12\n");
+    REQUIRE(status == 0);
+
+    argv.update_param(param_id + 1, "abc");
+    REQUIRE(run_in_zygote(argv, status).find("abc") != std::string::npos);
+    REQUIRE(status == 1);
+
+    argv.update_param(param_id, "exit");
+    argv.update_param(param_id + 1, "7");
+    run_in_zygote(argv, status);
+    REQUIRE(status == 7);
+
+    argv.update_param(param_id, "value");
+    argv.update_param(param_id + 1, "-1");
+    REQUIRE(run_in_zygote(argv, status) == "value: -1\n");
+    REQUIRE(status == 0);
+
+    require_exited(zygote_pid);
+    remove(output_file);
+}
+
+TEST_CASE("zygote and bad clients", "stalled or disappearing clients should not stop the zygote")
+{
+    pid_t zygote_pid = start_zygote(3);
+
+    // client that connects, but doesn't send the request (zygote gives up on it)
+    sockaddr_un addr;
+    REQUIRE(zygote_io::fill_address(addr, socket_path));
+    int stalled = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(stalled >= 0);
+    REQUIRE(connect(stalled, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+    // client that is gone before its status is sent back (it must not raise SIGPIPE)
+    std::cout.flush();
+    pid_t client_pid = fork();
+    REQUIRE(client_pid >= 0);
+    if (client_pid == 0)
+    {
+        my_argv argv;
+        argv.add_param("program");
+        argv.add_param("sleep");
+        argv.add_param("500");
+        int out = open("/dev/null", O_WRONLY);
+        int stdio[3] = {0, out, out};
+        _exit(cmd_line_zygote_call(socket_path, argv.size(), argv.ptr(), stdio) == 0 ? 0 : 1);
+    }
+    usleep(400 * 1000); // (request is received by now, but its child is still sleeping)
+    kill(client_pid, SIGKILL);
+    waitpid(client_pid, NULL, 0);
+    usleep(300 * 1000);
+
+    my_argv argv;
+    argv.add_param("program");
+    argv.add_param("value");
+    argv.add_param("3");
+    int status = 0;
+    REQUIRE(run_in_zygote(argv, status) == "value: 3\n");
+    REQUIRE(status == 0);
+    close(stalled);
+
+    require_exited(zygote_pid);
+    remove(output_file);
+}
+
+#endif
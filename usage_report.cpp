@@ -0,0 +1,33 @@
+/*
+ * usage_report.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *
+ *  @brief Reads rings of usage records (see usage_ring.h) and prints which options (and
+ *         sets of them) were used, how often, and how long it took to parse command lines.
+ *         Options are reported by their ids, i.e. in the order they were added to the parser.
+ */
+
+#include "usage_ring.h"
+
+int main(int argc, char **argv)
+{
+    return usage_report_main(argc, argv);
+}
+
+/* Example outputs:
+ ____________________________________
+
+ ~$ ./usage_report /var/tmp/example2.usage
+schema: 0x8b77806c, runs: 4 (failed: 1), parse latency [ns]: p50: 32825, p90: 58584, p99: 58584, max: 118476
+ options (runs, occurrences):
+  #0: 3, 3
+  #1: 1, 1
+  #2: 1, 1
+ patterns (runs):
+  []: 1
+  [#0]: 2
+  [#0 #1 #2]: 1
+4 run(s) read
+ ____________________________________
+*/
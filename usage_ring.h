@@ -0,0 +1,530 @@
+/**
+ * @file   usage_ring.h
+ * @date   17 Oct 2026
+ * @brief  Opt-in telemetry of options that are used: each run of the parser can append
+ *         a (fixed-size) record to a ring, that is a file memory-mapped and shared by
+ *         all processes using it. Records can be read and aggregated later.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef USAGE_RING_H_
+#define USAGE_RING_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iostream>
+#include "cmd_line_options.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && defined(__GNUC__)
+#define USAGE_RING_USE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Record of a single run of the parser. Values are stored in the native byte order.
+ */
+struct usage_record
+{
+    enum constants
+    {
+        max_options = 14,   // different options stored in a record (others are only counted)
+        other_id = 0xffff   // (for options with ids that don't fit in ids)
+    };
+
+    uint64_t sequence;      // number of the record + 1, (0 while the record is being written)
+    uint32_t fingerprint;   // of the schema (see cmd_line_parser::schema_fingerprint())
+    uint32_t parse_ns;      // how long parsing took (saturated)
+    uint16_t valid;         // 1 if the command line was valid
+    uint16_t options;       // number of different options specified
+    uint16_t ids[max_options];
+    uint8_t counts[max_options]; // (number of occurrences of each of them, saturated)
+    uint16_t reserved;
+};
+
+/**
+ * @brief Header of the ring file. It is followed by 'capacity' records.
+ */
+struct usage_ring_header
+{
+    enum constants
+    {
+        ring_magic = 0x52554c43, // "CLUR"
+        ring_version = 1
+    };
+
+    uint32_t magic;         // (written last, once the ring is initialised)
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint64_t next;          // number of records appended so far (incremented atomically)
+    uint64_t reserved[5];
+};
+
+/**
+ * @brief Ring of usage records in a shared, memory-mapped file. Telemetry is opt-in:
+ *        the program has to open the ring and record each run, e.g.:
+ *
+ * @code
+ *  usage_ring ring;
+ *  ring.open("/var/tmp/my_tool.usage");
+ *  bool result = parser.run(argc, argv);
+ *  ring.record(parser, result);
+ * @endcode
+ *
+ *        Appending does not take any locks: a slot is claimed by atomically incrementing
+ *        the counter in the header, so that concurrent processes never block each other.
+ *        Once the ring is full, oldest records are overwritten. The ring is available only
+ *        on POSIX systems (and with GCC-compatible compilers), elsewhere open() returns false.
+ */
+class usage_ring
+{
+public:
+    usage_ring() :
+                    header(NULL),
+                    records(NULL),
+                    mapped_size(0)
+    {
+    }
+
+    ~usage_ring()
+    {
+        close();
+    }
+
+    /**
+     * @brief Opens the ring, or creates it if it doesn't exist.
+     * @param path - location of the ring file.
+     * @param capacity - number of records in the ring (if it is created), if 0 - the ring
+     *        is not created (i.e. it is only opened if it exists).
+     * @return true if successful (i.e. runs can be recorded).
+     */
+    bool open(const std::string& path, uint32_t capacity = 64 * 1024)
+    {
+        close();
+#ifdef USAGE_RING_USE_MMAP
+        size_t size = sizeof(usage_ring_header) + capacity * sizeof(usage_record);
+        bool created = capacity > 0;
+        int fd = created ? ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644) : -1;
+        if (fd < 0)
+        {
+            created = false;
+            fd = ::open(path.c_str(), O_RDWR);
+        }
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat st;
+        bool ok = created ? ftruncate(fd, size) == 0 : fstat(fd, &st) == 0;
+        if (ok && !created)
+        {
+            size = st.st_size;
+            ok = size >= sizeof(usage_ring_header);
+        }
+        void* m = ok ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (m == MAP_FAILED)
+        {
+            return false;
+        }
+        header = static_cast<usage_ring_header*>(m);
+        records = reinterpret_cast<usage_record*>(header + 1);
+        mapped_size = size;
+
+        if (created)
+        {
+            header->version = usage_ring_header::ring_version;
+            header->record_size = sizeof(usage_record);
+            header->capacity = capacity;
+            header->next = 0;
+            __sync_synchronize();
+            header->magic = usage_ring_header::ring_magic;
+        }
+        else if (!is_valid(header, size))
+        {
+            close(); // (not a ring, or it's being created just now)
+        }
+        return header != NULL;
+#else
+        return false;
+#endif
+    }
+
+    void close()
+    {
+#ifdef USAGE_RING_USE_MMAP
+        if (header != NULL)
+        {
+            munmap(header, mapped_size);
+        }
+#endif
+        header = NULL;
+        records = NULL;
+        mapped_size = 0;
+    }
+
+    bool is_open() const
+    {
+        return header != NULL;
+    }
+
+    /**
+     * @brief Records options specified in the last command line parsed (see run()), and
+     *        how long it took to parse it.
+     * @param result - what run() returned.
+     * @return true if the record was appended.
+     */
+    bool record(cmd_line_parser& parser, bool result)
+    {
+        if (!is_open())
+        {
+            return false;
+        }
+        parser.specified_option_ids(ids);
+
+        usage_record r;
+        memset(&r, 0, sizeof(r));
+        r.fingerprint = parser.schema_fingerprint(); // (the parser caches it)
+        uint64_t ns = parser.last_parse_duration_ns();
+        r.parse_ns = ns > 0xffffffffu ? 0xffffffffu : static_cast<uint32_t>(ns);
+        r.valid = result ? 1 : 0;
+
+        std::sort(ids.begin(), ids.end());
+        for (size_t i = 0; i < ids.size();)
+        {
+            size_t same = i;
+            while (same < ids.size() && ids[same] == ids[i])
+            {
+                same++;
+            }
+            if (r.options < usage_record::max_options)
+            {
+                r.ids[r.options] = static_cast<uint16_t>(std::min<uint32_t>(ids[i], usage_record::other_id));
+                r.counts[r.options] = same - i > 0xff ? 0xff : static_cast<uint8_t>(same - i);
+            }
+            r.options++;
+            i = same;
+        }
+        return append(r);
+    }
+
+    /**
+     * @brief Appends the record (its sequence is set here).
+     * @return true if the record was appended.
+     */
+    bool append(usage_record& r)
+    {
+        if (!is_open())
+        {
+            return false;
+        }
+#ifdef USAGE_RING_USE_MMAP
+        uint64_t n = __sync_fetch_and_add(&header->next, 1);
+        usage_record& slot = records[n % header->capacity];
+        slot.sequence = 0;
+        __sync_synchronize();
+        r.sequence = 0;
+        memcpy(&slot, &r, sizeof(r));
+        __sync_synchronize();
+        slot.sequence = n + 1; // (readers ignore the record until this is written)
+        r.sequence = n + 1;
+#endif
+        return true;
+    }
+
+    /**
+     * @brief Copies all complete records from the ring (oldest first).
+     * @param out - records are appended to this vector.
+     * @return number of records that were skipped, i.e. overwritten or being written
+     *         while they were read.
+     */
+    size_t read(std::vector<usage_record>& out) const
+    {
+        size_t skipped = 0;
+        if (!is_open())
+        {
+            return skipped;
+        }
+#ifdef USAGE_RING_USE_MMAP
+        __sync_synchronize();
+        uint64_t next = header->next;
+        uint64_t capacity = header->capacity;
+        uint64_t first = next > capacity ? next - capacity : 0;
+        for (uint64_t n = first; n < next; n++)
+        {
+            const volatile usage_record& slot = records[n % capacity];
+            uint64_t before = slot.sequence;
+            __sync_synchronize();
+            usage_record r;
+            memcpy(&r, const_cast<const usage_record*>(&slot), sizeof(r));
+            __sync_synchronize();
+            if (before != n + 1 || slot.sequence != before)
+            {
+                skipped++;
+                continue;
+            }
+            r.sequence = before;
+            out.push_back(r);
+        }
+#endif
+        return skipped;
+    }
+
+private:
+    usage_ring(const usage_ring&);
+    usage_ring& operator=(const usage_ring&);
+
+    static bool is_valid(const usage_ring_header* h, size_t size)
+    {
+        return h->magic == usage_ring_header::ring_magic &&
+               h->version == usage_ring_header::ring_version &&
+               h->record_size == sizeof(usage_record) &&
+               h->capacity > 0 &&
+               size >= sizeof(usage_ring_header) + h->capacity * sizeof(usage_record);
+    }
+
+    usage_ring_header* header;
+    usage_record* records;
+    size_t mapped_size;
+    std::vector<uint32_t> ids; // (of options specified in the last run)
+};
+
+/**
+ * @brief Usage of a single option, aggregated from records.
+ */
+struct option_usage
+{
+    option_usage() :
+                    runs(0),
+                    occurrences(0)
+    {
+    }
+
+    uint64_t runs;          // in which it was specified
+    uint64_t occurrences;   // (all of them)
+};
+
+/**
+ * @brief Usage of options of a program (i.e. of records of the same schema fingerprint).
+ *        Latencies are in nanoseconds.
+ */
+struct usage_summary
+{
+    usage_summary() :
+                    fingerprint(0),
+                    runs(0),
+                    failed(0),
+                    truncated(0),
+                    p50(0),
+                    p90(0),
+                    p99(0),
+                    max(0)
+    {
+    }
+
+    uint32_t fingerprint;
+    uint64_t runs;
+    uint64_t failed;        // command line was not valid
+    uint64_t truncated;     // more options were specified than a record could hold
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+    std::map<uint32_t, option_usage> options; // (by id)
+    std::map<std::vector<uint16_t>, uint64_t> patterns; // runs, by sets of options specified
+};
+
+/**
+ * @brief Aggregates records, separately for each schema fingerprint.
+ * @param records - as read from the ring (see usage_ring::read()).
+ * @param summaries - results (one for each fingerprint, most frequently used first).
+ */
+inline void summarize_usage(const std::vector<usage_record>& records,
+                            std::vector<usage_summary>& summaries)
+{
+    std::map<uint32_t, size_t> by_fingerprint;
+    std::vector<std::vector<uint64_t> > latencies;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const usage_record& r = records[i];
+        std::map<uint32_t, size_t>::iterator at = by_fingerprint.find(r.fingerprint);
+        if (at == by_fingerprint.end())
+        {
+            at = by_fingerprint.insert(std::make_pair(r.fingerprint, summaries.size())).first;
+            summaries.push_back(usage_summary());
+            summaries.back().fingerprint = r.fingerprint;
+            latencies.push_back(std::vector<uint64_t>());
+        }
+        usage_summary& s = summaries[at->second];
+        s.runs++;
+        s.failed += r.valid ? 0 : 1;
+        s.truncated += r.options > usage_record::max_options ? 1 : 0;
+        latencies[at->second].push_back(r.parse_ns);
+
+        size_t stored = std::min<size_t>(r.options, usage_record::max_options);
+        std::vector<uint16_t> pattern(r.ids, r.ids + stored);
+        for (size_t n = 0; n < stored; n++)
+        {
+            option_usage& u = s.options[r.ids[n]];
+            u.runs++;
+            u.occurrences += r.counts[n];
+        }
+        s.patterns[pattern]++;
+    }
+
+    for (size_t i = 0; i < summaries.size(); i++)
+    {
+        std::vector<uint64_t>& l = latencies[i];
+        std::sort(l.begin(), l.end());
+        summaries[i].p50 = l[(l.size() - 1) * 50 / 100];
+        summaries[i].p90 = l[(l.size() - 1) * 90 / 100];
+        summaries[i].p99 = l[(l.size() - 1) * 99 / 100];
+        summaries[i].max = l.back();
+    }
+
+    // (stable: for the same number of runs - order in which they were found)
+    for (size_t i = 1; i < summaries.size(); i++)
+    {
+        for (size_t n = i; n > 0 && summaries[n - 1].runs < summaries[n].runs; n--)
+        {
+            std::swap(summaries[n - 1], summaries[n]);
+        }
+    }
+}
+
+/**
+ * @brief Prints the summary. Options are printed by their ids, unless the parser (with
+ *        the same schema) is specified: then their names are used.
+ */
+inline void print_usage_summary(std::ostream& out, const usage_summary& s,
+                                cmd_line_parser* parser = NULL)
+{
+    if (parser != NULL && parser->schema_fingerprint() != s.fingerprint)
+    {
+        parser = NULL;
+    }
+
+    out << "schema: 0x" << std::hex << s.fingerprint << std::dec;
+    out << ", runs: " << s.runs << " (failed: " << s.failed << ")";
+    out << ", parse latency [ns]: p50: " << s.p50 << ", p90: " << s.p90;
+    out << ", p99: " << s.p99 << ", max: " << s.max << "\n";
+
+    out << " options (runs, occurrences):\n";
+    std::map<uint32_t, option_usage>::const_iterator o;
+    for (o = s.options.begin(); o != s.options.end(); o++)
+    {
+        out << "  ";
+        if (parser != NULL && o->first != usage_record::other_id)
+        {
+            out << parser->option_name(o->first);
+        }
+        else
+        {
+            out << "#" << o->first;
+        }
+        out << ": " << o->second.runs << ", " << o->second.occurrences << "\n";
+    }
+
+    out << " patterns (runs):\n";
+    std::map<std::vector<uint16_t>, uint64_t>::const_iterator p;
+    for (p = s.patterns.begin(); p != s.patterns.end(); p++)
+    {
+        out << "  [";
+        for (size_t i = 0; i < p->first.size(); i++)
+        {
+            out << (i ? " " : "");
+            if (parser != NULL && p->first[i] != usage_record::other_id)
+            {
+                out << parser->option_name(p->first[i]);
+            }
+            else
+            {
+                out << "#" << p->first[i];
+            }
+        }
+        out << "]: " << p->second << "\n";
+    }
+    if (s.truncated)
+    {
+        out << " (" << s.truncated << " runs specified more than ";
+        out << usage_record::max_options << " options, others were not recorded)\n";
+    }
+}
+
+/**
+ * @brief Main function of a tool reporting usage recorded in rings (see usage_report.cpp).
+ *        Paths of rings are given as arguments, records of all of them are aggregated.
+ * @param parser - if specified (and it has the same schema as recorded runs), options are
+ *        reported by their names.
+ * @return 0 if all rings were read, 1 if any of them can't be opened, 2 if no path was given.
+ */
+inline int usage_report_main(int argc, char** argv, cmd_line_parser* parser = NULL,
+                             std::ostream& out = std::cout)
+{
+    if (argc < 2)
+    {
+        out << "usage: " << (argc > 0 ? argv[0] : "usage_report") << " ring_file [ring_file ...]\n";
+        return 2;
+    }
+
+    int result = 0;
+    std::vector<usage_record> records;
+    size_t skipped = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        usage_ring ring;
+        if (!ring.open(argv[i], 0)) // (capacity 0: an existing ring is not created)
+        {
+            out << argv[i] << ": can't open the ring\n";
+            result = 1;
+            continue;
+        }
+        skipped += ring.read(records);
+    }
+
+    std::vector<usage_summary> summaries;
+    summarize_usage(records, summaries);
+    for (size_t i = 0; i < summaries.size(); i++)
+    {
+        print_usage_summary(out, summaries[i], parser);
+    }
+    out << records.size() << " run(s) read";
+    if (skipped)
+    {
+        out << ", " << skipped << " skipped (being written)";
+    }
+    out << "\n";
+    return result;
+}
+
+#endif /* USAGE_RING_H_ */
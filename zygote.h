@@ -0,0 +1,662 @@
+/**
+ * @file   zygote.h
+ * @date   17 Oct 2026
+ * @brief  Resident (pre-forked) process holding the fully set-up parser. Thin clients forward
+ *         their command line and stdio to it over a Unix socket, and the zygote forks a child
+ *         that only runs the parser (and handlers). POSIX only.
+ *
+ * ___________________________
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Lukasz Forynski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZYGOTE_H_
+#define ZYGOTE_H_
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include "cmd_line_options.h"
+
+/**
+ * @brief Header of the request sent by the client. It carries (as SCM_RIGHTS) the stdin,
+ *        stdout and stderr of the client, and it's followed by the working directory of the
+ *        client and argc arguments, each stored as the length (uint32_t) and characters.
+ */
+struct zygote_request_header
+{
+    enum constants
+    {
+        request_magic = 0x5a4c4c43, // "CLLZ"
+        max_request_size = 1024 * 1024
+    };
+
+    uint32_t magic;
+    uint32_t argc;
+    uint32_t size; // of the data following this header
+};
+
+/**
+ * @brief Flags for sending data over the socket: if the other side is gone, the send
+ *        should fail (and not raise SIGPIPE, which would terminate the process).
+ */
+#ifdef MSG_NOSIGNAL
+#define ZYGOTE_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define ZYGOTE_SEND_FLAGS 0
+#endif
+
+/**
+ * @brief Helpers for the zygote (sending / receiving data over the socket).
+ */
+class zygote_io
+{
+public:
+    /**
+     * @brief Sets-up the connected socket: it's not inherited by exec'ed programs and
+     *        (where MSG_NOSIGNAL is not available) sending to it doesn't raise SIGPIPE.
+     */
+    static void setup_socket(int fd)
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+
+    /**
+     * @brief Sets the timeout for receiving (reads fail with EAGAIN once it expires).
+     */
+    static void set_receive_timeout(int fd, int milliseconds)
+    {
+        timeval t;
+        t.tv_sec = milliseconds / 1000;
+        t.tv_usec = (milliseconds % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+    }
+
+    static bool write_all(int fd, const void* data, size_t size)
+    {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            ssize_t n = send(fd, p, size, ZYGOTE_SEND_FLAGS);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool read_all(int fd, void* data, size_t size)
+    {
+        char* p = static_cast<char*>(data);
+        while (size > 0)
+        {
+            ssize_t n = read(fd, p, size);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static void append(std::vector<char>& buffer, const char* str)
+    {
+        uint32_t len = static_cast<uint32_t>(strlen(str));
+        const char* len_bytes = reinterpret_cast<const char*>(&len);
+        buffer.insert(buffer.end(), len_bytes, len_bytes + sizeof(len));
+        buffer.insert(buffer.end(), str, str + len);
+    }
+
+    static bool extract(const std::vector<char>& buffer, size_t& at, std::string& str)
+    {
+        uint32_t len = 0;
+        if (buffer.size() - at < sizeof(len))
+        {
+            return false;
+        }
+        memcpy(&len, &buffer[at], sizeof(len));
+        at += sizeof(len);
+        if (buffer.size() - at < len)
+        {
+            return false;
+        }
+        str.assign(buffer.begin() + at, buffer.begin() + at + len);
+        at += len;
+        return true;
+    }
+
+    static bool fill_address(sockaddr_un& addr, const std::string& path)
+    {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            return false;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    /**
+     * @brief Write end of the pipe the SIGCHLD handler writes to (to wake-up the zygote).
+     */
+    static int& sigchld_fd()
+    {
+        static int fd = -1;
+        return fd;
+    }
+
+    static void on_sigchld(int)
+    {
+        int saved_errno = errno;
+        char c = 0;
+        if (write(sigchld_fd(), &c, 1) < 0)
+        {
+            // pipe is full: zygote will be woken-up anyway
+        }
+        errno = saved_errno;
+    }
+};
+
+/**
+ * @brief The zygote: keeps the parser (with all options added and set-up) and serves
+ *        requests from clients (see cmd_line_zygote_call()). e.g.:
+ *
+ * @code
+ *  cmd_line_parser parser;
+ *  ... add options, set-up dependencies etc.
+ *  cmd_line_zygote zygote(parser);
+ *  if (zygote.listen("/run/my_tool.sock"))
+ *  {
+ *      zygote.serve();
+ *  }
+ * @endcode
+ *
+ *        For each request, a child is forked: it takes over stdio and the working directory
+ *        of the client, calls run() and exits with 0 if it returned true (1 otherwise),
+ *        unless a handler exits the process first. The exit status is reported back to the
+ *        client. Environment of the client is not forwarded (the child inherits it from
+ *        the zygote).
+ */
+class cmd_line_zygote
+{
+public:
+    enum constants
+    {
+        default_request_timeout_ms = 5000
+    };
+
+    cmd_line_zygote(cmd_line_parser& parser_to_use) :
+                    parser(parser_to_use),
+                    listen_fd(-1),
+                    request_timeout_ms(default_request_timeout_ms),
+                    previous_handler(SIG_DFL)
+    {
+        wakeup[0] = -1;
+        wakeup[1] = -1;
+    }
+
+    ~cmd_line_zygote()
+    {
+        close();
+    }
+
+    /**
+     * @brief Creates the socket (replacing the existing one, if any) and prepares the zygote.
+     * @return true if successful (errno is set otherwise).
+     * @throws option_error if the set-up of the parser is not valid.
+     */
+    bool listen(const std::string& path)
+    {
+        close();
+        parser.setup_check_dependencies(); // once, not in each of children
+
+        // bound to a temporary name first: the socket appears under its name (atomically)
+        // once it accepts connections.
+        std::stringstream tmp_path;
+        tmp_path << path << "." << getpid();
+        sockaddr_un addr;
+        if (!zygote_io::fill_address(addr, tmp_path.str()))
+        {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0 || pipe(wakeup) != 0)
+        {
+            close();
+            return false;
+        }
+        fcntl(listen_fd, F_SETFD, FD_CLOEXEC);
+        for (int i = 0; i < 2; i++)
+        {
+            fcntl(wakeup[i], F_SETFD, FD_CLOEXEC);
+            fcntl(wakeup[i], F_SETFL, O_NONBLOCK);
+        }
+
+        unlink(tmp_path.str().c_str());
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd, SOMAXCONN) != 0 ||
+            rename(tmp_path.str().c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp_path.str().c_str());
+            close();
+            return false;
+        }
+        socket_path = path;
+
+        zygote_io::sigchld_fd() = wakeup[1];
+        previous_handler = signal(SIGCHLD, zygote_io::on_sigchld);
+        return true;
+    }
+
+    /**
+     * @brief Sets how long the zygote waits for each part of the request, before it gives up
+     *        on the client. Requests are received one at a time, so a stalled client delays
+     *        all others by (at most) this long.
+     */
+    void set_request_timeout(int milliseconds)
+    {
+        request_timeout_ms = milliseconds;
+    }
+
+    /**
+     * @brief Serves requests.
+     * @param max_requests - number of requests to serve (0: serve until an error occurs).
+     *        Before returning, zygote waits for all children it has forked.
+     * @return false if stopped because of an error.
+     */
+    bool serve(size_t max_requests = 0)
+    {
+        size_t served = 0;
+        bool ok = listen_fd >= 0;
+        while (ok && (max_requests == 0 || served < max_requests))
+        {
+            pollfd fds[2];
+            fds[0].fd = listen_fd;
+            fds[0].events = POLLIN;
+            fds[1].fd = wakeup[0];
+            fds[1].events = POLLIN;
+            if (poll(fds, 2, -1) < 0)
+            {
+                ok = (errno == EINTR);
+                continue;
+            }
+
+            if (fds[1].revents)
+            {
+                char drain[64];
+                while (read(wakeup[0], drain, sizeof(drain)) > 0)
+                {
+                }
+                reap_children(false);
+            }
+
+            if (fds[0].revents)
+            {
+                int conn = accept(listen_fd, NULL, NULL);
+                if (conn < 0)
+                {
+                    ok = (errno == EINTR || errno == ECONNABORTED);
+                    continue;
+                }
+                zygote_io::setup_socket(conn);
+                zygote_io::set_receive_timeout(conn, request_timeout_ms);
+                handle_request(conn);
+                served++;
+            }
+        }
+        reap_children(true);
+        return ok;
+    }
+
+    /**
+     * @brief Stops the zygote (removes the socket).
+     */
+    void close()
+    {
+        if (listen_fd >= 0)
+        {
+            ::close(listen_fd);
+            listen_fd = -1;
+        }
+        if (socket_path.size())
+        {
+            unlink(socket_path.c_str());
+            socket_path.clear();
+        }
+        if (wakeup[0] >= 0)
+        {
+            signal(SIGCHLD, previous_handler);
+            zygote_io::sigchld_fd() = -1;
+            ::close(wakeup[0]);
+            ::close(wakeup[1]);
+            wakeup[0] = wakeup[1] = -1;
+        }
+    }
+
+private:
+    cmd_line_zygote(const cmd_line_zygote&);
+    cmd_line_zygote& operator=(const cmd_line_zygote&);
+
+    /**
+     * @brief Receives the request and forks the child to run it. The connection is kept
+     *        (and closed once the status of the child is sent back).
+     */
+    void handle_request(int conn)
+    {
+        int fds[3] = {-1, -1, -1};
+        zygote_request_header h;
+        std::vector<char> data;
+        if (!receive_request(conn, h, fds, data))
+        {
+            close_fds(fds);
+            ::close(conn);
+            return;
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(NULL);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            run_child(h, fds, data);
+        }
+        close_fds(fds);
+        if (pid < 0)
+        {
+            send_status(conn, -1);
+            return;
+        }
+        children[pid] = conn;
+    }
+
+    bool receive_request(int conn, zygote_request_header& h, int (&fds)[3], std::vector<char>& data)
+    {
+        char control[CMSG_SPACE(sizeof(int) * 3)];
+        memset(control, 0, sizeof(control));
+        iovec iov;
+        iov.iov_base = &h;
+        iov.iov_len = sizeof(h);
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t n;
+        do
+        {
+            n = recvmsg(conn, &msg, 0);
+        } while (n < 0 && errno == EINTR);
+
+        for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c))
+        {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS &&
+                c->cmsg_len == CMSG_LEN(sizeof(int) * 3))
+            {
+                memcpy(fds, CMSG_DATA(c), sizeof(int) * 3);
+            }
+        }
+
+        if (n <= 0 || (n < static_cast<ssize_t>(sizeof(h)) &&
+                       !zygote_io::read_all(conn, reinterpret_cast<char*>(&h) + n, sizeof(h) - n)))
+        {
+            return false;
+        }
+        if (h.magic != zygote_request_header::request_magic ||
+            h.size > zygote_request_header::max_request_size || fds[0] < 0)
+        {
+            return false;
+        }
+        data.resize(h.size);
+        return h.size == 0 || zygote_io::read_all(conn, &data[0], h.size);
+    }
+
+    /**
+     * @brief Runs in the forked child: takes over stdio / working directory of the client
+     *        and runs the parser. Never returns.
+     */
+    void run_child(const zygote_request_header& h, int (&fds)[3], const std::vector<char>& data)
+    {
+        signal(SIGCHLD, previous_handler);
+        ::close(listen_fd);
+        ::close(wakeup[0]);
+        ::close(wakeup[1]);
+        for (std::map<pid_t, int>::iterator i = children.begin(); i != children.end(); i++)
+        {
+            ::close(i->second);
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            dup2(fds[i], i);
+            if (fds[i] > 2)
+            {
+                ::close(fds[i]);
+            }
+        }
+
+        std::string cwd;
+        size_t at = 0;
+        std::vector<std::string> args(h.argc);
+        bool valid = zygote_io::extract(data, at, cwd) && chdir(cwd.c_str()) == 0;
+        std::vector<char*> argv;
+        for (uint32_t i = 0; valid && i < h.argc; i++)
+        {
+            valid = zygote_io::extract(data, at, args[i]);
+            argv.push_back(const_cast<char*>(args[i].c_str()));
+        }
+        argv.push_back(NULL);
+
+        int status = 1;
+        if (valid)
+        {
+            try
+            {
+                status = parser.run(static_cast<int>(h.argc), &argv[0]) ? 0 : 1;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(NULL);
+        _exit(status);
+    }
+
+    /**
+     * @brief Reports status of children that finished to their clients.
+     * @param wait_for_all - if true, waits for all of them.
+     */
+    void reap_children(bool wait_for_all)
+    {
+        while (children.size())
+        {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, wait_for_all ? 0 : WNOHANG);
+            if (pid < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (pid <= 0)
+            {
+                break;
+            }
+            std::map<pid_t, int>::iterator child = children.find(pid);
+            if (child != children.end())
+            {
+                int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+                send_status(child->second, exit_code);
+                children.erase(child);
+            }
+        }
+    }
+
+    static void send_status(int conn, int32_t status)
+    {
+        zygote_io::write_all(conn, &status, sizeof(status));
+        ::close(conn);
+    }
+
+    static void close_fds(int (&fds)[3])
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (fds[i] >= 0)
+            {
+                ::close(fds[i]);
+                fds[i] = -1;
+            }
+        }
+    }
+
+    cmd_line_parser& parser;
+    int listen_fd;
+    int request_timeout_ms;
+    int wakeup[2];
+    std::string socket_path;
+    std::map<pid_t, int> children; // connection of each child
+    void (*previous_handler)(int);
+};
+
+/**
+ * @brief Client: forwards the command line (and stdio) to the zygote and waits for the result.
+ * @param socket_path - location of the zygote's socket.
+ * @param argc, argv - command line to run (as passed to main()).
+ * @param stdio - file descriptors to use as stdin, stdout and stderr of the run
+ *        (NULL: use 0, 1 and 2).
+ * @return exit status of the run, or -1 if the zygote is not available (in which case the
+ *         program could fall back to running the parser itself).
+ */
+inline int cmd_line_zygote_call(const std::string& socket_path, int argc, char* const argv[],
+                                const int* stdio = NULL)
+{
+    static const int std_fds[3] = {0, 1, 2};
+    const int* fds = stdio ? stdio : std_fds;
+    sockaddr_un addr;
+    if (argc < 1 || argv == NULL || !zygote_io::fill_address(addr, socket_path))
+    {
+        return -1;
+    }
+
+    std::vector<char> data;
+    char cwd[4096];
+    zygote_io::append(data, getcwd(cwd, sizeof(cwd)) ? cwd : "/");
+    for (int i = 0; i < argc; i++)
+    {
+        zygote_io::append(data, argv[i]);
+    }
+
+    int conn = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (conn < 0)
+    {
+        return -1;
+    }
+    zygote_io::setup_socket(conn);
+    if (connect(conn, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        ::close(conn);
+        return -1;
+    }
+
+    zygote_request_header h;
+    h.magic = zygote_request_header::request_magic;
+    h.argc = static_cast<uint32_t>(argc);
+    h.size = static_cast<uint32_t>(data.size());
+
+    char control[CMSG_SPACE(sizeof(int) * 3)];
+    memset(control, 0, sizeof(control));
+    iovec iov;
+    iov.iov_base = &h;
+    iov.iov_len = sizeof(h);
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int) * 3);
+    memcpy(CMSG_DATA(c), fds, sizeof(int) * 3);
+
+    ssize_t n;
+    do
+    {
+        n = sendmsg(conn, &msg, ZYGOTE_SEND_FLAGS);
+    } while (n < 0 && errno == EINTR);
+
+    int32_t status = -1;
+    if (n != static_cast<ssize_t>(sizeof(h)) ||
+        !zygote_io::write_all(conn, &data[0], data.size()) ||
+        !zygote_io::read_all(conn, &status, sizeof(status)))
+    {
+        status = -1;
+    }
+    ::close(conn);
+    return status;
+}
+
+#endif /* __unix__ || __APPLE__ */
+
+#endif /* ZYGOTE_H_ */